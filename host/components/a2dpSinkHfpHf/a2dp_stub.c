@@ -0,0 +1,45 @@
+/*
+ * a2dpSinkHfpHf Stub
+ * No Bluetooth on the host: commands succeed, callbacks are kept
+ */
+
+#include "a2dpSinkHfpHf.h"
+
+static bt_volume_config_t g_volume_config;
+
+esp_err_t a2dpSinkHfpHf_init(void *config) { return ESP_OK; }
+
+esp_err_t bt_volume_control_init(const bt_volume_config_t *config)
+{
+    if (!config) return ESP_ERR_INVALID_ARG;
+    g_volume_config = *config;
+    return ESP_OK;
+}
+
+esp_err_t a2dpSinkHfpHf_set_a2dp_volume(uint8_t volume) { return ESP_OK; }
+esp_err_t a2dpSinkHfpHf_set_hfp_speaker_volume(uint8_t volume) { return ESP_OK; }
+esp_err_t a2dpSinkHfpHf_set_hfp_mic_volume(uint8_t volume) { return ESP_OK; }
+
+esp_err_t a2dpSinkHfpHf_avrc_play(void) { return ESP_OK; }
+esp_err_t a2dpSinkHfpHf_avrc_pause(void) { return ESP_OK; }
+esp_err_t a2dpSinkHfpHf_avrc_next(void) { return ESP_OK; }
+esp_err_t a2dpSinkHfpHf_avrc_prev(void) { return ESP_OK; }
+
+esp_err_t a2dpSinkHfpHf_answer_call(void) { return ESP_OK; }
+esp_err_t a2dpSinkHfpHf_hangup_call(void) { return ESP_OK; }
+esp_err_t a2dpSinkHfpHf_start_voice_recognition(void) { return ESP_OK; }
+esp_err_t a2dpSinkHfpHf_stop_voice_recognition(void) { return ESP_OK; }
+
+void a2dp_sink_hfp_hf_register_connection_cb(void (*cb)(bool connected, const uint8_t *addr)) {}
+void a2dp_sink_hfp_hf_register_audio_state_cb(void (*cb)(bool streaming)) {}
+void a2dp_sink_hfp_hf_register_call_state_cb(void (*cb)(bool active, int state)) {}
+void a2dpSinkHfpHf_register_avrc_metadata_callback(void (*cb)(const bt_avrc_metadata_t *metadata)) {}
+void a2dp_sink_hfp_hf_register_pcm_cb(void (*cb)(int16_t *pcm, size_t frames)) {}
+void a2dp_sink_hfp_hf_register_audio_cfg_cb(void (*cb)(uint32_t sample_rate)) {}
+
+void a2dp_stub_volume_changed(bt_volume_target_t target, uint8_t volume)
+{
+    if (g_volume_config.on_volume_change) {
+        g_volume_config.on_volume_change(target, volume);
+    }
+}
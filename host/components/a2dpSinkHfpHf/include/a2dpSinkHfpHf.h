@@ -0,0 +1,69 @@
+#ifndef A2DP_SINK_HFP_HF_H
+#define A2DP_SINK_HFP_HF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The part of the a2dpSinkHfpHf API the firmware uses, same signatures
+
+typedef enum {
+    BT_VOLUME_TARGET_A2DP,
+    BT_VOLUME_TARGET_HFP_SPEAKER,
+    BT_VOLUME_TARGET_HFP_MIC
+} bt_volume_target_t;
+
+typedef struct {
+    uint8_t default_a2dp_volume;
+    uint8_t default_hfp_speaker_volume;
+    uint8_t default_hfp_mic_volume;
+    void (*on_volume_change)(bt_volume_target_t target, uint8_t new_volume);
+} bt_volume_config_t;
+
+typedef struct {
+    char title[256];
+    char artist[256];
+    char album[256];
+} bt_avrc_metadata_t;
+
+esp_err_t a2dpSinkHfpHf_init(void *config);
+esp_err_t bt_volume_control_init(const bt_volume_config_t *config);
+
+esp_err_t a2dpSinkHfpHf_set_a2dp_volume(uint8_t volume);
+esp_err_t a2dpSinkHfpHf_set_hfp_speaker_volume(uint8_t volume);
+esp_err_t a2dpSinkHfpHf_set_hfp_mic_volume(uint8_t volume);
+
+esp_err_t a2dpSinkHfpHf_avrc_play(void);
+esp_err_t a2dpSinkHfpHf_avrc_pause(void);
+esp_err_t a2dpSinkHfpHf_avrc_next(void);
+esp_err_t a2dpSinkHfpHf_avrc_prev(void);
+
+esp_err_t a2dpSinkHfpHf_answer_call(void);
+esp_err_t a2dpSinkHfpHf_hangup_call(void);
+esp_err_t a2dpSinkHfpHf_start_voice_recognition(void);
+esp_err_t a2dpSinkHfpHf_stop_voice_recognition(void);
+
+void a2dp_sink_hfp_hf_register_connection_cb(void (*cb)(bool connected, const uint8_t *addr));
+void a2dp_sink_hfp_hf_register_audio_state_cb(void (*cb)(bool streaming));
+void a2dp_sink_hfp_hf_register_call_state_cb(void (*cb)(bool active, int state));
+void a2dpSinkHfpHf_register_avrc_metadata_callback(void (*cb)(const bt_avrc_metadata_t *metadata));
+void a2dp_sink_hfp_hf_register_pcm_cb(void (*cb)(int16_t *pcm, size_t frames));
+void a2dp_sink_hfp_hf_register_audio_cfg_cb(void (*cb)(uint32_t sample_rate));
+
+/**
+ * @brief Host only: report a volume change from the phone
+ * Calls the on_volume_change callback given to bt_volume_control_init(),
+ * as the AVRC/HFP volume events would. No-op before that.
+ */
+void a2dp_stub_volume_changed(bt_volume_target_t target, uint8_t volume);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // A2DP_SINK_HFP_HF_H
@@ -0,0 +1,134 @@
+/*
+ * esp_timer Stub
+ * Virtual clock and timer list for deterministic host runs
+ */
+
+#include "esp_timer.h"
+#include "host_clock.h"
+#include <stdlib.h>
+
+#define HOST_TIMERS_MAX     32
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    int64_t deadline;           // Virtual us, -1 = idle
+    uint64_t period;            // 0 = one-shot
+};
+
+static struct esp_timer *g_timers[HOST_TIMERS_MAX];
+static int64_t g_now = 0;       // Read from any task, written by the advancing one
+
+// ============================================================================
+// ESP_TIMER API
+// ============================================================================
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle) return ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < HOST_TIMERS_MAX; i++) {
+        if (g_timers[i]) continue;
+        struct esp_timer *t = calloc(1, sizeof(*t));
+        if (!t) return ESP_ERR_NO_MEM;
+        t->callback = create_args->callback;
+        t->arg = create_args->arg;
+        t->deadline = -1;
+        g_timers[i] = t;
+        *out_handle = t;
+        return ESP_OK;
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->deadline >= 0) return ESP_ERR_INVALID_STATE;
+    timer->deadline = esp_timer_get_time() + (int64_t)timeout_us;
+    timer->period = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    esp_err_t err = esp_timer_start_once(timer, period);
+    if (err == ESP_OK) timer->period = period;
+    return err;
+}
+
+esp_err_t esp_timer_restart(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->deadline < 0) return ESP_ERR_INVALID_STATE;
+    timer->deadline = esp_timer_get_time() + (int64_t)timeout_us;
+    if (timer->period) timer->period = timeout_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->deadline < 0) return ESP_ERR_INVALID_STATE;
+    timer->deadline = -1;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->deadline >= 0) return ESP_ERR_INVALID_STATE;
+    for (int i = 0; i < HOST_TIMERS_MAX; i++) {
+        if (g_timers[i] == timer) g_timers[i] = NULL;
+    }
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer && timer->deadline >= 0;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return __atomic_load_n(&g_now, __ATOMIC_RELAXED);
+}
+
+// ============================================================================
+// HOST CLOCK
+// ============================================================================
+
+static struct esp_timer *next_due(int64_t until)
+{
+    struct esp_timer *next = NULL;
+    for (int i = 0; i < HOST_TIMERS_MAX; i++) {
+        struct esp_timer *t = g_timers[i];
+        if (t && t->deadline >= 0 && t->deadline <= until &&
+            (!next || t->deadline < next->deadline)) {
+            next = t;
+        }
+    }
+    return next;
+}
+
+unsigned host_clock_advance(int64_t us)
+{
+    int64_t until = esp_timer_get_time() + (us > 0 ? us : 0);
+    unsigned fired = 0;
+    struct esp_timer *t;
+    // Ties go to the lower slot, i.e. the timer created first
+    while ((t = next_due(until)) != NULL) {
+        __atomic_store_n(&g_now, t->deadline, __ATOMIC_RELAXED);
+        t->deadline = t->period ? t->deadline + (int64_t)t->period : -1;
+        t->callback(t->arg);
+        fired++;
+    }
+    __atomic_store_n(&g_now, until, __ATOMIC_RELAXED);
+    return fired;
+}
+
+int64_t host_clock_next_deadline(void)
+{
+    struct esp_timer *t = next_due(INT64_MAX);
+    return t ? t->deadline : -1;
+}
@@ -0,0 +1,28 @@
+#ifndef HOST_CLOCK_H
+#define HOST_CLOCK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Move virtual time forward, firing every timer that falls due
+ * Timers fire in deadline order on the calling task, each with the clock
+ * set to its own deadline, as the esp_timer task would have run them.
+ * @param us Microseconds to advance
+ * @return Number of timer callbacks run
+ */
+unsigned host_clock_advance(int64_t us);
+
+/**
+ * @brief Deadline of the next armed timer, or -1 if none is armed
+ */
+int64_t host_clock_next_deadline(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_CLOCK_H
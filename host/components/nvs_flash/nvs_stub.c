@@ -0,0 +1,316 @@
+/*
+ * NVS Stub
+ * Key-value store in RAM with the nvs_flash API, for the host build
+ */
+
+#include "nvs_flash.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NVS_STUB_ENTRIES    256
+#define NVS_STUB_HANDLES    16
+
+typedef struct {
+    bool used;
+    char ns[NVS_NS_NAME_MAX_SIZE];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    nvs_type_t type;
+    size_t len;
+    uint8_t *data;
+} nvs_stub_entry_t;
+
+typedef struct {
+    bool open;
+    bool writable;
+    char ns[NVS_NS_NAME_MAX_SIZE];
+} nvs_stub_handle_t;
+
+struct nvs_opaque_iterator_t {
+    char ns[NVS_NS_NAME_MAX_SIZE];
+    nvs_type_t type;
+    int index;                  // Entry the iterator is on
+};
+
+static nvs_stub_entry_t g_entries[NVS_STUB_ENTRIES];
+static nvs_stub_handle_t g_handles[NVS_STUB_HANDLES];
+static bool g_initialized = false;
+static uint32_t g_commits = 0;
+static esp_err_t g_write_error = ESP_OK;
+
+// ============================================================================
+// ENTRIES
+// ============================================================================
+
+static nvs_stub_handle_t *get_handle(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > NVS_STUB_HANDLES || !g_handles[handle - 1].open) {
+        return NULL;
+    }
+    return &g_handles[handle - 1];
+}
+
+static nvs_stub_entry_t *find_entry(const char *ns, const char *key)
+{
+    for (int i = 0; i < NVS_STUB_ENTRIES; i++) {
+        if (g_entries[i].used && strcmp(g_entries[i].ns, ns) == 0 &&
+            strcmp(g_entries[i].key, key) == 0) {
+            return &g_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t set_value(nvs_handle_t handle, const char *key, nvs_type_t type,
+                           const void *value, size_t len)
+{
+    nvs_stub_handle_t *h = get_handle(handle);
+    if (!h) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!h->writable) return ESP_ERR_NVS_READ_ONLY;
+    if (!key || strlen(key) >= NVS_KEY_NAME_MAX_SIZE) return ESP_ERR_NVS_KEY_TOO_LONG;
+    if (g_write_error != ESP_OK) return g_write_error;
+
+    nvs_stub_entry_t *e = find_entry(h->ns, key);
+    if (!e) {
+        for (int i = 0; i < NVS_STUB_ENTRIES && !e; i++) {
+            if (!g_entries[i].used) e = &g_entries[i];
+        }
+        if (!e) return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        memset(e, 0, sizeof(*e));
+        strcpy(e->ns, h->ns);
+        strcpy(e->key, key);
+    }
+    uint8_t *data = malloc(len ? len : 1);
+    if (!data) return ESP_ERR_NO_MEM;
+    memcpy(data, value, len);
+    free(e->data);
+    e->data = data;
+    e->len = len;
+    e->type = type;
+    e->used = true;
+    return ESP_OK;
+}
+
+static esp_err_t get_value(nvs_handle_t handle, const char *key, nvs_type_t type,
+                           nvs_stub_entry_t **out)
+{
+    nvs_stub_handle_t *h = get_handle(handle);
+    if (!h) return ESP_ERR_NVS_INVALID_HANDLE;
+    nvs_stub_entry_t *e = find_entry(h->ns, key);
+    if (!e) return ESP_ERR_NVS_NOT_FOUND;
+    if (e->type != type) return ESP_ERR_NVS_TYPE_MISMATCH;
+    *out = e;
+    return ESP_OK;
+}
+
+// ============================================================================
+// NVS API
+// ============================================================================
+
+esp_err_t nvs_flash_init(void)
+{
+    g_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_deinit(void)
+{
+    g_initialized = false;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    nvs_stub_clear();
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (!g_initialized) return ESP_ERR_NVS_NOT_INITIALIZED;
+    if (!namespace_name || strlen(namespace_name) >= NVS_NS_NAME_MAX_SIZE) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    for (int i = 0; i < NVS_STUB_HANDLES; i++) {
+        if (g_handles[i].open) continue;
+        g_handles[i].open = true;
+        g_handles[i].writable = open_mode == NVS_READWRITE;
+        strcpy(g_handles[i].ns, namespace_name);
+        *out_handle = (nvs_handle_t)(i + 1);
+        return ESP_OK;
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    nvs_stub_handle_t *h = get_handle(handle);
+    if (h) h->open = false;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    if (!get_handle(handle)) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (g_write_error != ESP_OK) return g_write_error;
+    g_commits++;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value)
+{
+    return set_value(handle, key, NVS_TYPE_U8, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+    return set_value(handle, key, NVS_TYPE_U32, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return set_value(handle, key, NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out_value)
+{
+    nvs_stub_entry_t *e;
+    esp_err_t err = get_value(handle, key, NVS_TYPE_U8, &e);
+    if (err == ESP_OK) memcpy(out_value, e->data, sizeof(*out_value));
+    return err;
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value)
+{
+    nvs_stub_entry_t *e;
+    esp_err_t err = get_value(handle, key, NVS_TYPE_U32, &e);
+    if (err == ESP_OK) memcpy(out_value, e->data, sizeof(*out_value));
+    return err;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    nvs_stub_entry_t *e;
+    esp_err_t err = get_value(handle, key, NVS_TYPE_BLOB, &e);
+    if (err != ESP_OK) return err;
+    if (!out_value) {
+        *length = e->len;
+        return ESP_OK;
+    }
+    if (*length < e->len) {
+        *length = e->len;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, e->data, e->len);
+    *length = e->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    nvs_stub_handle_t *h = get_handle(handle);
+    if (!h) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!h->writable) return ESP_ERR_NVS_READ_ONLY;
+    nvs_stub_entry_t *e = find_entry(h->ns, key);
+    if (!e) return ESP_ERR_NVS_NOT_FOUND;
+    free(e->data);
+    memset(e, 0, sizeof(*e));
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    nvs_stub_handle_t *h = get_handle(handle);
+    if (!h) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!h->writable) return ESP_ERR_NVS_READ_ONLY;
+    for (int i = 0; i < NVS_STUB_ENTRIES; i++) {
+        if (g_entries[i].used && strcmp(g_entries[i].ns, h->ns) == 0) {
+            free(g_entries[i].data);
+            memset(&g_entries[i], 0, sizeof(g_entries[i]));
+        }
+    }
+    return ESP_OK;
+}
+
+// ============================================================================
+// ITERATORS
+// ============================================================================
+
+static bool iterator_matches(const nvs_iterator_t it, int index)
+{
+    const nvs_stub_entry_t *e = &g_entries[index];
+    return e->used && (!it->ns[0] || strcmp(e->ns, it->ns) == 0) &&
+           (it->type == NVS_TYPE_ANY || e->type == it->type);
+}
+
+// Move to the next matching entry at or after start; frees the iterator at the end
+static esp_err_t iterator_seek(nvs_iterator_t *iterator, int start)
+{
+    for (int i = start; i < NVS_STUB_ENTRIES; i++) {
+        if (iterator_matches(*iterator, i)) {
+            (*iterator)->index = i;
+            return ESP_OK;
+        }
+    }
+    free(*iterator);
+    *iterator = NULL;
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_entry_find(const char *part_name, const char *namespace_name,
+                         nvs_type_t type, nvs_iterator_t *output_iterator)
+{
+    *output_iterator = NULL;
+    if (!g_initialized) return ESP_ERR_NVS_NOT_INITIALIZED;
+    nvs_iterator_t it = calloc(1, sizeof(*it));
+    if (!it) return ESP_ERR_NO_MEM;
+    if (namespace_name) {
+        strncpy(it->ns, namespace_name, sizeof(it->ns) - 1);
+    }
+    it->type = type;
+    *output_iterator = it;
+    return iterator_seek(output_iterator, 0);
+}
+
+esp_err_t nvs_entry_next(nvs_iterator_t *iterator)
+{
+    if (!iterator || !*iterator) return ESP_ERR_INVALID_ARG;
+    return iterator_seek(iterator, (*iterator)->index + 1);
+}
+
+esp_err_t nvs_entry_info(const nvs_iterator_t iterator, nvs_entry_info_t *out_info)
+{
+    if (!iterator) return ESP_ERR_INVALID_ARG;
+    const nvs_stub_entry_t *e = &g_entries[iterator->index];
+    memset(out_info, 0, sizeof(*out_info));
+    strcpy(out_info->namespace_name, e->ns);
+    strcpy(out_info->key, e->key);
+    out_info->type = e->type;
+    return ESP_OK;
+}
+
+void nvs_release_iterator(nvs_iterator_t iterator)
+{
+    free(iterator);
+}
+
+// ============================================================================
+// HOST CONTROLS
+// ============================================================================
+
+uint32_t nvs_stub_commit_count(void)
+{
+    return g_commits;
+}
+
+void nvs_stub_fail_writes(esp_err_t err)
+{
+    g_write_error = err;
+}
+
+void nvs_stub_clear(void)
+{
+    for (int i = 0; i < NVS_STUB_ENTRIES; i++) {
+        free(g_entries[i].data);
+    }
+    memset(g_entries, 0, sizeof(g_entries));
+    g_commits = 0;
+}
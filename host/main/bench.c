@@ -0,0 +1,91 @@
+/*
+ * Host Harness
+ * State machine bring-up and virtual-time driving shared by the benchmarks
+ */
+
+#include "bench.h"
+#include "host_clock.h"
+#include "nvs_flash.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <time.h>
+
+#define TAG "HOST"
+
+static display_callback_t g_display_sink = NULL;
+static void (*g_mode_sink)(stereo_mode_t old_mode, stereo_mode_t new_mode) = NULL;
+
+int64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void display_forward(display_notification_t notification)
+{
+    if (g_display_sink) g_display_sink(notification);
+}
+
+static void mode_forward(stereo_mode_t old_mode, stereo_mode_t new_mode)
+{
+    if (g_mode_sink) g_mode_sink(old_mode, new_mode);
+}
+
+void host_set_sinks(display_callback_t display,
+                    void (*on_mode_change)(stereo_mode_t old_mode, stereo_mode_t new_mode))
+{
+    g_display_sink = display;
+    g_mode_sink = on_mode_change;
+}
+
+esp_err_t host_stereo_init(void)
+{
+    esp_err_t err = nvs_flash_init();
+    if (err != ESP_OK) return err;
+
+    // No tuner: the station index stays empty and starts no scan task
+    stereo_config_t config = {
+        .display_handler = display_forward,
+        .on_mode_change = mode_forward,
+    };
+    err = stereo_state_init(&config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "State machine init failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    host_run();
+    return ESP_OK;
+}
+
+size_t host_run(void)
+{
+    return stereo_state_host_drain();
+}
+
+void host_advance_ms(uint32_t ms)
+{
+    int64_t until = esp_timer_get_time() + (int64_t)ms * 1000;
+    int64_t next;
+    while ((next = host_clock_next_deadline()) >= 0 && next <= until) {
+        host_clock_advance(next - esp_timer_get_time());
+        host_run();
+    }
+    host_clock_advance(until - esp_timer_get_time());
+    host_run();
+}
+
+void host_button(button_id_t button, button_event_type_t event, uint8_t detents)
+{
+    int64_t now = esp_timer_get_time();
+    button_event_t e = {
+        .button = button,
+        .event = event,
+        .timestamp = (uint32_t)(now / 1000),
+        .origin_us = (uint32_t)now,
+        .detents = detents,
+        .steps = detents,
+        .velocity = 0,
+    };
+    stereo_state_handle_button(e);
+}
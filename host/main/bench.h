@@ -0,0 +1,64 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "buttons.h"
+#include "car_stereo_state.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Host monotonic clock in nanoseconds, for timing benchmark loops
+ * Real time, unlike esp_timer_get_time(), which is the virtual clock.
+ */
+int64_t bench_now_ns(void);
+
+/**
+ * @brief Bring up NVS and the state machine on the calling task
+ * Call once; every benchmark and the replay share the one state machine.
+ * Notifications and mode changes go to the sinks set below.
+ * @return ESP_OK on success
+ */
+esp_err_t host_stereo_init(void);
+
+/**
+ * @brief Route display notifications and mode changes (NULL = drop)
+ */
+void host_set_sinks(display_callback_t display,
+                    void (*on_mode_change)(stereo_mode_t old_mode, stereo_mode_t new_mode));
+
+/**
+ * @brief Dispatch everything queued for the state machine
+ * @return Events dispatched
+ */
+size_t host_run(void);
+
+/**
+ * @brief Advance virtual time, dispatching after every timer that fires
+ * A timer only posts an event; draining in between lets the handler arm
+ * the next one inside the same window, as it would on the device.
+ */
+void host_advance_ms(uint32_t ms);
+
+/**
+ * @brief Post a button event with its origin at the current virtual time
+ * @param detents Rotary detents folded into the event (1 for buttons)
+ */
+void host_button(button_id_t button, button_event_type_t event, uint8_t detents);
+
+// Benchmarks and the replay runner, one file each
+void bench_sanitize(void);
+void bench_state(void);
+void bench_display(void);
+void bench_dsp(void);
+int replay_run(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_H
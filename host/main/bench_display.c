@@ -0,0 +1,121 @@
+/*
+ * Display Benchmark
+ * I2C bytes per redraw for the screens the state machine drives most
+ */
+
+#include "bench.h"
+#include "display.h"
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DISPLAY_SETTLE_MS   3200    // Splash plus a frame
+#define DISPLAY_DRAIN_MS    500     // Last redraw of a scenario goes out
+#define MARQUEE_START_MS    2200    // First frame plus the hold at the start
+#define MARQUEE_STEPS       10
+#define MARQUEE_STEP_MS     350     // As display.c scrolls
+
+// The display task runs on real FreeRTOS ticks: move both clocks together
+static void step_ms(uint32_t ms)
+{
+    host_advance_ms(ms);
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+static void scenario(const char *name, void (*fn)(int i), int count, uint32_t gap_ms)
+{
+    display_stats_t before, after;
+    display_get_stats(&before);
+    uint32_t bus = i2c_stub_bytes();
+
+    for (int i = 0; i < count; i++) {
+        fn(i);
+        host_run();
+        step_ms(gap_ms);
+    }
+    step_ms(DISPLAY_DRAIN_MS);
+
+    display_get_stats(&after);
+    uint32_t redraws = after.redraws - before.redraws;
+    uint32_t bytes = after.i2c_bytes - before.i2c_bytes;
+    printf("display %-8s %3d events: %3u redraws, %5u bytes, %.1f bytes/redraw (max so far %u), "
+           "bus %u\n", name, count, (unsigned)redraws, (unsigned)bytes,
+           redraws ? (double)bytes / redraws : 0.0, after.redraw_bytes_max,
+           (unsigned)(i2c_stub_bytes() - bus));
+}
+
+static void ev_knob(int i)
+{
+    host_button(BTN_ROTARY, BTN_EVENT_ROTARY_CW, 1);
+}
+
+static void ev_track(int i)
+{
+    static const char *const tracks[][2] = {
+        { "Blinding Lights", "The Weeknd" },
+        { "Don’t Stop Me Now – Remastered 2011", "Queen" },
+        { "Déjà Vu", "Beyoncé" },
+        { "Hoppípolla", "Sigur Rós" },
+    };
+    stereo_state_a2dp_metadata(tracks[i % 4][0], tracks[i % 4][1], NULL);
+}
+
+// Steady-state cost of one scroll step for a long track title over a
+// 10-character artist line: up to 36 characters the title is scrolled by
+// the controller's display shift, beyond that in software
+static void marquee(const char *name, const char *title)
+{
+    display_notification_t n = {
+        .type = DISPLAY_BT_TRACK,
+        .duration_ms = 15000,
+        .priority = 80,
+    };
+    strncpy(n.text, title, sizeof(n.text) - 1);
+    strncpy(n.subtext, "The Weeknd", sizeof(n.subtext) - 1);
+    display_handle_notification(n);
+    step_ms(MARQUEE_START_MS);
+
+    display_stats_t before, after;
+    display_get_stats(&before);
+    step_ms(MARQUEE_STEPS * MARQUEE_STEP_MS);
+    display_get_stats(&after);
+
+    uint32_t steps = after.redraws - before.redraws;
+    uint32_t bytes = after.i2c_bytes - before.i2c_bytes;
+    printf("marquee %-8s %2u chars: %2u steps, %.1f bytes/step\n", name, (unsigned)strlen(title),
+           (unsigned)steps, steps ? (double)bytes / steps : 0.0);
+    step_ms(15000 - MARQUEE_START_MS - MARQUEE_STEPS * MARQUEE_STEP_MS + DISPLAY_DRAIN_MS);
+}
+
+void bench_display(void)
+{
+    static const uint8_t phone[6] = { 0x02, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+    if (display_init() != ESP_OK) {
+        printf("display: init failed\n");
+        return;
+    }
+    host_set_sinks(display_handle_notification, NULL);
+    stereo_state_set_mode(MODE_RADIO);
+    host_run();
+    step_ms(DISPLAY_SETTLE_MS);
+
+    scenario("tuning", ev_knob, 40, 60);
+
+    stereo_state_bt_device_connected(phone);
+    stereo_state_set_mode(MODE_BLUETOOTH);
+    host_run();
+    step_ms(2500);              // "Connected" banners time out
+
+    scenario("volume", ev_knob, 40, 60);
+    scenario("tracks", ev_track, 12, 1000);
+    marquee("shift", "Save Your Tears (Remix) - Ariana");
+    marquee("software", "Save Your Tears (Remix) with Ariana Grande - Radio Edit");
+
+    host_set_sinks(NULL, NULL);
+    stereo_state_bt_device_disconnected(phone);
+    host_run();
+    step_ms(DISPLAY_DRAIN_MS);
+}
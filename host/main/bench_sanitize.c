@@ -0,0 +1,103 @@
+/*
+ * Sanitize Benchmark
+ * sanitize_for_lcd() throughput over AVRCP metadata as phones send it
+ */
+
+#include "bench.h"
+#include "display.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SANITIZE_ROUNDS     20000
+#define SANITIZE_OUT_LEN    128     // Notification text field
+
+// Title / artist / album fields captured from Spotify, Apple Music and
+// YouTube Music over AVRCP: accents, typographic quotes and dashes,
+// remaster trailers, emoji and scripts the glass cannot show
+static const char *const g_corpus[] = {
+    "Bohemian Rhapsody - Remastered 2011",
+    "Queen",
+    "A Night At The Opera (2011 Remaster)",
+    "Déjà Vu",
+    "Beyoncé",
+    "Café Del Mar – Volumen Uno",
+    "Björk",
+    "Jóga",
+    "Sigur Rós",
+    "Hoppípolla",
+    "Motörhead",
+    "Ace of Spades – 40th Anniversary Edition",
+    "Don’t Stop Me Now – Remastered 2011",
+    "“Heroes” - 2017 Remaster",
+    "David Bowie",
+    "Françoise Hardy",
+    "Tous les garçons et les filles",
+    "Zaz — Je veux",
+    "Herbert Grönemeyer",
+    "Männer",
+    "Mañana Será Bonito",
+    "KAROL G",
+    "Despacito (feat. Daddy Yankee)",
+    "Luis Fonsi",
+    "Blinding Lights",
+    "The Weeknd",
+    "After Hours…",
+    "Shape of You ♫",
+    "Ed Sheeran",
+    "÷ (Deluxe)",
+    "Lose Yourself - From \"8 Mile\" Soundtrack",
+    "Eminem",
+    "Smells Like Teen Spirit - Remastered 2021",
+    "Nirvana",
+    "Nevermind (30th Anniversary Super Deluxe)",
+    "Dancing Queen 🕺",
+    "ABBA",
+    "Røyksopp",
+    "Eple",
+    "Dvořák: Symphony No. 9 in E Minor, Op. 95 \"From the New World\": IV. Allegro con fuoco",
+    "Berliner Philharmoniker • Herbert von Karajan",
+    "紅蓮華",
+    "LiSA",
+    "Gangnam Style (강남스타일)",
+    "PSY",
+    "Ça plane pour moi",
+    "Plastic Bertrand",
+    "Łzy – Agnieszka",
+    "Stromae",
+    "Papaoutai",
+    "Ik Neem Je Mee",
+    "Gerard Joling",
+    "Zij Gelooft In Mij – Live in Ahoy’ 1998",
+    "André Hazes",
+    "Podcast: Episode 212 — “What’s next?” 🎙️",
+    "",
+};
+
+#define CORPUS_LEN  (sizeof(g_corpus) / sizeof(g_corpus[0]))
+
+void bench_sanitize(void)
+{
+    char out[SANITIZE_OUT_LEN];
+    size_t bytes = 0;
+    for (size_t i = 0; i < CORPUS_LEN; i++) {
+        bytes += strlen(g_corpus[i]);
+    }
+
+    // One untimed round warms the caches and the lookup tables
+    for (size_t i = 0; i < CORPUS_LEN; i++) {
+        sanitize_for_lcd(out, g_corpus[i], sizeof(out));
+    }
+
+    int64_t start = bench_now_ns();
+    for (int round = 0; round < SANITIZE_ROUNDS; round++) {
+        for (size_t i = 0; i < CORPUS_LEN; i++) {
+            sanitize_for_lcd(out, g_corpus[i], sizeof(out));
+        }
+    }
+    int64_t took = bench_now_ns() - start;
+
+    double total = (double)bytes * SANITIZE_ROUNDS;
+    printf("sanitize: %u strings, %u bytes: %.1f MB/s, %.0f ns/string\n",
+           (unsigned)CORPUS_LEN, (unsigned)bytes, total * 1000.0 / (double)took,
+           (double)took / ((double)CORPUS_LEN * SANITIZE_ROUNDS));
+}
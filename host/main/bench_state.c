@@ -0,0 +1,104 @@
+/*
+ * State Dispatch Benchmark
+ * Host cost of one state event, end to end through the queue, per class
+ */
+
+#include "bench.h"
+#include "nvs.h"
+#include <stdio.h>
+
+#define STATE_ROUNDS        2000
+#define STATE_GAP_MS        80      // Virtual time between events, like a brisk hand
+
+typedef void (*bench_event_fn)(int i);
+
+static void ev_rotary(int i)
+{
+    host_button(BTN_ROTARY, (i / 8) % 2 ? BTN_EVENT_ROTARY_CCW : BTN_EVENT_ROTARY_CW, 1);
+}
+
+static void ev_seek(int i)
+{
+    host_button(i % 2 ? BTN_DOWN : BTN_UP, BTN_EVENT_RELEASE, 1);
+}
+
+static void ev_rds(int i)
+{
+    static const char *const songs[] = {
+        "Now: Dua Lipa - Houdini", "Coldplay - Fix You", "Next: Traffic & Weather",
+    };
+    stereo_state_rds_update("RADIO538", songs[i % 3]);
+}
+
+static void ev_metadata(int i)
+{
+    // Phones send title, then artist, then album as separate updates
+    static const char *const titles[] = {
+        "Don’t Stop Me Now – Remastered 2011", "Blinding Lights", "Déjà Vu",
+    };
+    switch (i % 3) {
+        case 0: stereo_state_a2dp_metadata(titles[(i / 3) % 3], NULL, NULL); break;
+        case 1: stereo_state_a2dp_metadata(NULL, "Queen", NULL); break;
+        default: stereo_state_a2dp_metadata(NULL, NULL, "Jazz (2011 Remaster)"); break;
+    }
+}
+
+static void ev_track(int i)
+{
+    host_button(i % 2 ? BTN_DOWN : BTN_UP, BTN_EVENT_RELEASE, 1);
+}
+
+// Post one event at a time and dispatch it: the queue holds 16, and this
+// is the pace the state task sees in the car. Only post + dispatch are
+// timed; the virtual gap in between runs the debounce timers untimed.
+static void run_class(const char *name, bench_event_fn fn)
+{
+    stereo_state_stats_t before, after;
+    stereo_state_get_stats(&before);
+    uint32_t commits = nvs_stub_commit_count();
+    int64_t busy = 0;
+    int64_t worst = 0;
+
+    for (int i = 0; i < STATE_ROUNDS; i++) {
+        int64_t start = bench_now_ns();
+        fn(i);
+        host_run();
+        int64_t took = bench_now_ns() - start;
+        busy += took;
+        if (took > worst) worst = took;
+        host_advance_ms(STATE_GAP_MS);
+    }
+    host_advance_ms(10000);     // Let the write-behind land
+
+    stereo_state_get_stats(&after);
+    uint32_t events = after.events - before.events;
+    printf("dispatch %-10s %5u events: %.2f us/event, max %.1f us, %u NVS commits\n",
+           name, (unsigned)events, (double)busy / STATE_ROUNDS / 1000.0, (double)worst / 1000.0,
+           (unsigned)(nvs_stub_commit_count() - commits));
+}
+
+void bench_state(void)
+{
+    static const uint8_t phone[6] = { 0x02, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+    stereo_state_set_power(true);
+    host_run();
+    host_advance_ms(1000);
+
+    run_class("rotary", ev_rotary);
+    run_class("seek", ev_seek);
+    run_class("rds", ev_rds);
+
+    stereo_state_bt_device_connected(phone);
+    stereo_state_set_mode(MODE_BLUETOOTH);
+    stereo_state_a2dp_streaming(true);
+    host_advance_ms(1000);
+
+    run_class("metadata", ev_metadata);
+    run_class("track", ev_track);
+    run_class("volume", ev_rotary);
+
+    stereo_state_bt_device_disconnected(phone);
+    stereo_state_set_mode(MODE_RADIO);
+    host_advance_ms(10000);
+}
@@ -0,0 +1,35 @@
+/*
+ * Car Stereo Host Harness
+ * Runs the firmware's state machine and display on the linux target:
+ * benchmarks by default, a recorded event stream with CAR_STEREO_REPLAY
+ */
+
+#include "bench.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void app_main(void)
+{
+    // State and display logging would swamp the benchmark output
+    esp_log_level_set("*", getenv("CAR_STEREO_LOG") ? ESP_LOG_INFO : ESP_LOG_WARN);
+
+    if (host_stereo_init() != ESP_OK) {
+        exit(1);
+    }
+
+    const char *trace = getenv("CAR_STEREO_REPLAY");
+    if (trace) {
+        exit(replay_run(trace));
+    }
+
+    // A recorded boot carries its own btready; the benchmarks start with BT up
+    stereo_state_bt_ready();
+    host_run();
+
+    bench_sanitize();
+    bench_state();
+    bench_display();
+    bench_dsp();
+    exit(0);
+}
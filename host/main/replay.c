@@ -0,0 +1,259 @@
+/*
+ * Event Replay
+ * Feeds a recorded "EVT" stream (CONFIG_CAR_STEREO_EVENT_RECORD) back
+ * through the state machine on the virtual clock
+ */
+
+#include "bench.h"
+#include "a2dpSinkHfpHf.h"
+#include "nvs.h"
+#include "esp_timer.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_LINE_LEN     512
+#define REPLAY_MAX_ARGS     8
+#define REPLAY_TAIL_MS      10000   // Let debounces and write-behind finish
+
+typedef struct {
+    const char *s;              // NULL for "-"
+    char buf[132];
+} replay_arg_t;
+
+static uint32_t g_digest = 2166136261u;     // FNV-1a over everything the UI saw
+static uint32_t g_notifications = 0;
+static uint32_t g_mode_changes = 0;
+static bool g_verbose = false;
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+
+static void digest(const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        g_digest = (g_digest ^ p[i]) * 16777619u;
+    }
+}
+
+static void on_notification(display_notification_t n)
+{
+    uint32_t fields[3] = { (uint32_t)n.type, n.duration_ms, n.priority };
+    digest(fields, sizeof(fields));
+    digest(n.text, strnlen(n.text, sizeof(n.text)));
+    digest("", 1);
+    digest(n.subtext, strnlen(n.subtext, sizeof(n.subtext)));
+    g_notifications++;
+    if (g_verbose) {
+        printf("%8lld ms  notify %d \"%s\" \"%s\" %lu ms\n",
+               (long long)(esp_timer_get_time() / 1000), n.type, n.text, n.subtext,
+               (unsigned long)n.duration_ms);
+    }
+}
+
+static void on_mode_change(stereo_mode_t old_mode, stereo_mode_t new_mode)
+{
+    uint32_t modes[2] = { (uint32_t)old_mode, (uint32_t)new_mode };
+    digest(modes, sizeof(modes));
+    g_mode_changes++;
+    if (g_verbose) {
+        printf("%8lld ms  mode %d -> %d\n",
+               (long long)(esp_timer_get_time() / 1000), old_mode, new_mode);
+    }
+}
+
+// ============================================================================
+// PARSING
+// ============================================================================
+
+// Next token: a bare word, "-" for a missing field, or a quoted string
+// with \" and \\ escapes. Returns the position after it, NULL at the end.
+static const char *next_arg(const char *p, replay_arg_t *arg)
+{
+    while (*p == ' ' || *p == '\t') p++;
+    if (!*p || *p == '\r' || *p == '\n') return NULL;
+
+    size_t n = 0;
+    if (*p == '"') {
+        for (p++; *p && *p != '"'; p++) {
+            if (*p == '\\' && p[1]) p++;
+            if (n + 1 < sizeof(arg->buf)) arg->buf[n++] = *p;
+        }
+        if (*p == '"') p++;
+        arg->buf[n] = '\0';
+        arg->s = arg->buf;
+        return p;
+    }
+    while (*p && !isspace((unsigned char)*p)) {
+        if (n + 1 < sizeof(arg->buf)) arg->buf[n++] = *p;
+        p++;
+    }
+    arg->buf[n] = '\0';
+    arg->s = strcmp(arg->buf, "-") == 0 ? NULL : arg->buf;
+    return p;
+}
+
+// A number, or one of the names (index = value) for hand-written traces
+static int arg_value(const replay_arg_t *arg, const char *const *names, int count)
+{
+    if (!arg->s) return 0;
+    for (int i = 0; names && i < count; i++) {
+        if (names[i] && strcmp(arg->s, names[i]) == 0) return i;
+    }
+    return atoi(arg->s);
+}
+
+static bool arg_mac(const replay_arg_t *arg, uint8_t mac[6])
+{
+    unsigned b[6];
+    if (!arg->s || sscanf(arg->s, "%x:%x:%x:%x:%x:%x",
+                          &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) mac[i] = (uint8_t)b[i];
+    return true;
+}
+
+static const char *const g_button_names[] = {
+    [BTN_ROTARY] = "rotary", [BTN_BAND_UM] = "band_um", [BTN_BAND_VF] = "band_vf",
+    [BTN_STATION_1] = "st1", [BTN_STATION_2] = "st2", [BTN_STATION_3] = "st3",
+    [BTN_STATION_4] = "st4", [BTN_STATION_5] = "st5", [BTN_DOWN] = "down", [BTN_UP] = "up",
+};
+
+static const char *const g_event_names[] = {
+    [BTN_EVENT_PRESS] = "press", [BTN_EVENT_RELEASE] = "release",
+    [BTN_EVENT_LONG_PRESS] = "long", [BTN_EVENT_RELEASE_AFTER_LONG] = "release_long",
+    [BTN_EVENT_REPEAT] = "repeat", [BTN_EVENT_ROTARY_CW] = "cw", [BTN_EVENT_ROTARY_CCW] = "ccw",
+};
+
+static const char *const g_mode_names[] = {
+    [MODE_OFF] = "off", [MODE_RADIO] = "radio", [MODE_BLUETOOTH] = "bt",
+    [MODE_PHONE_CALL] = "call", [MODE_PHONEBOOK] = "phonebook",
+};
+
+static const char *const g_target_names[] = {
+    [BT_VOLUME_TARGET_A2DP] = "a2dp", [BT_VOLUME_TARGET_HFP_SPEAKER] = "speaker",
+    [BT_VOLUME_TARGET_HFP_MIC] = "mic",
+};
+
+#define NAMES(table)    table, (int)(sizeof(table) / sizeof(table[0]))
+
+// Hand one recorded event to the public API the firmware took it from
+static bool replay_event(const char *verb, const replay_arg_t *a, int argc)
+{
+    uint8_t mac[6];
+    if (strcmp(verb, "button") == 0 && argc >= 2) {
+        int64_t now = esp_timer_get_time();
+        button_event_t e = {
+            .button = (button_id_t)arg_value(&a[0], NAMES(g_button_names)),
+            .event = (button_event_type_t)arg_value(&a[1], NAMES(g_event_names)),
+            .timestamp = (uint32_t)(now / 1000),
+            .origin_us = (uint32_t)now,
+            .detents = argc > 2 ? (uint8_t)arg_value(&a[2], NULL, 0) : 1,
+            .steps = argc > 3 ? (uint8_t)arg_value(&a[3], NULL, 0) : 1,
+            .velocity = argc > 4 ? (uint16_t)arg_value(&a[4], NULL, 0) : 0,
+        };
+        stereo_state_handle_button(e);
+    } else if (strcmp(verb, "power") == 0 && argc >= 1) {
+        stereo_state_set_power(arg_value(&a[0], NULL, 0) != 0);
+    } else if (strcmp(verb, "mode") == 0 && argc >= 1) {
+        stereo_state_set_mode((stereo_mode_t)arg_value(&a[0], NAMES(g_mode_names)));
+    } else if (strcmp(verb, "call") == 0 && argc >= 2) {
+        stereo_state_hfp_call_status(arg_value(&a[0], NULL, 0) != 0, a[1].s);
+    } else if (strcmp(verb, "rds") == 0 && argc >= 2) {
+        stereo_state_rds_update(a[0].s, a[1].s);
+    } else if (strcmp(verb, "meta") == 0 && argc >= 3) {
+        stereo_state_a2dp_metadata(a[0].s, a[1].s, a[2].s);
+    } else if (strcmp(verb, "stream") == 0 && argc >= 1) {
+        stereo_state_a2dp_streaming(arg_value(&a[0], NULL, 0) != 0);
+    } else if (strcmp(verb, "connect") == 0 && argc >= 1) {
+        stereo_state_bt_device_connected(arg_mac(&a[0], mac) ? mac : NULL);
+    } else if (strcmp(verb, "disconnect") == 0 && argc >= 1) {
+        stereo_state_bt_device_disconnected(arg_mac(&a[0], mac) ? mac : NULL);
+    } else if (strcmp(verb, "btvol") == 0 && argc >= 2) {
+        a2dp_stub_volume_changed((bt_volume_target_t)arg_value(&a[0], NAMES(g_target_names)),
+                                 (uint8_t)arg_value(&a[1], NULL, 0));
+    } else if (strcmp(verb, "btready") == 0) {
+        stereo_state_bt_ready();
+    } else if (strcmp(verb, "save") == 0) {
+        stereo_state_save();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// RUNNER
+// ============================================================================
+
+int replay_run(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("replay: cannot open %s\n", path);
+        return 1;
+    }
+    g_verbose = getenv("CAR_STEREO_REPLAY_VERBOSE") != NULL;
+    host_set_sinks(on_notification, on_mode_change);
+
+    static char line[REPLAY_LINE_LEN];
+    replay_arg_t args[REPLAY_MAX_ARGS];
+    unsigned events = 0, skipped = 0, lineno = 0;
+    bool have_origin = false;
+    long long origin_ms = 0;
+    int64_t base_us = esp_timer_get_time();
+    uint32_t commits = nvs_stub_commit_count();
+    int64_t start = bench_now_ns();
+
+    // Device log lines carry the record after a log prefix; hand-written
+    // traces may start with it. Lines without "EVT <ms>" are ignored.
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        const char *p = strstr(line, "EVT ");
+        if (!p) continue;
+        char *end;
+        long long ms = strtoll(p + 4, &end, 10);
+        if (end == p + 4) continue;
+        replay_arg_t verb;
+        p = next_arg(end, &verb);
+        if (!p || !verb.s) {
+            skipped++;
+            continue;
+        }
+        int argc = 0;
+        while (argc < REPLAY_MAX_ARGS && (p = next_arg(p, &args[argc])) != NULL) argc++;
+
+        // Event times are kept relative to the first one in the trace
+        if (!have_origin) {
+            origin_ms = ms;
+            have_origin = true;
+        }
+        int64_t due_us = base_us + (ms - origin_ms) * 1000;
+        int64_t now_us = esp_timer_get_time();
+        if (due_us > now_us) host_advance_ms((uint32_t)((due_us - now_us) / 1000));
+
+        if (!replay_event(verb.s, args, argc)) {
+            printf("replay: line %u: unknown event \"%s\"\n", lineno, verb.s);
+            skipped++;
+            continue;
+        }
+        host_run();
+        events++;
+    }
+    fclose(f);
+    host_advance_ms(REPLAY_TAIL_MS);
+    int64_t took = bench_now_ns() - start;
+
+    printf("replay %s: %u events (%u skipped), %lld ms of trace, %u notifications, "
+           "%u mode changes, %u NVS commits, %.1f ms host\n",
+           path, events, skipped, (long long)((esp_timer_get_time() - base_us) / 1000),
+           (unsigned)g_notifications, (unsigned)g_mode_changes,
+           (unsigned)(nvs_stub_commit_count() - commits), (double)took / 1e6);
+    printf("replay digest %08lx\n", (unsigned long)g_digest);
+    host_set_sinks(NULL, NULL);
+    return skipped ? 2 : 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * Phonebook Stub
+ * A small fixed phonebook in RAM in place of the flash-mapped store;
+ * only what the state machine calls
+ */
+
+#include "phonebook_store.h"
+#include <ctype.h>
+#include <string.h>
+
+// Sorted by name, as the real store is
+static const phonebook_contact_t g_contacts[] = {
+    { "Anna de Vries",   "+31612345678" },
+    { "Bas",             "0612340001" },
+    { "Björn Larsson",   "+46701234567" },
+    { "Garage Jansen",   "020-5551234" },
+    { "Jérôme Müller",   "+33612345678" },
+    { "Mam",             "06-11223344" },
+    { "Werk",            "+31205550000" },
+    { "112",             "112" },
+};
+
+#define CONTACT_COUNT   (sizeof(g_contacts) / sizeof(g_contacts[0]))
+
+esp_err_t phonebook_store_init(void)
+{
+    return ESP_OK;
+}
+
+void phonebook_store_watch_sync(void)
+{
+}
+
+size_t phonebook_store_count(void)
+{
+    return CONTACT_COUNT;
+}
+
+bool phonebook_store_get(size_t idx, phonebook_contact_t *out)
+{
+    if (idx >= CONTACT_COUNT) return false;
+    *out = g_contacts[idx];
+    return true;
+}
+
+uint8_t phonebook_letter_class(const char *name)
+{
+    char c = (char)toupper((unsigned char)name[0]);
+    return c >= 'A' && c <= 'Z' ? (uint8_t)(c - 'A') : PHONEBOOK_LETTER_OTHER;
+}
+
+size_t phonebook_store_letter_first(uint8_t letter)
+{
+    for (size_t i = 0; i < CONTACT_COUNT; i++) {
+        if (phonebook_letter_class(g_contacts[i].name) >= letter) return i;
+    }
+    return CONTACT_COUNT;
+}
+
+// Digits only, so "06-11223344" matches a CLIP of "0611223344"
+static bool same_number(const char *a, const char *b)
+{
+    while (*a || *b) {
+        while (*a && !isdigit((unsigned char)*a)) a++;
+        while (*b && !isdigit((unsigned char)*b)) b++;
+        if (*a != *b) return false;
+        if (*a) {
+            a++;
+            b++;
+        }
+    }
+    return true;
+}
+
+bool phonebook_store_caller_name(const char *number, char *name, size_t size)
+{
+    if (!number) return false;
+    for (size_t i = 0; i < CONTACT_COUNT; i++) {
+        if (same_number(g_contacts[i].number, number)) {
+            strncpy(name, g_contacts[i].name, size - 1);
+            name[size - 1] = '\0';
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,188 @@
+/*
+ * Audio DSP
+ * Tone shelves and volume-following loudness on the decoded A2DP stream
+ */
+
+#include "audio_dsp.h"
+#include "esp_dsp.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define TAG "AUDIO_DSP"
+
+#define DSP_BLOCK_FRAMES        256     // Float scratch per pass, 2 KB per buffer
+#define DSP_STAGES              2       // Bass shelf, treble shelf
+
+#define DSP_BASS_HZ             100.0f
+#define DSP_TREBLE_HZ           8000.0f
+#define DSP_SHELF_Q             0.707f
+
+// The original speakers lose bass first as the level drops. Below
+// DSP_LOUDNESS_FLAT_STEP the shelves lift linearly towards step 0.
+#define DSP_LOUDNESS_FLAT_STEP  12
+#define DSP_LOUDNESS_BASS_DB    12.0f
+#define DSP_LOUDNESS_TREBLE_DB  4.0f
+
+typedef struct {
+    float coef[DSP_STAGES][5];  // b0 b1 b2 a1 a2, headroom folded into stage 0
+    bool flat;                  // Unity response: skip the block
+} dsp_step_t;
+
+// Two tables so a rebuild never changes coefficients under a running block
+static dsp_step_t g_tables[2][AUDIO_DSP_VOLUME_STEPS];
+static volatile uint8_t g_table = 0;
+static volatile uint8_t g_volume = AUDIO_DSP_VOLUME_STEPS - 1;
+static uint32_t g_sample_rate = 44100;
+static int8_t g_bass_db = 0;
+static int8_t g_treble_db = 0;
+static SemaphoreHandle_t g_rebuild_lock = NULL;     // Tone and rate changes come from different tasks
+
+// Audio task only
+static float g_buf_a[DSP_BLOCK_FRAMES * 2];
+static float g_buf_b[DSP_BLOCK_FRAMES * 2];
+static float g_delay[DSP_STAGES][4];        // Per stage: w1 w2 left, w1 w2 right
+static bool g_primed = false;               // g_delay holds a running filter
+static audio_dsp_stats_t g_stats;
+
+// ============================================================================
+// COEFFICIENTS
+// ============================================================================
+
+static float loudness_db(float max_db, int volume)
+{
+    if (volume >= DSP_LOUDNESS_FLAT_STEP) return 0.0f;
+    return max_db * (DSP_LOUDNESS_FLAT_STEP - volume) / DSP_LOUDNESS_FLAT_STEP;
+}
+
+static void rebuild_tables(void)
+{
+    uint8_t next = g_table ^ 1;
+    float fs = (float)g_sample_rate;
+
+    for (int v = 0; v < AUDIO_DSP_VOLUME_STEPS; v++) {
+        dsp_step_t *step = &g_tables[next][v];
+        float bass = g_bass_db + loudness_db(DSP_LOUDNESS_BASS_DB, v);
+        float treble = g_treble_db + loudness_db(DSP_LOUDNESS_TREBLE_DB, v);
+
+        step->flat = bass == 0.0f && treble == 0.0f;
+        dsps_biquad_gen_lowShelf_f32(step->coef[0], DSP_BASS_HZ / fs, bass, DSP_SHELF_Q);
+        dsps_biquad_gen_highShelf_f32(step->coef[1], DSP_TREBLE_HZ / fs, treble, DSP_SHELF_Q);
+
+        // A boosted shelf would clip a full-scale track: pull the level down
+        // by the largest boost so the curve only ever cuts
+        float boost = fmaxf(fmaxf(bass, treble), 0.0f);
+        float headroom = powf(10.0f, -boost / 20.0f);
+        for (int i = 0; i < 3; i++) {
+            step->coef[0][i] *= headroom;
+        }
+    }
+    g_table = next;
+}
+
+esp_err_t audio_dsp_init(uint32_t sample_rate_hz)
+{
+    if (sample_rate_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_rebuild_lock = xSemaphoreCreateMutex();
+    if (!g_rebuild_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    g_sample_rate = sample_rate_hz;
+    rebuild_tables();
+    ESP_LOGI(TAG, "Tone tables for %lu Hz, loudness below step %d",
+             (unsigned long)sample_rate_hz, DSP_LOUDNESS_FLAT_STEP);
+    return ESP_OK;
+}
+
+esp_err_t audio_dsp_set_sample_rate(uint32_t sample_rate_hz)
+{
+    if (sample_rate_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!g_rebuild_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(g_rebuild_lock, portMAX_DELAY);
+    bool changed = sample_rate_hz != g_sample_rate;
+    if (changed) {
+        g_sample_rate = sample_rate_hz;
+        rebuild_tables();
+    }
+    xSemaphoreGive(g_rebuild_lock);
+    if (changed) {
+        ESP_LOGI(TAG, "Tone tables rebuilt for %lu Hz", (unsigned long)sample_rate_hz);
+    }
+    return ESP_OK;
+}
+
+void audio_dsp_set_tone(int8_t bass_db, int8_t treble_db)
+{
+    if (!g_rebuild_lock) return;
+    xSemaphoreTake(g_rebuild_lock, portMAX_DELAY);
+    g_bass_db = bass_db;
+    g_treble_db = treble_db;
+    rebuild_tables();
+    xSemaphoreGive(g_rebuild_lock);
+}
+
+void audio_dsp_set_volume(uint8_t volume)
+{
+    g_volume = volume < AUDIO_DSP_VOLUME_STEPS ? volume : AUDIO_DSP_VOLUME_STEPS - 1;
+}
+
+// ============================================================================
+// PROCESSING
+// ============================================================================
+
+void audio_dsp_process(int16_t *pcm, size_t frames)
+{
+    const dsp_step_t *step = &g_tables[g_table][g_volume];
+    if (step->flat) {
+        g_primed = false;
+        return;
+    }
+    if (!g_primed) {
+        memset(g_delay, 0, sizeof(g_delay));
+        g_primed = true;
+    }
+
+    int64_t start = esp_timer_get_time();
+    g_stats.frames += frames;
+
+    while (frames) {
+        size_t n = frames < DSP_BLOCK_FRAMES ? frames : DSP_BLOCK_FRAMES;
+        size_t samples = n * 2;
+
+        for (size_t i = 0; i < samples; i++) {
+            g_buf_a[i] = pcm[i];
+        }
+        // Interleaved stereo kernels (ae32/aes3 assembly when DSP_OPTIMIZED),
+        // one 4-float delay line per stage for both channels
+        dsps_biquad_sf32(g_buf_a, g_buf_b, n, (float *)step->coef[0], g_delay[0]);
+        dsps_biquad_sf32(g_buf_b, g_buf_a, n, (float *)step->coef[1], g_delay[1]);
+        for (size_t i = 0; i < samples; i++) {
+            float s = g_buf_a[i];
+            pcm[i] = s >= 32767.0f ? 32767 : s <= -32768.0f ? -32768 : (int16_t)s;
+        }
+
+        pcm += samples;
+        frames -= n;
+    }
+
+    uint32_t took = (uint32_t)(esp_timer_get_time() - start);
+    g_stats.blocks++;
+    g_stats.block_us_last = took;
+    g_stats.block_us_total += took;
+    if (took > g_stats.block_us_max) g_stats.block_us_max = took;
+}
+
+void audio_dsp_get_stats(audio_dsp_stats_t *stats)
+{
+    *stats = g_stats;
+}
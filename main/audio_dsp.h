@@ -0,0 +1,79 @@
+#ifndef AUDIO_DSP_H
+#define AUDIO_DSP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Volume steps, as in a2dp_state_t.volume
+#define AUDIO_DSP_VOLUME_STEPS  16
+
+/**
+ * @brief Per-block cost of the DSP stage since boot
+ */
+typedef struct {
+    uint32_t blocks;            // audio_dsp_process() calls that did work
+    uint32_t frames;            // Stereo frames filtered
+    uint32_t block_us_last;     // Cost of the last block
+    uint32_t block_us_max;      // Cost of the slowest block
+    uint64_t block_us_total;    // Sum over all blocks
+} audio_dsp_stats_t;
+
+/**
+ * @brief Build the coefficient tables for one sample rate
+ * One bass and one treble shelf per channel, with the loudness boost and
+ * the headroom for it folded in, precomputed for every volume step.
+ * @param sample_rate_hz Rate to assume until the codec config arrives
+ * @return ESP_OK on success
+ */
+esp_err_t audio_dsp_init(uint32_t sample_rate_hz);
+
+/**
+ * @brief Follow the sample rate the phone negotiated
+ * SBC runs at 44.1 or 48 kHz depending on the phone; the shelf corners
+ * are relative to the rate, so the tables are rebuilt when it changes.
+ * Not for the audio path. The block that is running keeps its tables.
+ * @param sample_rate_hz Rate from the A2DP codec config
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE before audio_dsp_init()
+ */
+esp_err_t audio_dsp_set_sample_rate(uint32_t sample_rate_hz);
+
+/**
+ * @brief Set the tone trims and rebuild the tables
+ * Not for the audio path: rebuilding takes a few hundred microseconds.
+ * @param bass_db Bass shelf gain in dB on top of loudness
+ * @param treble_db Treble shelf gain in dB on top of loudness
+ */
+void audio_dsp_set_tone(int8_t bass_db, int8_t treble_db);
+
+/**
+ * @brief Select the coefficient set for a volume step
+ * Just an index switch, safe to call from any task.
+ * Used as stereo_config_t.on_a2dp_volume.
+ * @param volume 0 .. AUDIO_DSP_VOLUME_STEPS - 1
+ */
+void audio_dsp_set_volume(uint8_t volume);
+
+/**
+ * @brief Filter decoded PCM in place, before it is written to I2S
+ * Call from the one task that feeds I2S. Blocks of any length are fine.
+ * @param pcm Interleaved 16-bit stereo samples
+ * @param frames Number of stereo frames (samples / 2)
+ */
+void audio_dsp_process(int16_t *pcm, size_t frames);
+
+/**
+ * @brief Snapshot the DSP counters
+ * @param stats Receives the counters
+ */
+void audio_dsp_get_stats(audio_dsp_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_H
@@ -1,30 +1,86 @@
 #include "buttons.h"
+#include "task_map.h"
+#include "trace.h"
+#include "deferred_log.h"
+#include "sdkconfig.h"
 #include "driver/gpio.h"
+#if CONFIG_CAR_STEREO_BUTTONS_ADC_CONTINUOUS
+#include "esp_adc/adc_continuous.h"
+#endif
 #include "esp_adc/adc_oneshot.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "nvs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#if CONFIG_CAR_STEREO_ROTARY_PCNT
+#include "driver/pulse_cnt.h"
+#endif
 
 #define TAG "BUTTONS"
 
-// Button ADC thresholds for ESP32 (12-bit, 3.3V)
+#define NVS_NAMESPACE       "buttons"
+#define NVS_KEY_ADC_OFFSET  "adc_offset"
+#define ADC_OFFSET_MAX      300     // Larger corrections mean a wiring fault, not drift
+
+// Button ADC levels for ESP32 (12-bit, 3.3V)
 // Based on measured voltages with pull-down resistor
-static const uint16_t button_thresholds[] = {
-    201,   // BTN_BAND_UM (Tactile 1: 100kΩ) - MEASURED ✓
-    346,   // BTN_BAND_VF (Tactile 2: 68kΩ)  - MEASURED ✓
-    757,   // BTN_STATION_1 (Tactile 3: 33kΩ) - MEASURED ✓
-    1425,  // BTN_STATION_2 (Tactile 4: 15kΩ) - MEASURED ✓
-    2204,  // BTN_STATION_3 (Tactile 5: 6.8kΩ) - MEASURED ✓
-    2830,  // BTN_STATION_4 (Tactile 6: 3.3kΩ) - MEASURED ✓
-    3450,  // BTN_STATION_5 (Tactile 7: 1.5kΩ) - MEASURED ✓
-    3920,  // BTN_DOWN (Tactile 8: 330Ω) - MEASURED ✓
-    4095   // BTN_UP (Tactile 9: 150Ω) - estimated (probably ~4050-4070)
+#define LADDER_BAND_UM      201     // Tactile 1: 100kΩ - MEASURED ✓
+#define LADDER_BAND_VF      346     // Tactile 2: 68kΩ  - MEASURED ✓
+#define LADDER_STATION_1    757     // Tactile 3: 33kΩ  - MEASURED ✓
+#define LADDER_STATION_2    1425    // Tactile 4: 15kΩ  - MEASURED ✓
+#define LADDER_STATION_3    2204    // Tactile 5: 6.8kΩ - MEASURED ✓
+#define LADDER_STATION_4    2830    // Tactile 6: 3.3kΩ - MEASURED ✓
+#define LADDER_STATION_5    3450    // Tactile 7: 1.5kΩ - MEASURED ✓
+#define LADDER_DOWN         3920    // Tactile 8: 330Ω  - MEASURED ✓
+#define LADDER_UP           4095    // Tactile 9: 150Ω  - estimated (probably ~4050-4070)
+#define LADDER_IDLE_MAX     100     // Below this no button is pressed
+#define LADDER_TOLERANCE_PCT 5      // Resistor tolerance, as a share of the level
+#define LADDER_NOISE_COUNTS 40      // ADC noise on top of that
+
+// A button owns the readings within its tolerance, but never past the
+// midpoint to a neighbouring level, so adjacent windows cannot overlap
+#define LADDER_MID(a, b)    (((a) + (b)) / 2)
+#define LADDER_TOL(t)       ((t) * LADDER_TOLERANCE_PCT / 100 + LADDER_NOISE_COUNTS)
+#define LADDER_MAX(a, b)    ((a) > (b) ? (a) : (b))
+#define LADDER_MIN(a, b)    ((a) < (b) ? (a) : (b))
+#define LADDER_IN(v, prev, t, next) \
+    ((v) >= LADDER_MAX(LADDER_MID(prev, t), (t) - LADDER_TOL(t)) && \
+     (v) <  LADDER_MIN(LADDER_MID(t, next), (t) + LADDER_TOL(t)))
+#define LADDER_CLASSIFY(v) ( \
+    (v) < LADDER_IDLE_MAX ? BTN_NONE : \
+    LADDER_IN(v, LADDER_IDLE_MAX, LADDER_BAND_UM, LADDER_BAND_VF)   ? BTN_BAND_UM : \
+    LADDER_IN(v, LADDER_BAND_UM, LADDER_BAND_VF, LADDER_STATION_1)  ? BTN_BAND_VF : \
+    LADDER_IN(v, LADDER_BAND_VF, LADDER_STATION_1, LADDER_STATION_2) ? BTN_STATION_1 : \
+    LADDER_IN(v, LADDER_STATION_1, LADDER_STATION_2, LADDER_STATION_3) ? BTN_STATION_2 : \
+    LADDER_IN(v, LADDER_STATION_2, LADDER_STATION_3, LADDER_STATION_4) ? BTN_STATION_3 : \
+    LADDER_IN(v, LADDER_STATION_3, LADDER_STATION_4, LADDER_STATION_5) ? BTN_STATION_4 : \
+    LADDER_IN(v, LADDER_STATION_4, LADDER_STATION_5, LADDER_DOWN)   ? BTN_STATION_5 : \
+    LADDER_IN(v, LADDER_STATION_5, LADDER_DOWN, LADDER_UP)          ? BTN_DOWN : \
+    LADDER_IN(v, LADDER_DOWN, LADDER_UP, 2 * 4096 - LADDER_UP)      ? BTN_UP : \
+    BTN_NONE)
+
+// Classification table over the top 8 bits of the 12-bit reading; each
+// 16-count bin takes the button of its centre value
+#define LADDER_LUT_SHIFT    4
+#define LADDER_BIN(i)       LADDER_CLASSIFY(((i) << LADDER_LUT_SHIFT) + (1 << (LADDER_LUT_SHIFT - 1)))
+#define LADDER_BINS4(i)     LADDER_BIN(i), LADDER_BIN((i) + 1), LADDER_BIN((i) + 2), LADDER_BIN((i) + 3)
+#define LADDER_BINS16(i)    LADDER_BINS4(i), LADDER_BINS4((i) + 4), LADDER_BINS4((i) + 8), LADDER_BINS4((i) + 12)
+#define LADDER_BINS64(i)    LADDER_BINS16(i), LADDER_BINS16((i) + 16), LADDER_BINS16((i) + 32), LADDER_BINS16((i) + 48)
+
+static const DRAM_ATTR uint8_t adc_button_lut[4096 >> LADDER_LUT_SHIFT] = {
+    LADDER_BINS64(0), LADDER_BINS64(64), LADDER_BINS64(128), LADDER_BINS64(192)
 };
 
-#define THRESHOLD_TOLERANCE 40  // ±40 ADC counts
-#define NUM_BUTTONS 9
 #define ADC_SAMPLES 4  // Average 4 readings for stability
+#define ADC_POLL_INTERVAL_MS 20
+
+// Internal queue entry: wakes the input task to re-check the ADC ladder or
+// the rotary long-press deadline; never passed to the callback
+#define BTN_EVENT_WAKE ((button_event_type_t)0xFF)
 
 // Rotary encoder state machine
 typedef enum {
@@ -34,14 +90,37 @@ typedef enum {
     ENC_STATE_11 = 3   // Both HIGH
 } encoder_state_t;
 
+#if CONFIG_CAR_STEREO_BUTTONS_ADC_CONTINUOUS
+// DMA sampling: ESP32 minimum rate, ~6.4 ms averaging window per frame
+#define ADC_CONT_SAMPLE_FREQ_HZ 20000
+#define ADC_CONT_FRAME_SAMPLES  128
+#define ADC_CONT_FRAME_BYTES    (ADC_CONT_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES)
+#define ADC_CONT_STABLE_FRAMES  2       // Debounce: ~13 ms to report a change
+#define ADC_CONT_GET_DATA(p)    ((p)->type1.data)
+#endif
+
 // Global variables
+#if CONFIG_CAR_STEREO_BUTTONS_ADC_CONTINUOUS
+static adc_continuous_handle_t adc_cont_handle;
+static volatile button_id_t g_adc_reported = BTN_NONE;  // Debounced by the DMA ISR
+static volatile uint32_t g_adc_change_us = 0;   // trace_now() of the last reported change
+static bool g_adc_dma = false;                  // DMA running, else polled with oneshot reads
+#endif
 static adc_oneshot_unit_handle_t adc_handle;
+static volatile int16_t g_adc_offset = 0;       // Per-unit calibration, from NVS
+static volatile int g_adc_last_reading = 0;     // Last averaged raw reading
+static StackType_t g_input_stack[TASK_INPUT_STACK];
+static StaticTask_t g_input_tcb;
+static volatile bool g_standby = false;         // Only the rotary switch is watched
+static volatile bool g_wake_armed = false;      // Switch is on a level wake interrupt
+static portMUX_TYPE g_wake_lock = portMUX_INITIALIZER_UNLOCKED;
 static adc_channel_t adc_channel;
 static int g_rotary_clk_pin;
 static int g_rotary_dt_pin;
 static int g_rotary_sw_pin;
 static button_callback_t g_callback;
 static QueueHandle_t g_button_queue = NULL;
+static buttons_stats_t g_stats;             // Written by the input task only
 // Timing variables
 static volatile uint32_t g_last_rotary_time = 0;
 static volatile uint32_t g_last_sw_time = 0;
@@ -50,7 +129,9 @@ static volatile bool g_rotary_pressed = false;
 static volatile bool g_long_press_sent = false;
 
 // Rotary encoder state
+#if !CONFIG_CAR_STEREO_ROTARY_PCNT
 static volatile encoder_state_t g_encoder_state = ENC_STATE_11;  // Start at rest position
+#endif
 static volatile int8_t g_encoder_position = 0;
 
 // Debounce and timing constants
@@ -59,6 +140,21 @@ static volatile int8_t g_encoder_position = 0;
 #define ROTATION_FILTER_MS 300  // Ignore button press within 200ms of rotation
 #define LONG_PRESS_THRESHOLD_MS 1000  // 1 second to trigger voice recognition
 
+// PCNT decoding: x4 quadrature counts, one detent = 2 counts (same as the
+// transition table path, which sends an event every 2 state changes)
+#define ROTARY_COUNTS_PER_DETENT 2
+#define ROTARY_GLITCH_FILTER_NS 10000  // ESP32 filter tops out at ~12.7us
+
+// Rotary acceleration: average detent interval -> step multiplier
+#define ROTARY_ACCEL_FAST_MS    25   // Faster than this: x4
+#define ROTARY_ACCEL_MEDIUM_MS  60   // Faster than this: x2
+#define ROTARY_ACCEL_IDLE_MS    250  // Slower than this: spin starts over
+
+#if CONFIG_CAR_STEREO_ROTARY_PCNT
+static pcnt_unit_handle_t g_pcnt_unit = NULL;
+#endif
+
+#if !CONFIG_CAR_STEREO_ROTARY_PCNT
 // Quadrature state machine transition table
 // 0=invalid, 1=CW, -1=CCW, 0=no_move
 static const int8_t rotary_transition_table[4][4] = {
@@ -67,40 +163,61 @@ static const int8_t rotary_transition_table[4][4] = {
     {-1, 0, 0, 1},    // 10
     {0, 1, -1, 0}     // 11
 };
+#endif
 
-// Helper function: Send button event to queue
-static inline void send_button_event(uint8_t button, uint8_t type)
+// Millisecond clock usable from ISRs; the 10 ms FreeRTOS tick is too coarse
+// for the 5 ms encoder debounce
+static inline uint32_t IRAM_ATTR now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+// Helper function: Queue button event from ISR, returns true if a task was woken
+static inline bool IRAM_ATTR queue_button_event_from_isr(uint8_t button, uint8_t type)
 {
     button_event_t event = {
         .button = button,
-        .event = type
+        .event = type,
+        .timestamp = now_ms(),
+        .origin_us = trace_now(),
+        .detents = 1,
+        .steps = 1
     };
     
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     xQueueSendFromISR(g_button_queue, &event, &xHigherPriorityTaskWoken);
-    if (xHigherPriorityTaskWoken) {
+    return xHigherPriorityTaskWoken == pdTRUE;
+}
+
+// Helper function: Send button event to queue
+static inline void IRAM_ATTR send_button_event(uint8_t button, uint8_t type)
+{
+    if (queue_button_event_from_isr(button, type)) {
         portYIELD_FROM_ISR();
     }
 }
 
 /**
- * @brief Rotary encoder ISR - handles both CLK and DT state changes
- * Uses proper quadrature decoding with Gray code state machine
+ * @brief Rotary switch press/release tracking (only valid with the knob at rest)
+ * @return true if the pin state was consumed as a switch event
  */
-static void IRAM_ATTR rotary_encoder_isr(void *arg)
+// Back from the standby level wake to edge interrupts on the first switch
+// press. The GPIO ISR service is not installed in IRAM, so calling the
+// driver from the ISR is safe.
+static void rotary_switch_rearm(void)
 {
-    uint32_t now = xTaskGetTickCountFromISR() * portTICK_PERIOD_MS;
-    
-    // Debounce - encoders typically bounce for 1-5ms
-    if (now - g_last_rotary_time < ROTARY_DEBOUNCE_MS) {
-        return;
+    portENTER_CRITICAL_SAFE(&g_wake_lock);
+    bool armed = g_wake_armed;
+    g_wake_armed = false;
+    portEXIT_CRITICAL_SAFE(&g_wake_lock);
+    if (armed) {
+        gpio_wakeup_disable(g_rotary_sw_pin);
+        gpio_set_intr_type(g_rotary_sw_pin, GPIO_INTR_ANYEDGE);
     }
-    
-    // Read both encoder pins
-    int sw_state = gpio_get_level(g_rotary_sw_pin);
-    int clk_state = gpio_get_level(g_rotary_clk_pin);
-    int dt_state = gpio_get_level(g_rotary_dt_pin);
-    // esp_rom_printf("sw: %d, clk: %d, dt: %d\n", sw_state, clk_state, dt_state);
+}
+
+static bool IRAM_ATTR rotary_switch_update(uint32_t now, int sw_state, int clk_state, int dt_state)
+{
     // Rotary button pressed (only if rotary at rest - both CLK and DT HIGH)
     if (sw_state == 0 && clk_state == 1 && dt_state == 1) {
         if (!g_rotary_pressed) {
@@ -108,11 +225,13 @@ static void IRAM_ATTR rotary_encoder_isr(void *arg)
             g_rotary_pressed = true;
             g_long_press_sent = false;
             g_encoder_position = 0;
+            // No event yet; the input task now times the long press
+            send_button_event(BTN_ROTARY, BTN_EVENT_WAKE);
         }
-        // Don't send event immediately; handled via separate monitor task for long press
+        return true;
     }
     // Rotary button released
-    else if (sw_state == 1 && g_rotary_pressed && clk_state == 1 && dt_state == 1) {
+    if (sw_state == 1 && g_rotary_pressed && clk_state == 1 && dt_state == 1) {
         g_rotary_pressed = false;
         uint32_t press_duration = now - g_rotary_press_start;
         if (press_duration >= LONG_PRESS_THRESHOLD_MS) {
@@ -120,34 +239,314 @@ static void IRAM_ATTR rotary_encoder_isr(void *arg)
         } else if (press_duration > DEBOUNCE_MS) {
             send_button_event(BTN_ROTARY, BTN_EVENT_PRESS);
         }
+        return true;
+    }
+    return false;
+}
+
+#if CONFIG_CAR_STEREO_ROTARY_PCNT
+
+/**
+ * @brief Rotary switch ISR - with PCNT decoding only the switch pin interrupts
+ */
+static void IRAM_ATTR rotary_switch_isr(void *arg)
+{
+    uint32_t now = now_ms();
+    if (now - g_last_sw_time < ROTARY_DEBOUNCE_MS) {
+        return;
+    }
+    g_last_sw_time = now;
+    if (g_wake_armed) rotary_switch_rearm();
+    rotary_switch_update(now, gpio_get_level(g_rotary_sw_pin),
+                         gpio_get_level(g_rotary_clk_pin),
+                         gpio_get_level(g_rotary_dt_pin));
+}
+
+/**
+ * @brief PCNT limit reached - exactly one detent turned
+ * The unit's limits are +-ROTARY_COUNTS_PER_DETENT, so the count auto-clears
+ * and no steps are lost however fast the knob spins.
+ */
+static bool IRAM_ATTR rotary_pcnt_on_reach(pcnt_unit_handle_t unit,
+                                           const pcnt_watch_event_data_t *edata,
+                                           void *user_ctx)
+{
+    g_last_rotary_time = now_ms();
+    return queue_button_event_from_isr(BTN_ROTARY, edata->watch_point_value > 0 ?
+                                       BTN_EVENT_ROTARY_CW : BTN_EVENT_ROTARY_CCW);
+}
+
+static esp_err_t rotary_pcnt_init(int rotary_clk, int rotary_dt)
+{
+    pcnt_unit_config_t unit_config = {
+        .high_limit = ROTARY_COUNTS_PER_DETENT,
+        .low_limit = -ROTARY_COUNTS_PER_DETENT,
+    };
+    ESP_RETURN_ON_ERROR(pcnt_new_unit(&unit_config, &g_pcnt_unit), TAG, "PCNT unit");
+    
+    pcnt_glitch_filter_config_t filter_config = {
+        .max_glitch_ns = ROTARY_GLITCH_FILTER_NS,
+    };
+    ESP_RETURN_ON_ERROR(pcnt_unit_set_glitch_filter(g_pcnt_unit, &filter_config), TAG, "PCNT filter");
+    
+    // Two channels, each counting edges of one phase gated by the other: x4 decoding
+    pcnt_chan_config_t chan_a_config = {
+        .edge_gpio_num = rotary_clk,
+        .level_gpio_num = rotary_dt,
+    };
+    pcnt_chan_config_t chan_b_config = {
+        .edge_gpio_num = rotary_dt,
+        .level_gpio_num = rotary_clk,
+    };
+    pcnt_channel_handle_t chan_a, chan_b;
+    ESP_RETURN_ON_ERROR(pcnt_new_channel(g_pcnt_unit, &chan_a_config, &chan_a), TAG, "PCNT chan A");
+    ESP_RETURN_ON_ERROR(pcnt_new_channel(g_pcnt_unit, &chan_b_config, &chan_b), TAG, "PCNT chan B");
+    
+    // Directions match rotary_transition_table: CLK leading DT is CW
+    pcnt_channel_set_edge_action(chan_a, PCNT_CHANNEL_EDGE_ACTION_DECREASE, PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+    pcnt_channel_set_level_action(chan_a, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+    pcnt_channel_set_edge_action(chan_b, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_DECREASE);
+    pcnt_channel_set_level_action(chan_b, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+    
+    // Watch points on the limits: one event per detent, counter auto-clears
+    ESP_RETURN_ON_ERROR(pcnt_unit_add_watch_point(g_pcnt_unit, ROTARY_COUNTS_PER_DETENT), TAG, "PCNT watch");
+    ESP_RETURN_ON_ERROR(pcnt_unit_add_watch_point(g_pcnt_unit, -ROTARY_COUNTS_PER_DETENT), TAG, "PCNT watch");
+    
+    pcnt_event_callbacks_t cbs = {
+        .on_reach = rotary_pcnt_on_reach,
+    };
+    ESP_RETURN_ON_ERROR(pcnt_unit_register_event_callbacks(g_pcnt_unit, &cbs, NULL), TAG, "PCNT callbacks");
+    ESP_RETURN_ON_ERROR(pcnt_unit_enable(g_pcnt_unit), TAG, "PCNT enable");
+    ESP_RETURN_ON_ERROR(pcnt_unit_clear_count(g_pcnt_unit), TAG, "PCNT clear");
+    ESP_RETURN_ON_ERROR(pcnt_unit_start(g_pcnt_unit), TAG, "PCNT start");
+    
+    return ESP_OK;
+}
+
+#else // !CONFIG_CAR_STEREO_ROTARY_PCNT
+
+/**
+ * @brief Rotary encoder ISR - handles both CLK and DT state changes
+ * Uses proper quadrature decoding with Gray code state machine
+ */
+static void IRAM_ATTR rotary_encoder_isr(void *arg)
+{
+    uint32_t now = now_ms();
+    
+    // Debounce - encoders typically bounce for 1-5ms
+    if (now - g_last_rotary_time < ROTARY_DEBOUNCE_MS) {
+        return;
+    }
+    
+    // Read both encoder pins
+    int sw_state = gpio_get_level(g_rotary_sw_pin);
+    int clk_state = gpio_get_level(g_rotary_clk_pin);
+    int dt_state = gpio_get_level(g_rotary_dt_pin);
+    if (g_wake_armed && sw_state == 0) rotary_switch_rearm();
+    // esp_rom_printf("sw: %d, clk: %d, dt: %d\n", sw_state, clk_state, dt_state);
+    if (rotary_switch_update(now, sw_state, clk_state, dt_state)) {
+        return;
     }
     // Rotary turn decoding on clk/dt edges
-    else {
-        // Create new state from pin readings
-        encoder_state_t new_state = (encoder_state_t)((clk_state << 1) | dt_state);
-        // Look up transition direction
-        int8_t direction = rotary_transition_table[g_encoder_state][new_state];
-        // Update state
-        g_encoder_state = new_state;
-
-        if (direction != 0) {
-            // Valid rotation detected
-            g_encoder_position += direction;
-            g_last_rotary_time = now; // Mark last rotary activity
-            // Each detent typically generates 4 state changes
-            // Send event only on full detent (every 4 steps)
-            // We have set it to 2 / -2 now (response every click on the dial)
-            if (g_encoder_position >= 2) {
-                g_encoder_position = 0;
-                send_button_event(BTN_ROTARY, BTN_EVENT_ROTARY_CW);
-            } else if (g_encoder_position <= -2) {
-                g_encoder_position = 0;
-                send_button_event(BTN_ROTARY, BTN_EVENT_ROTARY_CCW);
-            }
+    // Create new state from pin readings
+    encoder_state_t new_state = (encoder_state_t)((clk_state << 1) | dt_state);
+    // Look up transition direction
+    int8_t direction = rotary_transition_table[g_encoder_state][new_state];
+    // Update state
+    g_encoder_state = new_state;
+
+    if (direction != 0) {
+        // Valid rotation detected
+        g_encoder_position += direction;
+        g_last_rotary_time = now; // Mark last rotary activity
+        // Each detent typically generates 4 state changes
+        // Send event only on full detent (every 4 steps)
+        // We have set it to 2 / -2 now (response every click on the dial)
+        if (g_encoder_position >= 2) {
+            g_encoder_position = 0;
+            send_button_event(BTN_ROTARY, BTN_EVENT_ROTARY_CW);
+        } else if (g_encoder_position <= -2) {
+            g_encoder_position = 0;
+            send_button_event(BTN_ROTARY, BTN_EVENT_ROTARY_CCW);
         }
     }
 }
 
+#endif // CONFIG_CAR_STEREO_ROTARY_PCNT
+
+// Map an averaged ADC reading to a ladder button (no logging - ISR safe)
+static button_id_t IRAM_ATTR adc_classify(int adc_reading)
+{
+    int calibrated = adc_reading + g_adc_offset;
+    if (calibrated < 0) calibrated = 0;
+    if (calibrated > 4095) calibrated = 4095;
+    return (button_id_t)adc_button_lut[calibrated >> LADDER_LUT_SHIFT];
+}
+
+// ADC ladder press/hold/release tracking, shared by both sampling backends
+typedef struct {
+    button_id_t last_button;
+    uint32_t press_time;
+    bool long_press_sent;
+    uint32_t last_repeat_time;  // ✅ Track last repeat event time
+    uint32_t origin;            // trace_now() of the sample being tracked
+} adc_button_tracker_t;
+
+#define BUTTON_REPEAT_INTERVAL_MS 200  // ✅ Only send repeat every 200ms
+
+static void adc_button_emit(const adc_button_tracker_t *t, button_id_t button,
+                            button_event_type_t type, uint32_t now)
+{
+    button_event_t event = {
+        .button = button,
+        .event = type,
+        .timestamp = now,
+        .origin_us = t->origin
+    };
+    
+    if (g_callback) {
+        g_callback(event);
+    }
+}
+
+static void adc_button_track(adc_button_tracker_t *t, button_id_t current_button, uint32_t now)
+{
+    if (current_button != BTN_NONE && current_button != t->last_button) {
+        // New button press
+        t->press_time = now;
+        t->last_repeat_time = now;  // ✅ Initialize repeat timer
+        t->long_press_sent = false;
+        adc_button_emit(t, current_button, BTN_EVENT_PRESS, now);
+        
+    } else if (current_button != BTN_NONE && current_button == t->last_button) {
+        // Button held
+        
+        // Check for long press (only send once)
+        if (!t->long_press_sent && (now - t->press_time) >= LONG_PRESS_THRESHOLD_MS) {
+            adc_button_emit(t, current_button, BTN_EVENT_LONG_PRESS, now);
+            t->long_press_sent = true;
+        }
+        
+        // ✅ Send repeat events but rate-limited
+        if (t->long_press_sent && (now - t->last_repeat_time) >= BUTTON_REPEAT_INTERVAL_MS) {
+            adc_button_emit(t, current_button, BTN_EVENT_REPEAT, now);
+            t->last_repeat_time = now;
+        }
+        
+    } else if (current_button == BTN_NONE && t->last_button != BTN_NONE) {
+        // Button released
+        adc_button_emit(t, t->last_button, BTN_EVENT_RELEASE, now);
+    }
+    
+    t->last_button = current_button;
+}
+
+#if CONFIG_CAR_STEREO_BUTTONS_ADC_CONTINUOUS
+
+// One DMA frame = one averaging window; report a button after it has been
+// seen in ADC_CONT_STABLE_FRAMES consecutive frames. Frame averaging runs
+// here, so the input task only wakes when the classified button changes.
+static bool IRAM_ATTR adc_conv_done_isr(adc_continuous_handle_t handle,
+                                        const adc_continuous_evt_data_t *edata,
+                                        void *user_data)
+{
+    static button_id_t candidate = BTN_NONE;
+    static uint8_t stable_frames = 0;
+    
+    uint32_t sum = 0;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= edata->size; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&edata->conv_frame_buffer[i];
+        sum += ADC_CONT_GET_DATA(p);
+        count++;
+    }
+    if (count == 0) return false;
+    
+    g_adc_last_reading = (int)(sum / count);
+    button_id_t button = adc_classify(g_adc_last_reading);
+    if (button != candidate) {
+        candidate = button;
+        stable_frames = 1;
+    } else if (stable_frames < ADC_CONT_STABLE_FRAMES) {
+        stable_frames++;
+    }
+    
+    if (stable_frames < ADC_CONT_STABLE_FRAMES || candidate == g_adc_reported) {
+        return false;
+    }
+    g_adc_reported = candidate;
+    g_adc_change_us = trace_now();
+    
+    // If the queue is full the input task is busy and sees the change anyway
+    return queue_button_event_from_isr(BTN_NONE, BTN_EVENT_WAKE);
+}
+
+static esp_err_t adc_ladder_dma_start(adc_unit_t unit, adc_channel_t channel)
+{
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = ADC_CONT_FRAME_BYTES * 2,
+        .conv_frame_size = ADC_CONT_FRAME_BYTES,
+    };
+    ESP_RETURN_ON_ERROR(adc_continuous_new_handle(&handle_cfg, &adc_cont_handle), TAG, "ADC handle");
+    
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_12,  // 0-3.3V range
+        .channel = channel,
+        .unit = unit,
+        .bit_width = ADC_BITWIDTH_12,
+    };
+    adc_continuous_config_t dig_cfg = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = ADC_CONT_SAMPLE_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    ESP_RETURN_ON_ERROR(adc_continuous_config(adc_cont_handle, &dig_cfg), TAG, "ADC config");
+    
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = adc_conv_done_isr,
+    };
+    ESP_RETURN_ON_ERROR(adc_continuous_register_event_callbacks(adc_cont_handle, &cbs, NULL), TAG, "ADC callbacks");
+    return adc_continuous_start(adc_cont_handle);
+}
+
+#endif // CONFIG_CAR_STEREO_BUTTONS_ADC_CONTINUOUS
+
+static esp_err_t adc_ladder_oneshot_init(adc_unit_t unit, adc_channel_t channel)
+{
+    adc_oneshot_unit_init_cfg_t init_config = {
+        .unit_id = unit,
+    };
+    ESP_RETURN_ON_ERROR(adc_oneshot_new_unit(&init_config, &adc_handle), TAG, "ADC init");
+    
+    adc_oneshot_chan_cfg_t config = {
+        .bitwidth = ADC_BITWIDTH_12,
+        .atten = ADC_ATTEN_DB_12  // 0-3.3V range
+    };
+    ESP_RETURN_ON_ERROR(adc_oneshot_config_channel(adc_handle, channel, &config), TAG, "ADC channel config");
+    return ESP_OK;
+}
+
+// DMA sampling if enabled and available, else oneshot polling
+static esp_err_t adc_ladder_init(adc_unit_t unit, adc_channel_t channel)
+{
+#if CONFIG_CAR_STEREO_BUTTONS_ADC_CONTINUOUS
+    // The ESP32 ADC DMA is driven by I2S0; if audio already holds it, poll instead
+    esp_err_t ret = adc_ladder_dma_start(unit, channel);
+    if (ret == ESP_OK) {
+        g_adc_dma = true;
+        return ESP_OK;
+    }
+    ESP_LOGW(TAG, "ADC continuous unavailable (%s), polling instead", esp_err_to_name(ret));
+    if (adc_cont_handle) {
+        adc_continuous_deinit(adc_cont_handle);
+        adc_cont_handle = NULL;
+    }
+#endif
+    return adc_ladder_oneshot_init(unit, channel);
+}
+
 // Read button from ADC with averaging
 static button_id_t adc_read_button(void)
 {
@@ -163,148 +562,239 @@ static button_id_t adc_read_button(void)
     }
     
     int adc_reading = adc_sum / ADC_SAMPLES;
-    
-    // No button pressed
-    if (adc_reading < 100) {
-        return BTN_NONE;
+    g_adc_last_reading = adc_reading;
+    button_id_t button = adc_classify(adc_reading);
+    if (button == BTN_NONE && adc_reading >= LADDER_IDLE_MAX) {
+        DLOGW(TAG, "Unknown ADC value: %d (no button matched)", adc_reading);
     }
-    
+    return button;
+}
 
-return BTN_NONE;
+#if CONFIG_CAR_STEREO_BUTTONS_ADC_CONTINUOUS
+// Next long-press or repeat deadline of the held ADC button (polling covers
+// them in oneshot mode)
+static uint32_t adc_button_due(const adc_button_tracker_t *t)
+{
+    return t->long_press_sent ? t->last_repeat_time + BUTTON_REPEAT_INTERVAL_MS :
+                                t->press_time + LONG_PRESS_THRESHOLD_MS;
+}
+#endif
 
-    // Find matching button
-    for (int i = 0; i < NUM_BUTTONS; i++) {
-        if (adc_reading >= (button_thresholds[i] - THRESHOLD_TOLERANCE) &&
-            adc_reading <= (button_thresholds[i] + THRESHOLD_TOLERANCE)) {
-            // ESP_LOGI(TAG, "Button %d matched! (threshold: %d, reading: %d)", 
-            //          i+1, button_thresholds[i], adc_reading);
-            return (button_id_t)(i + 1);  // +1 because BTN_ROTARY is 0
+// Sample (oneshot) or pick up (DMA) the ladder and feed the press tracker
+static void adc_button_service(adc_button_tracker_t *t, uint32_t *next_poll, uint32_t now)
+{
+#if CONFIG_CAR_STEREO_BUTTONS_ADC_CONTINUOUS
+    if (g_adc_dma) {
+        button_id_t button = g_adc_reported;
+        if (button != t->last_button) {
+            t->origin = g_adc_change_us;
+            trace_record(TRACE_INPUT_DEQUEUE, t->origin);
+        } else {
+            t->origin = trace_now();    // Long-press/repeat deadline
         }
+        adc_button_track(t, button, now);
+        return;
     }
-    
-    ESP_LOGW(TAG, "Unknown ADC value: %d (no button matched)", adc_reading);
-    return BTN_NONE;
+#endif
+    if ((int32_t)(now - *next_poll) < 0) return;
+    t->origin = trace_now();
+    adc_button_track(t, adc_read_button(), now);
+    *next_poll = now_ms() + ADC_POLL_INTERVAL_MS;
 }
 
-// ADC button monitoring task
-static void adc_button_monitor_task(void *arg)
+// Rotary push held past the threshold: send the long press once
+static void rotary_long_press_check(uint32_t now)
 {
-    button_id_t last_button = BTN_NONE;
-    uint32_t press_time = 0;
-    bool long_press_sent = false;
-    uint32_t last_repeat_time = 0;  // ✅ Track last repeat event time
-    
-    #define BUTTON_REPEAT_INTERVAL_MS 200  // ✅ Only send repeat every 200ms
+    if (!g_rotary_pressed || g_long_press_sent ||
+        now - g_rotary_press_start < LONG_PRESS_THRESHOLD_MS) {
+        return;
+    }
+    button_event_t event = {
+        .button = BTN_ROTARY,
+        .event = BTN_EVENT_LONG_PRESS,
+        .timestamp = now,
+        .origin_us = trace_now()
+    };
+    g_long_press_sent = true;  // Prevents repeated calls
+    if (g_callback) {
+        g_callback(event);
+    }
+}
+
+static bool is_rotary_turn(const button_event_t *event)
+{
+    return event->event == BTN_EVENT_ROTARY_CW || event->event == BTN_EVENT_ROTARY_CCW;
+}
+
+static uint8_t rotary_accel_factor(uint32_t interval_ms)
+{
+    if (interval_ms < ROTARY_ACCEL_FAST_MS) return 4;
+    if (interval_ms < ROTARY_ACCEL_MEDIUM_MS) return 2;
+    return 1;
+}
+
+// Milliseconds-clock deadline to a queue timeout, rounded up
+static TickType_t ticks_until(uint32_t due, uint32_t now)
+{
+    int32_t left = (int32_t)(due - now);
+    return left > 0 ? pdMS_TO_TICKS(left) + 1 : 0;
+}
+
+// Time until the ADC ladder next needs the input task
+static TickType_t adc_button_wait(const adc_button_tracker_t *t, uint32_t next_poll, uint32_t now)
+{
+#if CONFIG_CAR_STEREO_BUTTONS_ADC_CONTINUOUS
+    if (g_adc_dma) {
+        // The DMA callback wakes the task on a change; only deadlines are left
+        return t->last_button != BTN_NONE ? ticks_until(adc_button_due(t), now) : portMAX_DELAY;
+    }
+#endif
+    return ticks_until(next_poll, now);
+}
+
+/**
+ * @brief Input task: rotary events, the ADC ladder and long-press deadlines
+ * Blocks on the ISR queue until an event arrives or the next deadline (ADC
+ * poll, long press, repeat) is due. Detents already queued in the same
+ * direction are folded into one event, and the detent rate sets
+ * steps/velocity so handlers can move further per event.
+ */
+static void input_task(void *arg)
+{
+    adc_button_tracker_t tracker = { .last_button = BTN_NONE };
+    uint32_t next_poll = now_ms();
+    button_event_t event;
+    button_event_t next;
+    bool have_next = false;
+    button_event_type_t last_dir = BTN_EVENT_ROTARY_CW;
+    uint32_t last_detent_time = 0;
     
     while (1) {
-        button_id_t current_button = adc_read_button();
-        uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+        uint32_t now = now_ms();
+        TickType_t wait = portMAX_DELAY;
+        if (!g_standby) {
+            wait = adc_button_wait(&tracker, next_poll, now);
+        }
+        if (g_rotary_pressed && !g_long_press_sent) {
+            TickType_t press = ticks_until(g_rotary_press_start + LONG_PRESS_THRESHOLD_MS, now);
+            if (press < wait) wait = press;
+        }
         
-        if (current_button != BTN_NONE && current_button != last_button) {
-            // New button press
-            press_time = now;
-            last_repeat_time = now;  // ✅ Initialize repeat timer
-            long_press_sent = false;
-            
-            button_event_t event = {
-                .button = current_button,
-                .event = BTN_EVENT_PRESS
-            };
-            
-            if (g_callback) {
-                g_callback(event);
+        bool got = true;
+        if (have_next) {
+            event = next;
+            have_next = false;
+        } else {
+            got = xQueueReceive(g_button_queue, &event, wait) == pdTRUE;
+            if (got) {
+                UBaseType_t depth = uxQueueMessagesWaiting(g_button_queue) + 1;
+                if (depth > g_stats.queue_depth_max) g_stats.queue_depth_max = (uint8_t)depth;
             }
+        }
+        
+        if (got && event.event != BTN_EVENT_WAKE) {
+            trace_record(TRACE_INPUT_DEQUEUE, event.origin_us);
             
-        } else if (current_button != BTN_NONE && current_button == last_button) {
-            // Button held
-            
-            // Check for long press (only send once)
-            if (!long_press_sent && (now - press_time) >= 1000) {
-                button_event_t event = {
-                    .button = current_button,
-                    .event = BTN_EVENT_LONG_PRESS
-                };
-                
-                if (g_callback) {
-                    g_callback(event);
+            if (is_rotary_turn(&event)) {
+                uint32_t detents = 1;
+                while (detents < UINT8_MAX && xQueueReceive(g_button_queue, &next, 0) == pdTRUE) {
+                    if (next.event != event.event) {
+                        have_next = true;
+                        break;
+                    }
+                    detents++;
+                    event.timestamp = next.timestamp;
                 }
                 
-                long_press_sent = true;
-            }
-            
-            // ✅ Send repeat events but rate-limited
-            if (long_press_sent && (now - last_repeat_time) >= BUTTON_REPEAT_INTERVAL_MS) {
-                button_event_t event = {
-                    .button = current_button,
-                    .event = BTN_EVENT_REPEAT  // You need to add this to your enum
-                };
-                
-                if (g_callback) {
-                    g_callback(event);
-                }
+                uint32_t span = event.timestamp - last_detent_time;
+                uint32_t interval = span / detents;
+                bool continuing = last_detent_time != 0 && event.event == last_dir &&
+                                  interval < ROTARY_ACCEL_IDLE_MS;
+                uint8_t factor = continuing ? rotary_accel_factor(interval) : 1;
+                uint32_t steps = detents * factor;
                 
-                last_repeat_time = now;
+                event.detents = (uint8_t)detents;
+                event.steps = (uint8_t)(steps > UINT8_MAX ? UINT8_MAX : steps);
+                event.velocity = continuing && interval > 0 ? (uint16_t)(1000 / interval) : 0;
+                last_dir = event.event;
+                last_detent_time = event.timestamp;
             }
             
-        } else if (current_button == BTN_NONE && last_button != BTN_NONE) {
-            // Button released
-            button_event_t event = {
-                .button = last_button,
-                .event = BTN_EVENT_RELEASE
-            };
-            
+            g_stats.events++;
             if (g_callback) {
                 g_callback(event);
             }
         }
         
-        last_button = current_button;
-        vTaskDelay(pdMS_TO_TICKS(20)); // Check every 20ms
+        now = now_ms();
+        rotary_long_press_check(now);
+        if (!g_standby) {
+            adc_button_service(&tracker, &next_poll, now);
+        }
     }
 }
 
-/**
- * @brief Task to monitor rotary button long press
- */
-static void button_long_press_monitor_task(void *arg)
+// ============================================================================
+// ADC CALIBRATION
+// ============================================================================
+
+static void load_adc_calibration(void)
 {
-    while (1) {
-        vTaskDelay(pdMS_TO_TICKS(100));  // Check every 100ms
-        
-        if (g_rotary_pressed && !g_long_press_sent) {
-            uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-            uint32_t press_duration = now - g_rotary_press_start;
-            
-            if (press_duration >= LONG_PRESS_THRESHOLD_MS) {
-                // Send long press event ONCE
-                button_event_t event = {
-                    .button = BTN_ROTARY,
-                    .event = BTN_EVENT_LONG_PRESS
-                };
-                
-                if (g_callback) {
-                    g_callback(event);
-                }
-                
-                g_long_press_sent = true;  // Prevents repeated calls
-            }
-        }
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;     // Never calibrated
+    }
+    int16_t offset;
+    if (nvs_get_i16(nvs_handle, NVS_KEY_ADC_OFFSET, &offset) == ESP_OK &&
+        offset >= -ADC_OFFSET_MAX && offset <= ADC_OFFSET_MAX) {
+        g_adc_offset = offset;
+        ESP_LOGI(TAG, "ADC ladder calibration offset: %d", offset);
     }
+    nvs_close(nvs_handle);
 }
 
-/**
- * @brief Rotary encoder event processing task
- */
-static void rotary_event_task(void *arg)
+esp_err_t buttons_set_adc_offset(int16_t offset)
 {
-    button_event_t event;
-    while (1) {
-        if (xQueueReceive(g_button_queue, &event, portMAX_DELAY)) {
-            if (g_callback) {
-                g_callback(event);
-            }
-        }
+    if (offset < -ADC_OFFSET_MAX || offset > ADC_OFFSET_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = nvs_set_i16(nvs_handle, NVS_KEY_ADC_OFFSET, offset);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
     }
+    nvs_close(nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Saving ADC offset failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    g_adc_offset = offset;
+    ESP_LOGI(TAG, "ADC ladder calibration offset set to %d", offset);
+    return ESP_OK;
+}
+
+esp_err_t buttons_calibrate_adc(button_id_t held)
+{
+    static const uint16_t levels[] = {
+        [BTN_BAND_UM] = LADDER_BAND_UM,       [BTN_BAND_VF] = LADDER_BAND_VF,
+        [BTN_STATION_1] = LADDER_STATION_1,   [BTN_STATION_2] = LADDER_STATION_2,
+        [BTN_STATION_3] = LADDER_STATION_3,   [BTN_STATION_4] = LADDER_STATION_4,
+        [BTN_STATION_5] = LADDER_STATION_5,   [BTN_DOWN] = LADDER_DOWN,
+        [BTN_UP] = LADDER_UP,
+    };
+    // BTN_UP sits at full scale, where a reading cannot show a positive error
+    if (held == BTN_ROTARY || held == BTN_UP || held >= sizeof(levels) / sizeof(levels[0])) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int offset = levels[held] - g_adc_last_reading;
+    ESP_LOGI(TAG, "Calibrating on button %d: read %d, expected %d",
+             held, g_adc_last_reading, levels[held]);
+    return buttons_set_adc_offset((int16_t)LADDER_MAX(-32768, LADDER_MIN(32767, offset)));
 }
 
 /**
@@ -326,29 +816,32 @@ esp_err_t buttons_init(int adc_pin, int rotary_clk, int rotary_dt, int rotary_sw
         return ESP_ERR_NO_MEM;
     }
     
-    // Initialize ADC
-    adc_oneshot_unit_init_cfg_t init_config = {
-        .unit_id = ADC_UNIT_1,
-    };
-    ret = adc_oneshot_new_unit(&init_config, &adc_handle);
+    adc_channel = ADC_CHANNEL_6;  // GPIO34 = ADC1_CH6
+    load_adc_calibration();
+    
+    ret = adc_ladder_init(ADC_UNIT_1, adc_channel);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "ADC init failed: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    // Configure ADC channel
-    adc_channel = ADC_CHANNEL_6;  // GPIO34 = ADC1_CH6
-    adc_oneshot_chan_cfg_t config = {
-        .bitwidth = ADC_BITWIDTH_12,
-        .atten = ADC_ATTEN_DB_12  // 0-3.3V range
-    };
-    ret = adc_oneshot_config_channel(adc_handle, adc_channel, &config);
+#if CONFIG_CAR_STEREO_ROTARY_PCNT
+    // Encoder phases go to the pulse counter; only the switch needs a GPIO interrupt
+    ret = rotary_pcnt_init(rotary_clk, rotary_dt);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "ADC channel config failed: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "PCNT rotary init failed: %s", esp_err_to_name(ret));
         return ret;
     }
-    
-     // Configure rotary encoder pins - IMPORTANT: Use interrupt on BOTH edges
+    gpio_config_t encoder_conf = {
+        .pin_bit_mask = (1ULL << rotary_clk) | (1ULL << rotary_dt),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    gpio_config(&encoder_conf);
+#else
+    // Configure rotary encoder pins - IMPORTANT: Use interrupt on BOTH edges
     gpio_config_t encoder_conf = {
         .pin_bit_mask = (1ULL << rotary_clk) | (1ULL << rotary_dt),
         .mode = GPIO_MODE_INPUT,
@@ -357,6 +850,7 @@ esp_err_t buttons_init(int adc_pin, int rotary_clk, int rotary_dt, int rotary_sw
         .intr_type = GPIO_INTR_ANYEDGE  // Trigger on BOTH edges for quadrature
     };
     gpio_config(&encoder_conf);
+#endif
     
     // Configure rotary switch button pin
     gpio_config_t sw_conf = {
@@ -371,23 +865,61 @@ esp_err_t buttons_init(int adc_pin, int rotary_clk, int rotary_dt, int rotary_sw
     // Install GPIO ISR service
     gpio_install_isr_service(0);
     
+#if CONFIG_CAR_STEREO_ROTARY_PCNT
+    gpio_isr_handler_add(rotary_sw, rotary_switch_isr, NULL);
+#else
     // Attach ISRs - BOTH encoder pins use same ISR
     gpio_isr_handler_add(rotary_clk, rotary_encoder_isr, NULL);
     gpio_isr_handler_add(rotary_dt, rotary_encoder_isr, NULL);
     gpio_isr_handler_add(rotary_sw, rotary_encoder_isr, NULL);
+#endif
     
-    // Start button monitoring task
-    xTaskCreate(adc_button_monitor_task, "button_monitor", 4096, NULL, 5, NULL);
-    
-    // Start rotary event processing task
-    xTaskCreate(rotary_event_task, "rotary_event", 4096, NULL, 5, NULL);
-    
-    // Start rotary push long press task
-    xTaskCreate(button_long_press_monitor_task, "btn_monitor", 3072, NULL, 5, NULL);
+    // One task serves the rotary queue, the ADC ladder and long presses
+    if (!xTaskCreateStaticPinnedToCore(input_task, "input", TASK_INPUT_STACK, NULL,
+                                       TASK_INPUT_PRIO, g_input_stack, &g_input_tcb,
+                                       TASK_INPUT_CORE)) {
+        ESP_LOGE(TAG, "Failed to create input task");
+        return ESP_ERR_NO_MEM;
+    }
     
     ESP_LOGI(TAG, "Button system initialized");
     ESP_LOGI(TAG, "  ADC pin: GPIO%d, Rotary: CLK=%d, DT=%d, SW=%d", 
              adc_pin, rotary_clk, rotary_dt, rotary_sw);
     
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+void buttons_get_stats(buttons_stats_t *stats)
+{
+    // Unlocked: the counters only grow, a racing read is at most one event behind
+    *stats = g_stats;
+}
+
+void buttons_set_standby(bool standby)
+{
+    if (standby == g_standby) return;
+    g_standby = standby;
+    
+#if CONFIG_CAR_STEREO_BUTTONS_ADC_CONTINUOUS
+    esp_err_t ret = !g_adc_dma ? ESP_OK :
+                    standby ? adc_continuous_stop(adc_cont_handle) :
+                              adc_continuous_start(adc_cont_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "ADC %s failed: %s", standby ? "stop" : "start", esp_err_to_name(ret));
+    }
+#endif
+    
+    if (standby) {
+        // Edge interrupts do not run in light sleep; a low level wakes the CPU
+        portENTER_CRITICAL(&g_wake_lock);
+        g_wake_armed = true;
+        portEXIT_CRITICAL(&g_wake_lock);
+        gpio_wakeup_enable(g_rotary_sw_pin, GPIO_INTR_LOW_LEVEL);
+    } else {
+        rotary_switch_rearm();
+        // The input task may be blocked without a deadline; restart its polling
+        button_event_t wake = { .button = BTN_NONE, .event = BTN_EVENT_WAKE };
+        xQueueSend(g_button_queue, &wake, 0);
+    }
+    ESP_LOGI(TAG, "Input %s", standby ? "standby (rotary switch only)" : "active");
+}
@@ -40,7 +40,11 @@ typedef enum {
 typedef struct {
     button_id_t button;
     button_event_type_t event;
-    uint32_t timestamp;
+    uint32_t timestamp;     // ms since boot of the (last) edge behind this event
+    uint32_t origin_us;     // trace_now() of the (first) edge or ADC frame, for latency traces
+    uint8_t detents;        // Rotary: physical detents folded into this event (>= 1)
+    uint8_t steps;          // Rotary: detents scaled by spin speed, for coarse browsing
+    uint16_t velocity;      // Rotary: spin speed in detents per second
 } button_event_t;
 
 // Button event callback
@@ -69,6 +73,57 @@ int32_t buttons_get_rotary_position(void);
  */
 void buttons_reset_rotary_position(void);
 
+/**
+ * @brief Enter or leave input standby
+ * 
+ * In standby the input task stops sampling the ADC ladder and blocks
+ * until a rotary event; only the rotary switch stays armed, as a GPIO wake source for
+ * light sleep (enable it with esp_sleep_enable_gpio_wakeup()). Its press
+ * still produces the usual events.
+ * 
+ * @param standby true to enter standby
+ */
+void buttons_set_standby(bool standby);
+
+/**
+ * @brief Store a per-unit ADC ladder calibration offset in NVS
+ * 
+ * The offset is added to every averaged reading before the lookup table,
+ * so ladder tolerances can be trimmed without rebuilding. It is loaded
+ * by buttons_init().
+ * 
+ * @param offset ADC counts to add (-300 to 300)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if out of range
+ */
+esp_err_t buttons_set_adc_offset(int16_t offset);
+
+/**
+ * @brief Calibrate the ADC ladder against a button being held right now
+ * 
+ * Stores the difference between the button's nominal level and the last
+ * averaged reading as the offset. Any ladder button but BTN_UP, which sits
+ * at full scale.
+ * 
+ * @param held Button currently held down
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an unusable button or
+ *         a reading too far off to be that button
+ */
+esp_err_t buttons_calibrate_adc(button_id_t held);
+
+/**
+ * @brief Input counters since boot
+ */
+typedef struct {
+    uint32_t events;            // Events handed to the callback
+    uint8_t queue_depth_max;    // Most raw events waiting in the input queue
+} buttons_stats_t;
+
+/**
+ * @brief Snapshot the input counters
+ * @param stats Receives the counters
+ */
+void buttons_get_stats(buttons_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
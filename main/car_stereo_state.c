@@ -4,18 +4,34 @@
  */
 
 #include "car_stereo_state.h"
+#include "sdkconfig.h"
+#include "phonebook_store.h"
+#include "source.h"
+#include "task_map.h"
+#include "trace.h"
+#include "deferred_log.h"
 #include "a2dpSinkHfpHf.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_rom_crc.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
 #include <string.h>
 
 #define TAG "STEREO_STATE"
 #define NVS_NAMESPACE "car_stereo"
 
 // NVS Keys
+#define NVS_KEY_STATE           "state"         // persisted_state_t blob
+#define NVS_KEY_BT_PROFILE      "btp_%08lx"     // One persisted_bt_profile_t per MAC hash
+
+// Legacy per-value keys, only read to migrate older installs
 #define NVS_KEY_POWER_ON        "power_on"
 #define NVS_KEY_MODE            "mode"
 #define NVS_KEY_RADIO_BAND      "radio_band"
@@ -36,17 +52,90 @@
 #define NVS_KEY_PRESET_AM_5     "preset_am_5"
 #define NVS_KEY_BT_DEV_COUNT    "bt_dev_cnt"
 #define NVS_KEY_BT_DEV_PREFIX   "bt_dev_"
+#define NVS_KEY_BT_DEVICES      "bt_devices"    // persisted_bt_devices_t blob
 
-#define MAX_BT_DEVICES 5
+#define MAX_BT_DEVICES 5            // Legacy layouts only
+#define BT_PROFILE_MAX 16           // Paired phones remembered, LRU beyond that
+#define BT_PROFILE_SLOTS 32         // Hash index size, power of two >= 2x BT_PROFILE_MAX
 #define STATION_TUNE_DELAY_MS 2000
+#define NVS_SAVE_DELAY_MS 3000      // Write-behind debounce for state changes
+#define METADATA_MERGE_MS 150       // Window for folding partial AVRCP updates
+#define DEFERRED_RETRY_MS 20        // Timer re-fires after a full state queue
+#define STATE_QUEUE_LEN 16
+#define STATE_SAVE_TIMEOUT_MS 1000  // Every BT profile dirty plus the state blob, with margin
+#define NUM_PRESETS 5
+
+#define STATE_BLOB_VERSION      1
+#define BT_DEVICES_BLOB_VERSION 1
+#define BT_PROFILE_BLOB_VERSION 1
+
+// Delayed actions, each backed by one restartable one-shot esp_timer
+typedef enum {
+    DEFERRED_STATION_TUNE,      // Tune to the browsed frequency once the knob settles
+    DEFERRED_NVS_SAVE,          // Commit dirty state once changes stop coming in
+    DEFERRED_METADATA_PUBLISH,  // Show merged AVRCP fields once the burst is over
+    DEFERRED_ACTION_COUNT
+} deferred_action_t;
+
+// Everything that can change state arrives as one of these on g_state_queue
+typedef enum {
+    STATE_EVT_BUTTON,
+    STATE_EVT_SET_POWER,
+    STATE_EVT_SET_MODE,
+    STATE_EVT_CALL_STATUS,
+    STATE_EVT_RDS,
+    STATE_EVT_A2DP_METADATA,
+    STATE_EVT_A2DP_STREAMING,
+    STATE_EVT_BT_CONNECTED,
+    STATE_EVT_BT_DISCONNECTED,
+    STATE_EVT_BT_VOLUME,
+    STATE_EVT_BT_READY,
+    STATE_EVT_DEFERRED,
+    STATE_EVT_SAVE,
+    STATE_EVT_SCAN_DONE
+} state_event_type_t;
 
 typedef struct {
-    uint8_t mac_addr[6];
-    uint8_t a2dp_volume;      // A2DP volume for this device
-    uint8_t hfp_speaker_volume; // HFP speaker volume for this device
-    uint8_t hfp_mic_volume;    // HFP mic volume for this device
-    bool valid;
-} bt_device_settings_t;
+    state_event_type_t type;
+    union {
+        button_event_t button;
+        bool on;                // SET_POWER, A2DP_STREAMING
+        stereo_mode_t mode;     // SET_MODE
+        struct {
+            deferred_action_t action;
+            uint32_t gen;       // Schedule it fired for; stale if rescheduled since
+        } deferred;
+        uint16_t station_count; // SCAN_DONE
+        uint32_t save_seq;      // SAVE
+        struct {
+            bool active;
+            bool has_caller_id;
+            char caller_id[64];
+        } call;
+        struct {
+            bool has_station;
+            bool has_song;
+            char station[32];
+            char song[64];
+        } rds;
+        struct {
+            bool has_title;
+            bool has_artist;
+            bool has_album;
+            char title[64];
+            char artist[64];
+            char album[64];
+        } metadata;
+        struct {
+            bool has_addr;
+            uint8_t addr[6];
+        } bt;
+        struct {
+            bt_volume_target_t target;
+            uint8_t volume;
+        } volume;
+    };
+} state_event_t;
 
 // Global state
 static bool g_powered_on = false;
@@ -59,190 +148,631 @@ static hfp_state_t g_hfp_state;
 static phonebook_state_t g_phonebook_state;
 static stereo_config_t g_config;
 static radio_band_t g_current_band = RADIO_BAND_FM;
-static bt_device_settings_t g_bt_devices[MAX_BT_DEVICES];
 static uint8_t g_current_bt_device_mac[6] = {0};
+static bool g_bt_device_connected = false;
+static bool g_bt_ready = false;             // BT stack up; BT commands are dropped before
+static uint32_t g_track_hash = 0;           // text_hash() of the title playing
+static uint32_t g_track_pos_ms = 0;         // Position reached at g_track_since
+static int64_t g_track_since = 0;           // Streaming since (esp_timer us), 0 = not
 static bool g_browsing_stations = false;
-static uint8_t g_browsing_station_idx = 0;
-static float g_browsing_station_freq = 87.5;
-static TaskHandle_t g_station_tune_timer = NULL;
+static int g_browsing_station_idx = 0;      // Index entry, or FM grid channel if the index is empty
+static station_entry_t g_radio_station;     // Last station selected (kind FM = follow g_radio_state.frequency)
 static bool g_voice_command_active = false;
 static char g_caller_id[64] = {0};
 static bool g_voice_recognition_active = false;
 
+static esp_timer_handle_t g_deferred_timers[DEFERRED_ACTION_COUNT];
+static uint32_t g_deferred_gen[DEFERRED_ACTION_COUNT];      // Bumped by schedule/cancel, read by the timer task
+static bool g_deferred_pending[DEFERRED_ACTION_COUNT];      // Scheduled and not yet run or cancelled
+static QueueHandle_t g_state_queue = NULL;
+static stereo_state_stats_t g_stats;        // Written by the state task only
+#if !CONFIG_IDF_TARGET_LINUX
+static StackType_t g_state_stack[TASK_STATE_STACK];
+static StaticTask_t g_state_tcb;
+#endif
+static TaskHandle_t g_state_task = NULL;
+static SemaphoreHandle_t g_save_lock = NULL;    // One stereo_state_save() caller at a time
+static SemaphoreHandle_t g_save_done = NULL;    // Given by the state task after each SAVE
+static uint32_t g_save_seq = 0;                 // Last SAVE posted (under g_save_lock)
+static volatile uint32_t g_save_done_seq = 0;   // Newest SAVE flushed (state task)
+
+// Persisted state exactly as stored in NVS (one blob, one read at boot).
+// Field order keeps everything naturally aligned so there is no padding.
+typedef struct {
+    uint8_t version;            // STATE_BLOB_VERSION
+    uint8_t power_on;
+    uint8_t mode;
+    uint8_t radio_band;
+    uint32_t radio_freq;        // Frequency * 100
+    uint8_t radio_vol;
+    uint8_t a2dp_vol;
+    uint8_t hfp_spk_vol;
+    uint8_t hfp_mic_vol;
+    uint32_t presets[RADIO_BAND_COUNT][NUM_PRESETS];
+    uint32_t crc;               // CRC32 of everything above
+} persisted_state_t;
+
+typedef struct {
+    uint8_t mac_addr[6];
+    uint8_t a2dp_volume;
+    uint8_t hfp_speaker_volume;
+    uint8_t hfp_mic_volume;
+    uint8_t valid;
+} persisted_bt_device_t;
+
+typedef struct {
+    uint8_t version;            // BT_DEVICES_BLOB_VERSION
+    uint8_t reserved[3];
+    persisted_bt_device_t devices[MAX_BT_DEVICES];
+    uint8_t pad[2];
+    uint32_t crc;               // CRC32 of everything above
+} persisted_bt_devices_t;
+
+// Everything a phone gets back when it reconnects, one NVS key per phone
+typedef struct {
+    uint8_t version;            // BT_PROFILE_BLOB_VERSION
+    uint8_t mac_addr[6];
+    uint8_t a2dp_volume;
+    uint8_t hfp_speaker_volume;
+    uint8_t hfp_mic_volume;
+    uint8_t last_mode;          // Media mode in use with this phone (RADIO/BLUETOOTH)
+    uint8_t station_kind;       // Last radio source: station_kind_t ...
+    uint32_t station_khz;       // ... frequency or DAB ensemble
+    uint32_t service_id;        // ... DAB service (0 for FM)
+    uint16_t component_id;
+    uint8_t reserved[2];
+    uint32_t track_hash;        // text_hash() of the last title played
+    uint32_t track_pos_ms;      // How far into that title playback got
+    uint32_t last_used;         // LRU sequence number, higher = more recent
+    uint32_t crc;               // CRC32 of everything above
+} persisted_bt_profile_t;
+
+_Static_assert(sizeof(persisted_state_t) == 56, "persisted_state_t layout changed: bump STATE_BLOB_VERSION");
+_Static_assert(sizeof(persisted_bt_devices_t) == 60, "persisted_bt_devices_t layout changed: bump BT_DEVICES_BLOB_VERSION");
+_Static_assert(sizeof(persisted_bt_profile_t) == 40, "persisted_bt_profile_t layout changed: bump BT_PROFILE_BLOB_VERSION");
+
+typedef struct {
+    persisted_bt_profile_t rec;
+    uint32_t hash;              // MAC hash: index probe start and NVS key
+    bool valid;
+    bool dirty;                 // rec differs from flash
+} bt_profile_t;
+
+static persisted_state_t g_nvs_snapshot;    // What is currently in flash
+static bool g_nvs_snapshot_valid = false;
+static bt_profile_t g_bt_profiles[BT_PROFILE_MAX];
+static int8_t g_bt_profile_slots[BT_PROFILE_SLOTS];    // Open addressing, -1 = empty
+static uint32_t g_bt_profile_seq = 0;       // Highest last_used handed out
+
+static const char *const g_preset_keys[RADIO_BAND_COUNT][NUM_PRESETS] = {
+    [RADIO_BAND_FM] = { NVS_KEY_PRESET_FM_1, NVS_KEY_PRESET_FM_2, NVS_KEY_PRESET_FM_3,
+                        NVS_KEY_PRESET_FM_4, NVS_KEY_PRESET_FM_5 },
+    [RADIO_BAND_AM] = { NVS_KEY_PRESET_AM_1, NVS_KEY_PRESET_AM_2, NVS_KEY_PRESET_AM_3,
+                        NVS_KEY_PRESET_AM_4, NVS_KEY_PRESET_AM_5 },
+};
+
 // Forward declarations
 static void save_to_nvs(void);
+static void flush_nvs(void);
+#if !CONFIG_IDF_TARGET_LINUX
+static void shutdown_flush(void);
+#endif
+static void bt_profile_capture(int idx);
+static esp_err_t bt_profiles_flush(void);
+static int find_bt_profile(const uint8_t *mac);
+static uint32_t radio_freq_khz(void);
+static void station_tune_fire(void);
+static void metadata_publish(void);
+static void rds_reset(void);
+static void apply_set_mode(stereo_mode_t mode);
+static void deferred_schedule(deferred_action_t action, uint32_t delay_ms);
+static void deferred_cancel(deferred_action_t action);
 static void on_bt_volume_changed(bt_volume_target_t target, uint8_t new_volume);
+static void on_station_scan_done(size_t count);
+static bool state_post(const state_event_t *event);
+static void state_loop_start(void);
+#if !CONFIG_IDF_TARGET_LINUX
+static void state_task(void *arg);
+#endif
 
 // ============================================================================
-// NVS PERSISTENCE - GENERAL STATE
+// NVS PERSISTENCE - BLOB HELPERS
 // ============================================================================
 
-static void save_to_nvs(void)
+// CRC over a blob, excluding its trailing 32-bit crc field
+static uint32_t blob_crc(const void *blob, size_t size)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)blob, size - sizeof(uint32_t));
+}
+
+// Read a versioned blob; ESP_ERR_NVS_NOT_FOUND means "migrate from legacy keys"
+static esp_err_t read_blob(nvs_handle_t nvs_handle, const char *key, void *blob,
+                           size_t size, uint8_t version)
+{
+    size_t len = size;
+    esp_err_t err = nvs_get_blob(nvs_handle, key, blob, &len);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (len != size || *(const uint8_t *)blob != version) {
+        ESP_LOGW(TAG, "Blob '%s' has unknown layout (len %u, v%u)",
+                 key, (unsigned)len, *(const uint8_t *)blob);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    uint32_t crc;
+    memcpy(&crc, (const uint8_t *)blob + size - sizeof(crc), sizeof(crc));
+    if (crc != blob_crc(blob, size)) {
+        ESP_LOGW(TAG, "Blob '%s' failed CRC check", key);
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+// Write a blob and commit it in one go
+static esp_err_t write_blob(const char *key, const void *blob, size_t size)
 {
     nvs_handle_t nvs_handle;
     esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
-    
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    uint32_t t0 = trace_now();
+    err = nvs_set_blob(nvs_handle, key, blob, size);
     if (err == ESP_OK) {
-        nvs_set_u8(nvs_handle, NVS_KEY_POWER_ON, g_powered_on ? 1 : 0);
-        nvs_set_u8(nvs_handle, NVS_KEY_MODE, (uint8_t)g_current_mode);
-        nvs_set_u8(nvs_handle, NVS_KEY_RADIO_BAND, (uint8_t)g_current_band);
-        nvs_set_u32(nvs_handle, NVS_KEY_RADIO_FREQ, (uint32_t)(g_radio_state.frequency * 100));
-        nvs_set_u8(nvs_handle, NVS_KEY_RADIO_VOL, g_radio_state.volume);
-        
-        // A2DP volume
-        nvs_set_u8(nvs_handle, NVS_KEY_A2DP_VOL, g_a2dp_state.volume);
-        
-        // HFP volumes
-        nvs_set_u8(nvs_handle, NVS_KEY_HFP_SPK_VOL, g_hfp_state.speaker_volume);
-        nvs_set_u8(nvs_handle, NVS_KEY_HFP_MIC_VOL, g_hfp_state.mic_volume);
-        
-        // FM presets
-        nvs_set_u32(nvs_handle, NVS_KEY_PRESET_FM_1, (uint32_t)(g_radio_state.preset_freq[RADIO_BAND_FM][0] * 100));
-        nvs_set_u32(nvs_handle, NVS_KEY_PRESET_FM_2, (uint32_t)(g_radio_state.preset_freq[RADIO_BAND_FM][1] * 100));
-        nvs_set_u32(nvs_handle, NVS_KEY_PRESET_FM_3, (uint32_t)(g_radio_state.preset_freq[RADIO_BAND_FM][2] * 100));
-        nvs_set_u32(nvs_handle, NVS_KEY_PRESET_FM_4, (uint32_t)(g_radio_state.preset_freq[RADIO_BAND_FM][3] * 100));
-        nvs_set_u32(nvs_handle, NVS_KEY_PRESET_FM_5, (uint32_t)(g_radio_state.preset_freq[RADIO_BAND_FM][4] * 100));
-        
-        // AM presets
-        nvs_set_u32(nvs_handle, NVS_KEY_PRESET_AM_1, (uint32_t)(g_radio_state.preset_freq[RADIO_BAND_AM][0] * 100));
-        nvs_set_u32(nvs_handle, NVS_KEY_PRESET_AM_2, (uint32_t)(g_radio_state.preset_freq[RADIO_BAND_AM][1] * 100));
-        nvs_set_u32(nvs_handle, NVS_KEY_PRESET_AM_3, (uint32_t)(g_radio_state.preset_freq[RADIO_BAND_AM][2] * 100));
-        nvs_set_u32(nvs_handle, NVS_KEY_PRESET_AM_4, (uint32_t)(g_radio_state.preset_freq[RADIO_BAND_AM][3] * 100));
-        nvs_set_u32(nvs_handle, NVS_KEY_PRESET_AM_5, (uint32_t)(g_radio_state.preset_freq[RADIO_BAND_AM][4] * 100));
-        
-        nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
+        err = nvs_commit(nvs_handle);
+        g_stats.nvs_commits++;
+    }
+    nvs_close(nvs_handle);
+    trace_record(TRACE_NVS_COMMIT, t0);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Writing '%s' failed: %s", key, esp_err_to_name(err));
+    }
+    return err;
+}
+
+// ============================================================================
+// NVS PERSISTENCE - GENERAL STATE
+// ============================================================================
+
+static void capture_nvs_snapshot(persisted_state_t *snap)
+{
+    memset(snap, 0, sizeof(*snap));
+    snap->version = STATE_BLOB_VERSION;
+    snap->power_on = g_powered_on ? 1 : 0;
+    snap->mode = (uint8_t)g_current_mode;
+    snap->radio_band = (uint8_t)g_current_band;
+    snap->radio_freq = (uint32_t)(g_radio_state.frequency * 100);
+    snap->radio_vol = g_radio_state.volume;
+    snap->a2dp_vol = g_a2dp_state.volume;
+    snap->hfp_spk_vol = g_hfp_state.speaker_volume;
+    snap->hfp_mic_vol = g_hfp_state.mic_volume;
+    for (int band = 0; band < RADIO_BAND_COUNT; band++) {
+        for (int i = 0; i < NUM_PRESETS; i++) {
+            snap->presets[band][i] = (uint32_t)(g_radio_state.preset_freq[band][i] * 100);
+        }
+    }
+    snap->crc = blob_crc(snap, sizeof(*snap));
+}
+
+static void apply_nvs_snapshot(const persisted_state_t *snap)
+{
+    g_powered_on = (snap->power_on != 0);
+    g_current_mode = (stereo_mode_t)snap->mode;
+    g_current_band = (radio_band_t)snap->radio_band;
+    g_radio_state.band = g_current_band;
+    g_radio_state.frequency = snap->radio_freq / 100.0f;
+    g_radio_state.volume = snap->radio_vol;
+    g_a2dp_state.volume = snap->a2dp_vol;
+    g_hfp_state.speaker_volume = snap->hfp_spk_vol;
+    g_hfp_state.mic_volume = snap->hfp_mic_vol;
+    for (int band = 0; band < RADIO_BAND_COUNT; band++) {
+        for (int i = 0; i < NUM_PRESETS; i++) {
+            g_radio_state.preset_freq[band][i] = snap->presets[band][i] / 100.0f;
+        }
+    }
+}
+
+// Mark state dirty; the actual write happens NVS_SAVE_DELAY_MS after the last change
+static void save_to_nvs(void)
+{
+    deferred_schedule(DEFERRED_NVS_SAVE, NVS_SAVE_DELAY_MS);
+}
+
+// Write the state blob if it differs from what is already in flash
+static void flush_nvs(void)
+{
+    deferred_cancel(DEFERRED_NVS_SAVE);
+    station_index_flush();
+    
+    // The ignition can cut power without a disconnect ever arriving
+    if (g_bt_device_connected) {
+        int idx = find_bt_profile(g_current_bt_device_mac);
+        if (idx >= 0) bt_profile_capture(idx);
+    }
+    bt_profiles_flush();
+    
+    persisted_state_t snap;
+    capture_nvs_snapshot(&snap);
+    if (g_nvs_snapshot_valid && memcmp(&snap, &g_nvs_snapshot, sizeof(snap)) == 0) {
+        return;
+    }
+    
+    if (write_blob(NVS_KEY_STATE, &snap, sizeof(snap)) == ESP_OK) {
+        g_nvs_snapshot = snap;
+        g_nvs_snapshot_valid = true;
         ESP_LOGD(TAG, "State saved to NVS");
     }
 }
 
+// Pre-blob layout: one key per value. Returns true if anything was found.
+static bool load_legacy_state(nvs_handle_t nvs_handle)
+{
+    uint8_t u8val;
+    uint32_t u32val;
+    bool found = false;
+    
+    if (nvs_get_u8(nvs_handle, NVS_KEY_POWER_ON, &u8val) == ESP_OK) { g_powered_on = (u8val != 0); found = true; }
+    if (nvs_get_u8(nvs_handle, NVS_KEY_MODE, &u8val) == ESP_OK) { g_current_mode = (stereo_mode_t)u8val; found = true; }
+    if (nvs_get_u8(nvs_handle, NVS_KEY_RADIO_BAND, &u8val) == ESP_OK) {
+        g_current_band = (radio_band_t)u8val;
+        g_radio_state.band = g_current_band;
+        found = true;
+    }
+    if (nvs_get_u32(nvs_handle, NVS_KEY_RADIO_FREQ, &u32val) == ESP_OK) { g_radio_state.frequency = u32val / 100.0f; found = true; }
+    if (nvs_get_u8(nvs_handle, NVS_KEY_RADIO_VOL, &u8val) == ESP_OK) { g_radio_state.volume = u8val; found = true; }
+    
+    for (int band = 0; band < RADIO_BAND_COUNT; band++) {
+        for (int i = 0; i < NUM_PRESETS; i++) {
+            if (nvs_get_u32(nvs_handle, g_preset_keys[band][i], &u32val) == ESP_OK) {
+                g_radio_state.preset_freq[band][i] = u32val / 100.0f;
+                found = true;
+            }
+        }
+    }
+    
+    if (nvs_get_u8(nvs_handle, NVS_KEY_A2DP_VOL, &u8val) == ESP_OK) { g_a2dp_state.volume = u8val; found = true; }
+    if (nvs_get_u8(nvs_handle, NVS_KEY_HFP_SPK_VOL, &u8val) == ESP_OK) { g_hfp_state.speaker_volume = u8val; found = true; }
+    if (nvs_get_u8(nvs_handle, NVS_KEY_HFP_MIC_VOL, &u8val) == ESP_OK) { g_hfp_state.mic_volume = u8val; found = true; }
+    
+    return found;
+}
+
+static void erase_legacy_state(void)
+{
+    static const char *const keys[] = {
+        NVS_KEY_POWER_ON, NVS_KEY_MODE, NVS_KEY_RADIO_BAND, NVS_KEY_RADIO_FREQ,
+        NVS_KEY_RADIO_VOL, NVS_KEY_A2DP_VOL, NVS_KEY_HFP_SPK_VOL, NVS_KEY_HFP_MIC_VOL,
+    };
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) != ESP_OK) return;
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        nvs_erase_key(nvs_handle, keys[i]);
+    }
+    for (int band = 0; band < RADIO_BAND_COUNT; band++) {
+        for (int i = 0; i < NUM_PRESETS; i++) {
+            nvs_erase_key(nvs_handle, g_preset_keys[band][i]);
+        }
+    }
+    nvs_commit(nvs_handle);
+    g_stats.nvs_commits++;
+    nvs_close(nvs_handle);
+}
+
 static void load_from_nvs(void)
 {
     nvs_handle_t nvs_handle;
     esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
     
-    if (err == ESP_OK) {
-        uint8_t u8val;
-        uint32_t u32val;
-        
-        if (nvs_get_u8(nvs_handle, NVS_KEY_POWER_ON, &u8val) == ESP_OK) g_powered_on = (u8val != 0);
-        if (nvs_get_u8(nvs_handle, NVS_KEY_MODE, &u8val) == ESP_OK) g_current_mode = (stereo_mode_t)u8val;
-        if (nvs_get_u8(nvs_handle, NVS_KEY_RADIO_BAND, &u8val) == ESP_OK) {
-            g_current_band = (radio_band_t)u8val;
-            g_radio_state.band = g_current_band;
-        }
-        if (nvs_get_u32(nvs_handle, NVS_KEY_RADIO_FREQ, &u32val) == ESP_OK) g_radio_state.frequency = u32val / 100.0f;
-        if (nvs_get_u8(nvs_handle, NVS_KEY_RADIO_VOL, &u8val) == ESP_OK) g_radio_state.volume = u8val;
-        
-        // FM presets
-        if (nvs_get_u32(nvs_handle, NVS_KEY_PRESET_FM_1, &u32val) == ESP_OK) g_radio_state.preset_freq[RADIO_BAND_FM][0] = u32val / 100.0f;
-        if (nvs_get_u32(nvs_handle, NVS_KEY_PRESET_FM_2, &u32val) == ESP_OK) g_radio_state.preset_freq[RADIO_BAND_FM][1] = u32val / 100.0f;
-        if (nvs_get_u32(nvs_handle, NVS_KEY_PRESET_FM_3, &u32val) == ESP_OK) g_radio_state.preset_freq[RADIO_BAND_FM][2] = u32val / 100.0f;
-        if (nvs_get_u32(nvs_handle, NVS_KEY_PRESET_FM_4, &u32val) == ESP_OK) g_radio_state.preset_freq[RADIO_BAND_FM][3] = u32val / 100.0f;
-        if (nvs_get_u32(nvs_handle, NVS_KEY_PRESET_FM_5, &u32val) == ESP_OK) g_radio_state.preset_freq[RADIO_BAND_FM][4] = u32val / 100.0f;
-        
-        // AM presets
-        if (nvs_get_u32(nvs_handle, NVS_KEY_PRESET_AM_1, &u32val) == ESP_OK) g_radio_state.preset_freq[RADIO_BAND_AM][0] = u32val / 100.0f;
-        if (nvs_get_u32(nvs_handle, NVS_KEY_PRESET_AM_2, &u32val) == ESP_OK) g_radio_state.preset_freq[RADIO_BAND_AM][1] = u32val / 100.0f;
-        if (nvs_get_u32(nvs_handle, NVS_KEY_PRESET_AM_3, &u32val) == ESP_OK) g_radio_state.preset_freq[RADIO_BAND_AM][2] = u32val / 100.0f;
-        if (nvs_get_u32(nvs_handle, NVS_KEY_PRESET_AM_4, &u32val) == ESP_OK) g_radio_state.preset_freq[RADIO_BAND_AM][3] = u32val / 100.0f;
-        if (nvs_get_u32(nvs_handle, NVS_KEY_PRESET_AM_5, &u32val) == ESP_OK) g_radio_state.preset_freq[RADIO_BAND_AM][4] = u32val / 100.0f;
-        
-        // A2DP volume
-        if (nvs_get_u8(nvs_handle, NVS_KEY_A2DP_VOL, &u8val) == ESP_OK)
-            g_a2dp_state.volume = u8val;
-            
-        // HFP volumes
-        if (nvs_get_u8(nvs_handle, NVS_KEY_HFP_SPK_VOL, &u8val) == ESP_OK)
-            g_hfp_state.speaker_volume = u8val;
-        if (nvs_get_u8(nvs_handle, NVS_KEY_HFP_MIC_VOL, &u8val) == ESP_OK)
-            g_hfp_state.mic_volume = u8val;
-        
-        nvs_close(nvs_handle);
-        ESP_LOGI(TAG, "State loaded - Power: %s, Mode: %d, Band: %s",
-                 g_powered_on ? "ON" : "OFF", g_current_mode,
-                 g_current_band == RADIO_BAND_FM ? "FM" : "AM");
-    } else {
+    if (err != ESP_OK) {
         ESP_LOGI(TAG, "No saved state, using defaults");
         g_powered_on = false;
         g_current_mode = MODE_OFF;
+        return;
+    }
+    
+    persisted_state_t snap;
+    err = read_blob(nvs_handle, NVS_KEY_STATE, &snap, sizeof(snap), STATE_BLOB_VERSION);
+    bool migrate = false;
+    if (err == ESP_OK) {
+        apply_nvs_snapshot(&snap);
+        g_nvs_snapshot = snap;
+        g_nvs_snapshot_valid = true;
+    } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+        migrate = load_legacy_state(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    
+    if (migrate) {
+        ESP_LOGI(TAG, "Migrating legacy NVS keys to state blob v%d", STATE_BLOB_VERSION);
+        flush_nvs();
+        if (g_nvs_snapshot_valid) erase_legacy_state();
     }
+    
+    ESP_LOGI(TAG, "State loaded - Power: %s, Mode: %d, Band: %s",
+             g_powered_on ? "ON" : "OFF", g_current_mode,
+             g_current_band == RADIO_BAND_FM ? "FM" : "AM");
 }
 
 // ============================================================================
-// NVS PERSISTENCE - BLUETOOTH DEVICE SETTINGS
+// NVS PERSISTENCE - BLUETOOTH DEVICE PROFILES
 // ============================================================================
 
-static void save_bt_device_settings(void)
+// Profiles are found through a hash of the MAC (O(1) index probe) and each
+// lives under its own NVS key, so a disconnect commits one 40-byte record
+// instead of every device. When the table is full the least recently used
+// phone is forgotten.
+
+static uint32_t bt_mac_hash(const uint8_t *mac)
+{
+    return esp_rom_crc32_le(0, mac, 6);
+}
+
+static void bt_profile_key(uint32_t hash, char key[16])
+{
+    snprintf(key, 16, NVS_KEY_BT_PROFILE, (unsigned long)hash);
+}
+
+static void bt_profile_index_rebuild(void)
+{
+    memset(g_bt_profile_slots, -1, sizeof(g_bt_profile_slots));
+    for (int i = 0; i < BT_PROFILE_MAX; i++) {
+        if (!g_bt_profiles[i].valid) continue;
+        uint32_t slot = g_bt_profiles[i].hash;
+        while (g_bt_profile_slots[slot & (BT_PROFILE_SLOTS - 1)] >= 0) slot++;
+        g_bt_profile_slots[slot & (BT_PROFILE_SLOTS - 1)] = (int8_t)i;
+    }
+}
+
+static int find_bt_profile(const uint8_t *mac)
+{
+    uint32_t hash = bt_mac_hash(mac);
+    for (uint32_t slot = hash; ; slot++) {
+        int idx = g_bt_profile_slots[slot & (BT_PROFILE_SLOTS - 1)];
+        if (idx < 0) return -1;
+        const bt_profile_t *p = &g_bt_profiles[idx];
+        if (p->hash == hash && memcmp(p->rec.mac_addr, mac, 6) == 0) return idx;
+    }
+}
+
+static void bt_profile_touch(int idx)
+{
+    g_bt_profiles[idx].rec.last_used = ++g_bt_profile_seq;
+    g_bt_profiles[idx].dirty = true;
+}
+
+static void bt_profile_erase(uint32_t hash)
 {
     nvs_handle_t nvs_handle;
-    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) == ESP_OK) {
-        uint8_t count = 0;
-        for (int i = 0; i < MAX_BT_DEVICES; i++) {
-            if (g_bt_devices[i].valid) {
-                count++;
-                char key[16];
-                snprintf(key, sizeof(key), "%s%d", NVS_KEY_BT_DEV_PREFIX, i);
-                
-                // Pack into blob: 6 bytes MAC + 3 bytes volumes
-                uint8_t blob[9];
-                memcpy(blob, g_bt_devices[i].mac_addr, 6);
-                blob[6] = g_bt_devices[i].a2dp_volume;
-                blob[7] = g_bt_devices[i].hfp_speaker_volume;
-                blob[8] = g_bt_devices[i].hfp_mic_volume;
-                
-                nvs_set_blob(nvs_handle, key, blob, sizeof(blob));
-            }
-        }
-        nvs_set_u8(nvs_handle, NVS_KEY_BT_DEV_COUNT, count);
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) != ESP_OK) return;
+    char key[16];
+    bt_profile_key(hash, key);
+    if (nvs_erase_key(nvs_handle, key) == ESP_OK) {
         nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
-        ESP_LOGI(TAG, "Saved %d BT device settings", count);
+        g_stats.nvs_commits++;
     }
+    nvs_close(nvs_handle);
 }
 
-static void load_bt_device_settings(void)
+// New profile for mac, seeded with the current settings. Reuses a free entry,
+// else the one sharing its NVS key (hash collision), else the LRU one.
+static int bt_profile_create(const uint8_t *mac)
 {
-    nvs_handle_t nvs_handle;
-    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
-        uint8_t count = 0;
-        nvs_get_u8(nvs_handle, NVS_KEY_BT_DEV_COUNT, &count);
-        
-        for (int i = 0; i < MAX_BT_DEVICES && i < count; i++) {
-            char key[16];
-            snprintf(key, sizeof(key), "%s%d", NVS_KEY_BT_DEV_PREFIX, i);
-            
-            uint8_t blob[9];
-            size_t len = sizeof(blob);
-            if (nvs_get_blob(nvs_handle, key, blob, &len) == ESP_OK) {
-                memcpy(g_bt_devices[i].mac_addr, blob, 6);
-                g_bt_devices[i].a2dp_volume = blob[6];
-                g_bt_devices[i].hfp_speaker_volume = blob[7];
-                g_bt_devices[i].hfp_mic_volume = blob[8];
-                g_bt_devices[i].valid = true;
-            }
+    uint32_t hash = bt_mac_hash(mac);
+    int idx = -1;
+    for (int i = 0; i < BT_PROFILE_MAX; i++) {
+        const bt_profile_t *p = &g_bt_profiles[i];
+        if (p->valid && p->hash == hash) { idx = i; break; }
+        if (idx < 0 || (g_bt_profiles[idx].valid &&
+                        (!p->valid || p->rec.last_used < g_bt_profiles[idx].rec.last_used))) {
+            idx = i;
         }
-        nvs_close(nvs_handle);
-        ESP_LOGI(TAG, "Loaded %d BT device settings", count);
     }
+
+    bt_profile_t *p = &g_bt_profiles[idx];
+    if (p->valid) {
+        const uint8_t *old = p->rec.mac_addr;
+        ESP_LOGI(TAG, "Forgetting BT device %02X:%02X:%02X:%02X:%02X:%02X",
+                 old[0], old[1], old[2], old[3], old[4], old[5]);
+        if (p->hash != hash) bt_profile_erase(p->hash);
+    }
+
+    memset(p, 0, sizeof(*p));
+    p->rec.version = BT_PROFILE_BLOB_VERSION;
+    memcpy(p->rec.mac_addr, mac, 6);
+    p->rec.a2dp_volume = g_a2dp_state.volume;
+    p->rec.hfp_speaker_volume = g_hfp_state.speaker_volume;
+    p->rec.hfp_mic_volume = g_hfp_state.mic_volume;
+    p->rec.last_mode = MODE_BLUETOOTH;
+    p->hash = hash;
+    p->valid = true;
+    bt_profile_touch(idx);
+    bt_profile_index_rebuild();
+    return idx;
 }
 
-static int find_bt_device_by_mac(const uint8_t *mac)
+// Write the profiles that changed, one record (and commit) each. Returns
+// the first write error; the profiles it hit stay dirty for the next flush.
+static esp_err_t bt_profiles_flush(void)
 {
-    for (int i = 0; i < MAX_BT_DEVICES; i++) {
-        if (g_bt_devices[i].valid && memcmp(g_bt_devices[i].mac_addr, mac, 6) == 0) {
-            return i;
+    esp_err_t result = ESP_OK;
+    for (int i = 0; i < BT_PROFILE_MAX; i++) {
+        bt_profile_t *p = &g_bt_profiles[i];
+        if (!p->valid || !p->dirty) continue;
+        char key[16];
+        bt_profile_key(p->hash, key);
+        p->rec.crc = blob_crc(&p->rec, sizeof(p->rec));
+        esp_err_t err = write_blob(key, &p->rec, sizeof(p->rec));
+        if (err == ESP_OK) {
+            p->dirty = false;
+        } else if (result == ESP_OK) {
+            result = err;
         }
     }
-    return -1;
+    return result;
+}
+
+// Playback position of the current title, counted while A2DP streams: the
+// sink cannot ask the phone for it or seek, so this is the stereo's own view
+static uint32_t track_position_ms(void)
+{
+    uint32_t pos = g_track_pos_ms;
+    if (g_track_since) pos += (uint32_t)((esp_timer_get_time() - g_track_since) / 1000);
+    return pos;
+}
+
+static void track_set_streaming(bool streaming)
+{
+    g_track_pos_ms = track_position_ms();
+    g_track_since = streaming ? esp_timer_get_time() : 0;
+}
+
+// A title was published; the same one as last time resumes its position
+static void track_begin(uint32_t hash)
+{
+    if (hash == g_track_hash) return;
+    g_track_hash = hash;
+    g_track_pos_ms = 0;
+    g_track_since = g_track_since ? esp_timer_get_time() : 0;
+}
+
+// Fold the current settings into the connected phone's profile
+static void bt_profile_capture(int idx)
+{
+    persisted_bt_profile_t rec = g_bt_profiles[idx].rec;
+    rec.a2dp_volume = g_a2dp_state.volume;
+    rec.hfp_speaker_volume = g_hfp_state.speaker_volume;
+    rec.hfp_mic_volume = g_hfp_state.mic_volume;
+    if (g_current_mode == MODE_RADIO || g_current_mode == MODE_BLUETOOTH) {
+        rec.last_mode = (uint8_t)g_current_mode;
+    }
+    rec.station_kind = g_radio_station.kind;
+    rec.station_khz = g_radio_station.kind == STATION_KIND_DAB ? g_radio_station.freq_khz
+                                                               : radio_freq_khz();
+    rec.service_id = g_radio_station.kind == STATION_KIND_DAB ? g_radio_station.service_id : 0;
+    rec.component_id = g_radio_station.kind == STATION_KIND_DAB ? g_radio_station.component_id : 0;
+    rec.track_hash = g_track_hash;
+    rec.track_pos_ms = track_position_ms();
+    if (memcmp(&rec, &g_bt_profiles[idx].rec, sizeof(rec)) != 0) {
+        g_bt_profiles[idx].rec = rec;
+        g_bt_profiles[idx].dirty = true;
+    }
 }
 
-static int find_free_bt_device_slot(void)
+// Add a device from an older layout (migration only)
+static void import_bt_device(const uint8_t *mac, uint8_t a2dp_vol, uint8_t spk_vol, uint8_t mic_vol)
 {
+    int idx = find_bt_profile(mac);
+    if (idx < 0) idx = bt_profile_create(mac);
+    g_bt_profiles[idx].rec.a2dp_volume = a2dp_vol;
+    g_bt_profiles[idx].rec.hfp_speaker_volume = spk_vol;
+    g_bt_profiles[idx].rec.hfp_mic_volume = mic_vol;
+    g_bt_profiles[idx].dirty = true;
+}
+
+// Pre-profile layouts: the bt_devices blob, or before that bt_dev_cnt plus
+// one 9-byte bt_dev_N blob per device. Returns true if either was found.
+static bool load_legacy_bt_devices(nvs_handle_t nvs_handle)
+{
+    persisted_bt_devices_t blob;
+    esp_err_t err = read_blob(nvs_handle, NVS_KEY_BT_DEVICES, &blob, sizeof(blob),
+                              BT_DEVICES_BLOB_VERSION);
+    if (err == ESP_OK) {
+        for (int i = 0; i < MAX_BT_DEVICES; i++) {
+            if (!blob.devices[i].valid) continue;
+            import_bt_device(blob.devices[i].mac_addr, blob.devices[i].a2dp_volume,
+                             blob.devices[i].hfp_speaker_volume, blob.devices[i].hfp_mic_volume);
+        }
+        return true;
+    }
+    if (err != ESP_ERR_NVS_NOT_FOUND) return true;    // Unreadable: still remove it
+    
+    uint8_t count = 0;
+    if (nvs_get_u8(nvs_handle, NVS_KEY_BT_DEV_COUNT, &count) != ESP_OK) {
+        return false;
+    }
+    
+    for (int i = 0; i < MAX_BT_DEVICES && i < count; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "%s%d", NVS_KEY_BT_DEV_PREFIX, i);
+        
+        uint8_t dev[9];
+        size_t len = sizeof(dev);
+        if (nvs_get_blob(nvs_handle, key, dev, &len) == ESP_OK) {
+            import_bt_device(dev, dev[6], dev[7], dev[8]);
+        }
+    }
+    return true;
+}
+
+static void erase_legacy_bt_devices(void)
+{
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) != ESP_OK) return;
+    nvs_erase_key(nvs_handle, NVS_KEY_BT_DEVICES);
+    nvs_erase_key(nvs_handle, NVS_KEY_BT_DEV_COUNT);
     for (int i = 0; i < MAX_BT_DEVICES; i++) {
-        if (!g_bt_devices[i].valid) return i;
+        char key[16];
+        snprintf(key, sizeof(key), "%s%d", NVS_KEY_BT_DEV_PREFIX, i);
+        nvs_erase_key(nvs_handle, key);
     }
-    return 0;
+    nvs_commit(nvs_handle);
+    g_stats.nvs_commits++;
+    nvs_close(nvs_handle);
+}
+
+static void load_bt_profiles(void)
+{
+    memset(g_bt_profile_slots, -1, sizeof(g_bt_profile_slots));
+    
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    
+    int count = 0;
+    nvs_iterator_t it = NULL;
+    esp_err_t res = nvs_entry_find(NVS_DEFAULT_PART_NAME, NVS_NAMESPACE, NVS_TYPE_BLOB, &it);
+    for (; res == ESP_OK; res = nvs_entry_next(&it)) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        if (strncmp(info.key, "btp_", 4) != 0) continue;
+        if (count == BT_PROFILE_MAX) {
+            ESP_LOGW(TAG, "More than %d BT profiles stored, '%s' ignored", BT_PROFILE_MAX, info.key);
+            continue;
+        }
+        
+        bt_profile_t *p = &g_bt_profiles[count];
+        if (read_blob(nvs_handle, info.key, &p->rec, sizeof(p->rec), BT_PROFILE_BLOB_VERSION) != ESP_OK) {
+            continue;
+        }
+        p->hash = bt_mac_hash(p->rec.mac_addr);
+        char key[16];
+        bt_profile_key(p->hash, key);
+        if (strcmp(key, info.key) != 0) continue;
+        p->valid = true;
+        if (p->rec.last_used > g_bt_profile_seq) g_bt_profile_seq = p->rec.last_used;
+        count++;
+    }
+    nvs_release_iterator(it);
+    bt_profile_index_rebuild();
+    
+    bool migrate = load_legacy_bt_devices(nvs_handle);
+    nvs_close(nvs_handle);
+    
+    if (migrate) {
+        ESP_LOGI(TAG, "Migrating legacy BT device settings to profiles v%d", BT_PROFILE_BLOB_VERSION);
+        // The legacy keys are the only copy until every profile is written
+        esp_err_t err = bt_profiles_flush();
+        if (err == ESP_OK) {
+            erase_legacy_bt_devices();
+        } else {
+            ESP_LOGW(TAG, "BT profile migration incomplete (%s), legacy settings kept",
+                     esp_err_to_name(err));
+        }
+    }
+    
+    ESP_LOGI(TAG, "Loaded %d BT device profiles", count);
 }
 
 // ============================================================================
@@ -262,270 +792,755 @@ static void send_display_notification(display_notification_type_t type,
 }
 
 // ============================================================================
-// STATION TUNING TIMER
+// DEFERRED ACTIONS
+// ============================================================================
+
+typedef struct {
+    const char *name;
+    void (*fire)(void);
+} deferred_action_def_t;
+
+static const deferred_action_def_t g_deferred_defs[DEFERRED_ACTION_COUNT] = {
+    [DEFERRED_STATION_TUNE] = { "station_tune", station_tune_fire },
+    [DEFERRED_NVS_SAVE]     = { "nvs_save",     flush_nvs },
+    [DEFERRED_METADATA_PUBLISH] = { "metadata", metadata_publish },
+};
+
+// Runs on the esp_timer task: hand the action to the state task to execute.
+// A full queue must not lose the action, so the timer fires again shortly;
+// rescheduling in the meantime restarts it and bumps the generation.
+static void deferred_timer_callback(void *arg)
+{
+    deferred_action_t action = (deferred_action_t)(intptr_t)arg;
+    state_event_t event = {
+        .type = STATE_EVT_DEFERRED,
+        .deferred = {
+            .action = action,
+            .gen = __atomic_load_n(&g_deferred_gen[action], __ATOMIC_RELAXED),
+        },
+    };
+    if (!state_post(&event)) {
+        esp_timer_start_once(g_deferred_timers[action], (uint64_t)DEFERRED_RETRY_MS * 1000);
+    }
+}
+
+static esp_err_t deferred_actions_init(void)
+{
+    for (int i = 0; i < DEFERRED_ACTION_COUNT; i++) {
+        if (g_deferred_timers[i]) continue;
+        esp_timer_create_args_t args = {
+            .callback = deferred_timer_callback,
+            .arg = (void *)(intptr_t)i,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = g_deferred_defs[i].name,
+        };
+        esp_err_t err = esp_timer_create(&args, &g_deferred_timers[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create %s timer: %s",
+                     g_deferred_defs[i].name, esp_err_to_name(err));
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+// (Re)start the one-shot timer for an action; a pending run is pushed back.
+// The new generation also voids a firing that is already in the queue.
+static void deferred_schedule(deferred_action_t action, uint32_t delay_ms)
+{
+    esp_timer_handle_t timer = g_deferred_timers[action];
+    if (!timer) return;
+    esp_timer_stop(timer);  // ESP_ERR_INVALID_STATE if idle, which is fine
+    __atomic_add_fetch(&g_deferred_gen[action], 1, __ATOMIC_RELAXED);
+    g_deferred_pending[action] = true;
+    esp_timer_start_once(timer, (uint64_t)delay_ms * 1000);
+}
+
+static void deferred_cancel(deferred_action_t action)
+{
+    if (!g_deferred_timers[action]) return;
+    esp_timer_stop(g_deferred_timers[action]);
+    __atomic_add_fetch(&g_deferred_gen[action], 1, __ATOMIC_RELAXED);
+    g_deferred_pending[action] = false;
+}
+
+// True from deferred_schedule() until the action runs or is cancelled, even
+// while its firing waits in the state queue
+static bool deferred_pending(deferred_action_t action)
+{
+    return g_deferred_pending[action];
+}
+
+// Dispatch a timer firing, unless the action was rescheduled or cancelled
+// after it was posted
+static void deferred_fire(deferred_action_t action, uint32_t gen)
+{
+    if (gen != __atomic_load_n(&g_deferred_gen[action], __ATOMIC_RELAXED)) return;
+    g_deferred_pending[action] = false;
+    g_deferred_defs[action].fire();
+}
+
+// ============================================================================
+// STATION TUNING
 // ============================================================================
 
-static void station_tune_timer_callback(void *arg)
+// With an empty station index, browsing falls back to the full FM raster
+#define FM_GRID_CHANNELS ((STATION_FM_MAX_KHZ - STATION_FM_MIN_KHZ) / STATION_FM_STEP_KHZ + 1)
+
+static uint32_t radio_freq_khz(void)
+{
+    return (uint32_t)(g_radio_state.frequency * 1000.0f + 0.5f);
+}
+
+static int browse_count(void)
+{
+    size_t count = station_index_count();
+    return count ? (int)count : FM_GRID_CHANNELS;
+}
+
+// Browse position of the current station
+static int browse_position(void)
+{
+    uint32_t khz = radio_freq_khz();
+    if (station_index_count() == 0) {
+        if (khz < STATION_FM_MIN_KHZ) return 0;
+        return (int)((khz - STATION_FM_MIN_KHZ) / STATION_FM_STEP_KHZ) % FM_GRID_CHANNELS;
+    }
+    int idx = station_index_find_fm(khz);
+    if (idx < 0) idx = station_index_seek_fm(khz, 1);
+    return idx < 0 ? 0 : idx;
+}
+
+// Describe a browse position: frequency or service label, plus the PS if known
+static void browse_describe(int idx, station_entry_t *entry, char *text, size_t size)
+{
+    if (!station_index_get((size_t)idx, entry)) {
+        memset(entry, 0, sizeof(*entry));
+        entry->kind = STATION_KIND_FM;
+        entry->freq_khz = STATION_FM_MIN_KHZ + (uint32_t)idx * STATION_FM_STEP_KHZ;
+    }
+    if (entry->kind == STATION_KIND_DAB) {
+        snprintf(text, size, "%s", entry->name[0] ? entry->name : "DAB");
+    } else {
+        snprintf(text, size, "%.1f MHz", entry->freq_khz / 1000.0f);
+    }
+}
+
+// Make a browse position the current station
+static void radio_select(int idx, const char *subtext)
+{
+    station_entry_t entry;
+    char text[32];
+    browse_describe(idx, &entry, text, sizeof(text));
+    
+    DLOGI(TAG, "Tuning to %s", text);
+    g_radio_station = entry;
+    esp_err_t err = station_index_tune_entry(&entry);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "Tune failed: %s", esp_err_to_name(err));
+    }
+    
+    if (entry.kind == STATION_KIND_FM) {
+        g_radio_state.frequency = entry.freq_khz / 1000.0f;
+    }
+    rds_reset();
+    g_radio_state.song_info[0] = '\0';
+    strncpy(g_radio_state.station_name, entry.name, sizeof(g_radio_state.station_name) - 1);
+    g_radio_state.station_name[sizeof(g_radio_state.station_name) - 1] = '\0';
+    
+    send_display_notification(DISPLAY_FREQUENCY, text,
+                              entry.kind == STATION_KIND_FM && entry.name[0] ? entry.name : subtext,
+                              2000, 100);
+    save_to_nvs();
+}
+
+// Log time-to-first-audio, once per boot
+static void note_first_audio(const char *source)
+{
+    static bool logged = false;
+    if (logged) return;
+    logged = true;
+    ESP_LOGI(TAG, "First audio (%s) %d ms after boot", source,
+             (int)(esp_timer_get_time() / 1000));
+}
+
+// Put the tuner back on the current station after someone else used it
+static void radio_retune(void)
+{
+    esp_err_t err;
+    if (g_radio_station.kind == STATION_KIND_DAB) {
+        err = station_index_tune_entry(&g_radio_station);
+    } else {
+        err = station_index_tune_fm(radio_freq_khz());
+    }
+    if (err == ESP_OK && g_current_mode == MODE_RADIO) {
+        note_first_audio("radio");
+    }
+}
+
+static void station_tune_fire(void)
 {
-    vTaskDelay(pdMS_TO_TICKS(STATION_TUNE_DELAY_MS));
     if (g_browsing_stations) {
-        ESP_LOGI(TAG, "Tuning to %.1f MHz", g_browsing_station_freq);
-        g_radio_state.frequency = g_browsing_station_freq;
         g_browsing_stations = false;
-        char freq_str[16];
-        snprintf(freq_str, sizeof(freq_str), "%.1f MHz", g_browsing_station_freq);
-        send_display_notification(DISPLAY_FREQUENCY, freq_str, "Tuned", 2000, 100);
-        save_to_nvs();
+        radio_select(g_browsing_station_idx % browse_count(), "Tuned");
     }
-    g_station_tune_timer = NULL;
-    vTaskDelete(NULL);
 }
 
 static void start_station_tune_timer(void)
 {
-    if (g_station_tune_timer) vTaskDelete(g_station_tune_timer);
-    xTaskCreate(station_tune_timer_callback, "tune_timer", 2048, NULL, 5, &g_station_tune_timer);
+    deferred_schedule(DEFERRED_STATION_TUNE, STATION_TUNE_DELAY_MS);
 }
 
 // ============================================================================
 // MODE HANDLERS
 // ============================================================================
 
-static void handle_radio_mode(button_event_t event)
-{
-    switch (event.event) {
-        case BTN_EVENT_ROTARY_CW:
-            // Volume up or station browsing
-            if (g_browsing_stations) {
-                g_browsing_station_idx = (g_browsing_station_idx + 1) % 20;
-                g_browsing_station_freq = 87.5 + (g_browsing_station_idx * 0.2);
-                char freq[16];
-                snprintf(freq, sizeof(freq), "%.1f MHz", g_browsing_station_freq);
-                send_display_notification(DISPLAY_FREQUENCY, freq, "Browsing", 0, 150);
-                start_station_tune_timer();
-            } else {
-                if (g_radio_state.volume < 15) g_radio_state.volume++;
-                char vol[8];
-                snprintf(vol, sizeof(vol), "%d", g_radio_state.volume);
-                send_display_notification(DISPLAY_VOLUME, vol, "Radio", 1000, 120);
-                save_to_nvs();
-            }
-            break;
+#define MAX_VOLUME 15
 
-        case BTN_EVENT_ROTARY_CCW:
-            // Volume down or station browsing
-            if (g_browsing_stations) {
-                g_browsing_station_idx = (g_browsing_station_idx == 0) ? 19 : (g_browsing_station_idx - 1);
-                g_browsing_station_freq = 87.5 + (g_browsing_station_idx * 0.2);
-                char freq[16];
-                snprintf(freq, sizeof(freq), "%.1f MHz", g_browsing_station_freq);
-                send_display_notification(DISPLAY_FREQUENCY, freq, "Browsing", 0, 150);
-                start_station_tune_timer();
-            } else {
-                if (g_radio_state.volume > 0) g_radio_state.volume--;
-                char vol[8];
-                snprintf(vol, sizeof(vol), "%d", g_radio_state.volume);
-                send_display_notification(DISPLAY_VOLUME, vol, "Radio", 1000, 120);
-                save_to_nvs();
-            }
-            break;
+// Physical detents in a rotary event - used for volume, never accelerated
+static int rotary_detents(const button_event_t *event)
+{
+    return event->detents ? event->detents : 1;
+}
 
-        case BTN_EVENT_PRESS:
-            // Add this case to satisfy -Werror=switch
-            if (event.button == BTN_ROTARY && !g_browsing_stations) {
-                char freq[16];
-                snprintf(freq, sizeof(freq), "%.1f MHz", g_radio_state.frequency);
-                send_display_notification(DISPLAY_FREQUENCY, freq, 
-                                        g_current_band == RADIO_BAND_FM ? "FM" : "AM", 
-                                        2000, 130);
-            }
-            break;
+// Speed-scaled steps in a rotary event - used for browsing
+static int rotary_steps(const button_event_t *event)
+{
+    return event->steps ? event->steps : 1;
+}
 
-        case BTN_EVENT_RELEASE:
-            // Station presets (buttons 3-7: BTN_STATION_1 through BTN_STATION_5)
-            if (event.button >= BTN_STATION_1 && event.button <= BTN_STATION_5) {
-                int idx = event.button - BTN_STATION_1;
-                float freq = g_radio_state.preset_freq[g_current_band][idx];
-                if (freq > 0) {
-                    g_radio_state.frequency = freq;
-                    char msg[32];
-                    snprintf(msg, sizeof(msg), "Station %d: %.1f MHz", idx + 1, freq);
-                    send_display_notification(DISPLAY_FREQUENCY, msg, NULL, 2000, 130);
-                    save_to_nvs();
-                }
-            }
-            // Seek buttons
-            else if (event.button == BTN_UP) {
-                send_display_notification(DISPLAY_MODE_CHANGE, "Seeking Up", NULL, 1000, 110);
-            }
-            else if (event.button == BTN_DOWN) {
-                send_display_notification(DISPLAY_MODE_CHANGE, "Seeking Down", NULL, 1000, 110);
-            }
-            // Rotary button toggles browsing mode
-            else if (event.button == BTN_ROTARY) {
-                g_browsing_stations = !g_browsing_stations;
-                if (g_browsing_stations) {
-                    g_browsing_station_freq = g_radio_state.frequency;
-                    g_browsing_station_idx = (uint8_t)((g_browsing_station_freq - 87.5) / 0.2);
-                    char freq[16];
-                    snprintf(freq, sizeof(freq), "%.1f MHz", g_browsing_station_freq);
-                    send_display_notification(DISPLAY_FREQUENCY, freq, "Browse Mode", 0, 150);
-                }
-            }
-            break;
+static uint8_t clamp_volume(int volume)
+{
+    if (volume < 0) return 0;
+    if (volume > MAX_VOLUME) return MAX_VOLUME;
+    return (uint8_t)volume;
+}
 
-        case BTN_EVENT_LONG_PRESS:
-            // Save station presets (all 5 buttons now available)
-            if (event.button >= BTN_STATION_1 && event.button <= BTN_STATION_5) {
-                int idx = event.button - BTN_STATION_1;
-                g_radio_state.preset_freq[g_current_band][idx] = g_radio_state.frequency;
-                char msg[32];
-                snprintf(msg, sizeof(msg), "Station %d Saved", idx + 1);
-                send_display_notification(DISPLAY_FREQUENCY, msg, NULL, 2000, 140);
-                save_to_nvs();
-            }
-            break;
+// ---- Power / voice recognition (bound in every mode) ----
 
-        case BTN_EVENT_REPEAT:
-        case BTN_EVENT_RELEASE_AFTER_LONG:
-            break;
+static void action_power_toggle(const button_event_t *event)
+{
+    if (g_current_mode == MODE_OFF) {
+        // Power ON
+        ESP_LOGI(TAG, "Power ON");
+        g_powered_on = true;
+        g_current_mode = MODE_RADIO;
+        send_display_notification(DISPLAY_MODE_CHANGE, "Power ON", NULL, 1500, 150);
+        save_to_nvs();
+        if (g_config.on_mode_change) {
+            g_config.on_mode_change(MODE_OFF, g_current_mode);
+        }
+    } else {
+        // Power OFF
+        ESP_LOGI(TAG, "Power OFF");
+        stereo_mode_t old_mode = g_current_mode;
+        g_powered_on = false;
+        g_current_mode = MODE_OFF;
+        send_display_notification(DISPLAY_MODE_CHANGE, "Power OFF", NULL, 1000, 150);
+        flush_nvs();
+        if (g_config.on_mode_change) {
+            g_config.on_mode_change(old_mode, MODE_OFF);
+        }
     }
 }
 
-static void handle_bluetooth_mode(button_event_t event)
+// BTN_BAND_UM = Button 1 (100kΩ resistor, threshold ~201)
+static void action_voice_start(const button_event_t *event)
 {
-    switch (event.event) {
-        case BTN_EVENT_PRESS:
-            // Handle press if needed
-            break;
+    if (!g_voice_recognition_active && 
+        (g_current_mode == MODE_BLUETOOTH || g_current_mode == MODE_RADIO)) {
+        ESP_LOGI(TAG, "Button 1 (BAND_UM): Starting voice recognition");
+        esp_err_t ret = a2dpSinkHfpHf_start_voice_recognition();
+        if (ret == ESP_OK) {
+            g_voice_recognition_active = true;
+            send_display_notification(DISPLAY_MODE_CHANGE, 
+                                    "Voice Assistant", 
+                                    "Listening...", 
+                                    0, 200);
+        } else {
+            ESP_LOGE(TAG, "Failed to start voice recognition: %s", 
+                    esp_err_to_name(ret));
+            send_display_notification(DISPLAY_MODE_CHANGE, 
+                                    "Voice Assistant", 
+                                    "Failed to Start", 
+                                    2000, 200);
+        }
+    } else if (g_voice_recognition_active) {
+        ESP_LOGW(TAG, "Voice recognition already active");
+    } else {
+        ESP_LOGW(TAG, "Voice recognition not available in current mode");
+    }
+}
 
-        case BTN_EVENT_ROTARY_CW:
-            if (g_a2dp_state.volume < 15) g_a2dp_state.volume++;
-            char vol[8];
-            snprintf(vol, sizeof(vol), "%d", g_a2dp_state.volume);
-            send_display_notification(DISPLAY_VOLUME, vol, "Bluetooth", 1000, 120);
-            a2dpSinkHfpHf_set_a2dp_volume(g_a2dp_state.volume);
-            save_to_nvs();
-            break;
+// BTN_BAND_VF = Button 2 (68kΩ resistor, threshold ~346)
+static void action_voice_stop(const button_event_t *event)
+{
+    if (g_voice_recognition_active) {
+        ESP_LOGI(TAG, "Button 2 (BAND_VF): Stopping voice recognition");
+        esp_err_t ret = a2dpSinkHfpHf_stop_voice_recognition();
+        if (ret == ESP_OK) {
+            g_voice_recognition_active = false;
+            send_display_notification(DISPLAY_MODE_CHANGE, 
+                                    "Voice Assistant", 
+                                    "Stopped", 
+                                    1500, 180);
+        } else {
+            ESP_LOGE(TAG, "Failed to stop voice recognition: %s", 
+                    esp_err_to_name(ret));
+        }
+    } else {
+        ESP_LOGW(TAG, "Voice recognition not active");
+    }
+}
 
-        case BTN_EVENT_ROTARY_CCW:
-            if (g_a2dp_state.volume > 0) g_a2dp_state.volume--;
-            char vol2[8];
-            snprintf(vol2, sizeof(vol2), "%d", g_a2dp_state.volume);
-            send_display_notification(DISPLAY_VOLUME, vol2, "Bluetooth", 1000, 120);
-            a2dpSinkHfpHf_set_a2dp_volume(g_a2dp_state.volume);
-            save_to_nvs();
-            break;
+// ---- Radio ----
 
-        case BTN_EVENT_RELEASE:
-            if (event.button == BTN_ROTARY) {
-                // Play/Pause toggle
-                if (g_a2dp_state.playing) {
-                    // FIXED: Use correct function name
-                    a2dpSinkHfpHf_avrc_pause();
-                    g_a2dp_state.playing = false;
-                    send_display_notification(DISPLAY_MODE_CHANGE, "Paused", NULL, 1000, 110);
-                } else {
-                    // FIXED: Use correct function name
-                    a2dpSinkHfpHf_avrc_play();
-                    g_a2dp_state.playing = true;
-                    send_display_notification(DISPLAY_MODE_CHANGE, "Playing", NULL, 1000, 110);
-                }
-            }
-            else if (event.button == BTN_UP) {
-                // FIXED: Use correct function name
-                a2dpSinkHfpHf_avrc_next();
-                send_display_notification(DISPLAY_MODE_CHANGE, "Next Track", NULL, 1000, 110);
-            }
-            else if (event.button == BTN_DOWN) {
-                // FIXED: Use correct function name
-                a2dpSinkHfpHf_avrc_prev();
-                send_display_notification(DISPLAY_MODE_CHANGE, "Previous Track", NULL, 1000, 110);
-            }
-            break;
+// Volume, or station browsing while in browse mode
+static void radio_rotary(const button_event_t *event, int dir)
+{
+    if (g_browsing_stations) {
+        // The index may have been replaced by a scan since browsing started
+        int count = browse_count();
+        int steps = rotary_steps(event) % count;
+        g_browsing_station_idx = (g_browsing_station_idx % count + count + dir * steps) % count;
+        station_entry_t entry;
+        char text[32];
+        browse_describe(g_browsing_station_idx, &entry, text, sizeof(text));
+        send_display_notification(DISPLAY_FREQUENCY, text,
+                                  entry.name[0] && entry.kind == STATION_KIND_FM ? entry.name : "Browsing",
+                                  0, 150);
+        start_station_tune_timer();
+    } else {
+        g_radio_state.volume = clamp_volume(g_radio_state.volume + dir * rotary_detents(event));
+        char vol[8];
+        snprintf(vol, sizeof(vol), "%d", g_radio_state.volume);
+        send_display_notification(DISPLAY_VOLUME, vol, "Radio", 1000, 120);
+        save_to_nvs();
+    }
+}
 
-        case BTN_EVENT_LONG_PRESS:
-            // Voice control removed - now handled by buttons 1 & 2
-            break;
+static void action_radio_rotary_up(const button_event_t *event)
+{
+    radio_rotary(event, 1);
+}
 
-        case BTN_EVENT_RELEASE_AFTER_LONG:
-            break;
+static void action_radio_rotary_down(const button_event_t *event)
+{
+    radio_rotary(event, -1);
+}
 
-        case BTN_EVENT_REPEAT:
-            if (event.button == BTN_UP || event.button == BTN_DOWN) {
-                // Volume repeat
-                if (event.button == BTN_UP && g_a2dp_state.volume < 15) {
-                    g_a2dp_state.volume++;
-                } else if (event.button == BTN_DOWN && g_a2dp_state.volume > 0) {
-                    g_a2dp_state.volume--;
-                }
-                char vol3[8];
-                snprintf(vol3, sizeof(vol3), "%d", g_a2dp_state.volume);
-                send_display_notification(DISPLAY_VOLUME, vol3, "Bluetooth", 1000, 120);
-                a2dpSinkHfpHf_set_a2dp_volume(g_a2dp_state.volume);
-                save_to_nvs();
-            }
-            break;
+static void action_radio_show_frequency(const button_event_t *event)
+{
+    if (!g_browsing_stations) {
+        char freq[16];
+        snprintf(freq, sizeof(freq), "%.1f MHz", g_radio_state.frequency);
+        send_display_notification(DISPLAY_FREQUENCY, freq, 
+                                g_current_band == RADIO_BAND_FM ? "FM" : "AM", 
+                                2000, 130);
     }
 }
 
-static void handle_phone_call_mode(button_event_t event)
+static void action_radio_browse_toggle(const button_event_t *event)
 {
-    switch (event.event) {
-        case BTN_EVENT_RELEASE:
-            break;
-        case BTN_EVENT_LONG_PRESS:
-            break;
-        case BTN_EVENT_ROTARY_CW:
-            if (g_a2dp_state.volume < 15) {
-                g_a2dp_state.volume++;
-                char vol[8];
-                snprintf(vol, sizeof(vol), "%d", g_a2dp_state.volume);
-                send_display_notification(DISPLAY_VOLUME, vol, "Call Volume", 1000, 200);
-                a2dpSinkHfpHf_set_hfp_speaker_volume(g_hfp_state.speaker_volume);
-            }
-            break;
-            
-        case BTN_EVENT_ROTARY_CCW:
-            if (g_a2dp_state.volume > 0) {
-                g_a2dp_state.volume--;
-                char vol[8];
-                snprintf(vol, sizeof(vol), "%d", g_a2dp_state.volume);
-                send_display_notification(DISPLAY_VOLUME, vol, "Call Volume", 1000, 200);
-                a2dpSinkHfpHf_set_hfp_speaker_volume(g_hfp_state.speaker_volume);
-            }
-            break;
-            
-        case BTN_EVENT_PRESS:
-            if (event.button == BTN_ROTARY) {
-                a2dpSinkHfpHf_hangup_call();
-                send_display_notification(DISPLAY_CALL_ACTIVE, "Call Ended", NULL, 2000, 250);
-                g_current_mode = g_mode_before_call;
-                if (g_config.on_mode_change) {
-                    g_config.on_mode_change(MODE_PHONE_CALL, g_current_mode);
-                }
-                save_to_nvs();
-            }
-            break;
+    g_browsing_stations = !g_browsing_stations;
+    if (!g_browsing_stations) {
+        deferred_cancel(DEFERRED_STATION_TUNE);
+    } else {
+        g_browsing_station_idx = browse_position();
+        station_entry_t entry;
+        char text[32];
+        browse_describe(g_browsing_station_idx, &entry, text, sizeof(text));
+        send_display_notification(DISPLAY_FREQUENCY, text, "Browse Mode", 0, 150);
+    }
+}
 
-        case BTN_EVENT_RELEASE_AFTER_LONG:
-            // Nothing to do - already handled by long press
-            break;
+// Station presets (buttons 3-7: BTN_STATION_1 through BTN_STATION_5)
+static void action_radio_preset_recall(const button_event_t *event)
+{
+    int idx = event->button - BTN_STATION_1;
+    float freq = g_radio_state.preset_freq[g_current_band][idx];
+    if (freq > 0) {
+        g_radio_state.frequency = freq;
+        g_radio_station.kind = STATION_KIND_FM;
+        station_index_tune_fm(radio_freq_khz());
+        rds_reset();
+        char msg[32];
+        snprintf(msg, sizeof(msg), "Station %d: %.1f MHz", idx + 1, freq);
+        send_display_notification(DISPLAY_FREQUENCY, msg, NULL, 2000, 130);
+        save_to_nvs();
+    }
+}
 
-        case BTN_EVENT_REPEAT:
-            // Handle call volume repeat if needed
-            // Volume already handled by rotary CW/CCW
-            break;       
+static void action_radio_preset_save(const button_event_t *event)
+{
+    int idx = event->button - BTN_STATION_1;
+    g_radio_state.preset_freq[g_current_band][idx] = g_radio_state.frequency;
+    char msg[32];
+    snprintf(msg, sizeof(msg), "Station %d Saved", idx + 1);
+    send_display_notification(DISPLAY_FREQUENCY, msg, NULL, 2000, 140);
+    save_to_nvs();
+}
+
+// Jump to the next known FM station; with nothing indexed yet, go find some
+static void radio_seek(int dir)
+{
+    int idx = station_index_seek_fm(radio_freq_khz(), dir);
+    if (idx >= 0) {
+        radio_select(idx, dir > 0 ? "Seek Up" : "Seek Down");
+    } else if (station_index_scan_busy() || station_index_scan_start() == ESP_OK) {
+        send_display_notification(DISPLAY_MODE_CHANGE, "Scanning...", NULL, 2000, 110);
+    } else {
+        send_display_notification(DISPLAY_MODE_CHANGE, "No Stations", NULL, 1000, 110);
     }
 }
 
-static void handle_phonebook_mode(button_event_t event)
+static void action_radio_seek_up(const button_event_t *event)
 {
-    // Phonebook navigation - simplified placeholder
-    // Implement full phonebook browsing based on earlier conversation
+    radio_seek(1);
 }
 
-static void on_bt_volume_changed(bt_volume_target_t target, uint8_t new_volume)
+static void action_radio_seek_down(const button_event_t *event)
+{
+    radio_seek(-1);
+}
+
+static void action_radio_rescan(const button_event_t *event)
+{
+    if (station_index_scan_start() == ESP_OK) {
+        send_display_notification(DISPLAY_MODE_CHANGE, "Scanning...", NULL, 2000, 110);
+    } else {
+        send_display_notification(DISPLAY_MODE_CHANGE, 
+                                  station_index_scan_busy() ? "Scan Running" : "Scan Unavailable",
+                                  NULL, 1000, 110);
+    }
+}
+
+// ---- Bluetooth ----
+
+static void bt_set_volume(int volume)
+{
+    g_a2dp_state.volume = clamp_volume(volume);
+    char vol[8];
+    snprintf(vol, sizeof(vol), "%d", g_a2dp_state.volume);
+    send_display_notification(DISPLAY_VOLUME, vol, "Bluetooth", 1000, 120);
+    a2dpSinkHfpHf_set_a2dp_volume(g_a2dp_state.volume);
+    save_to_nvs();
+}
+
+static void action_bt_volume_up(const button_event_t *event)
+{
+    bt_set_volume(g_a2dp_state.volume + rotary_detents(event));
+}
+
+static void action_bt_volume_down(const button_event_t *event)
+{
+    bt_set_volume(g_a2dp_state.volume - rotary_detents(event));
+}
+
+// Held UP/DOWN: one step per repeat event
+static void action_bt_volume_step_up(const button_event_t *event)
+{
+    bt_set_volume(g_a2dp_state.volume + 1);
+}
+
+static void action_bt_volume_step_down(const button_event_t *event)
+{
+    bt_set_volume(g_a2dp_state.volume - 1);
+}
+
+static void action_bt_play_pause(const button_event_t *event)
+{
+    if (g_a2dp_state.playing) {
+        a2dpSinkHfpHf_avrc_pause();
+        g_a2dp_state.playing = false;
+        send_display_notification(DISPLAY_MODE_CHANGE, "Paused", NULL, 1000, 110);
+    } else {
+        a2dpSinkHfpHf_avrc_play();
+        g_a2dp_state.playing = true;
+        send_display_notification(DISPLAY_MODE_CHANGE, "Playing", NULL, 1000, 110);
+    }
+}
+
+static void action_bt_next(const button_event_t *event)
+{
+    a2dpSinkHfpHf_avrc_next();
+    send_display_notification(DISPLAY_MODE_CHANGE, "Next Track", NULL, 1000, 110);
+}
+
+static void action_bt_prev(const button_event_t *event)
+{
+    a2dpSinkHfpHf_avrc_prev();
+    send_display_notification(DISPLAY_MODE_CHANGE, "Previous Track", NULL, 1000, 110);
+}
+
+// ---- Phone call ----
+
+static void action_call_volume_up(const button_event_t *event)
+{
+    if (g_a2dp_state.volume < MAX_VOLUME) {
+        g_a2dp_state.volume = clamp_volume(g_a2dp_state.volume + rotary_detents(event));
+        char vol[8];
+        snprintf(vol, sizeof(vol), "%d", g_a2dp_state.volume);
+        send_display_notification(DISPLAY_VOLUME, vol, "Call Volume", 1000, 200);
+        a2dpSinkHfpHf_set_hfp_speaker_volume(g_hfp_state.speaker_volume);
+    }
+}
+
+static void action_call_volume_down(const button_event_t *event)
+{
+    if (g_a2dp_state.volume > 0) {
+        g_a2dp_state.volume = clamp_volume(g_a2dp_state.volume - rotary_detents(event));
+        char vol[8];
+        snprintf(vol, sizeof(vol), "%d", g_a2dp_state.volume);
+        send_display_notification(DISPLAY_VOLUME, vol, "Call Volume", 1000, 200);
+        a2dpSinkHfpHf_set_hfp_speaker_volume(g_hfp_state.speaker_volume);
+    }
+}
+
+static void action_call_hangup(const button_event_t *event)
+{
+    a2dpSinkHfpHf_hangup_call();
+    send_display_notification(DISPLAY_CALL_ACTIVE, "Call Ended", NULL, 2000, 250);
+    g_current_mode = g_mode_before_call;
+    if (g_config.on_mode_change) {
+        g_config.on_mode_change(MODE_PHONE_CALL, g_current_mode);
+    }
+    save_to_nvs();
+}
+
+// ---- Phonebook ----
+
+// Show the contact at contact_index - a single record read
+static void phonebook_show(void)
+{
+    phonebook_contact_t contact;
+    if (!phonebook_store_get(g_phonebook_state.contact_index, &contact)) {
+        send_display_notification(DISPLAY_PHONEBOOK_CONTACT, "Phonebook", "No Contacts", 0, 100);
+        return;
+    }
+    uint8_t letter = phonebook_letter_class(contact.name);
+    g_phonebook_state.current_letter = letter < PHONEBOOK_LETTER_OTHER ? (char)('A' + letter) : '#';
+    strncpy(g_phonebook_state.contact_name, contact.name, sizeof(g_phonebook_state.contact_name) - 1);
+    strncpy(g_phonebook_state.phone_number, contact.number, sizeof(g_phonebook_state.phone_number) - 1);
+    send_display_notification(DISPLAY_PHONEBOOK_CONTACT, contact.name, contact.number, 0, 100);
+}
+
+static void action_phonebook_enter(const button_event_t *event)
+{
+    if (phonebook_store_count() == 0) {
+        send_display_notification(DISPLAY_MODE_CHANGE, "No Contacts", NULL, 1500, 110);
+        return;
+    }
+    g_mode_before_phonebook = g_current_mode;
+    apply_set_mode(MODE_PHONEBOOK);
+    phonebook_show();
+}
+
+static void action_phonebook_exit(const button_event_t *event)
+{
+    apply_set_mode(g_mode_before_phonebook);
+}
+
+static void phonebook_step(const button_event_t *event, int dir)
+{
+    int count = (int)phonebook_store_count();
+    if (count == 0) return;
+    int steps = rotary_steps(event) % count;
+    g_phonebook_state.contact_index =
+        (uint16_t)((g_phonebook_state.contact_index % count + count + dir * steps) % count);
+    phonebook_show();
+}
+
+static void action_phonebook_next(const button_event_t *event)
+{
+    phonebook_step(event, 1);
+}
+
+static void action_phonebook_prev(const button_event_t *event)
+{
+    phonebook_step(event, -1);
+}
+
+// Jump to the first contact of the next (or previous) letter that has any
+static void phonebook_letter(int dir)
+{
+    size_t count = phonebook_store_count();
+    phonebook_contact_t contact;
+    if (!phonebook_store_get(g_phonebook_state.contact_index, &contact)) return;
+    
+    const int letters = PHONEBOOK_LETTER_OTHER + 1;
+    int current = phonebook_letter_class(contact.name);
+    for (int i = 1; i <= letters; i++) {
+        int letter = (current + dir * i + 2 * letters) % letters;
+        size_t first = phonebook_store_letter_first((uint8_t)letter);
+        size_t end = letter < PHONEBOOK_LETTER_OTHER
+                   ? phonebook_store_letter_first((uint8_t)(letter + 1)) : count;
+        if (first < end) {
+            g_phonebook_state.contact_index = (uint16_t)first;
+            phonebook_show();
+            return;
+        }
+    }
+}
+
+static void action_phonebook_letter_next(const button_event_t *event)
+{
+    phonebook_letter(1);
+}
+
+static void action_phonebook_letter_prev(const button_event_t *event)
+{
+    phonebook_letter(-1);
+}
+
+// ============================================================================
+// BUTTON DISPATCH TABLE
+// ============================================================================
+
+typedef enum {
+    ACTION_NONE = 0,
+    ACTION_POWER_TOGGLE,
+    ACTION_VOICE_START,
+    ACTION_VOICE_STOP,
+    ACTION_RADIO_ROTARY_UP,
+    ACTION_RADIO_ROTARY_DOWN,
+    ACTION_RADIO_SHOW_FREQUENCY,
+    ACTION_RADIO_BROWSE_TOGGLE,
+    ACTION_RADIO_PRESET_RECALL,
+    ACTION_RADIO_PRESET_SAVE,
+    ACTION_RADIO_SEEK_UP,
+    ACTION_RADIO_SEEK_DOWN,
+    ACTION_RADIO_RESCAN,
+    ACTION_BT_VOLUME_UP,
+    ACTION_BT_VOLUME_DOWN,
+    ACTION_BT_VOLUME_STEP_UP,
+    ACTION_BT_VOLUME_STEP_DOWN,
+    ACTION_BT_PLAY_PAUSE,
+    ACTION_BT_NEXT,
+    ACTION_BT_PREV,
+    ACTION_CALL_VOLUME_UP,
+    ACTION_CALL_VOLUME_DOWN,
+    ACTION_CALL_HANGUP,
+    ACTION_PHONEBOOK_ENTER,
+    ACTION_PHONEBOOK_EXIT,
+    ACTION_PHONEBOOK_NEXT,
+    ACTION_PHONEBOOK_PREV,
+    ACTION_PHONEBOOK_LETTER_NEXT,
+    ACTION_PHONEBOOK_LETTER_PREV,
+    ACTION_COUNT
+} button_action_t;
+
+typedef void (*button_action_fn_t)(const button_event_t *event);
+
+static const button_action_fn_t g_action_handlers[ACTION_COUNT] = {
+    [ACTION_POWER_TOGGLE]         = action_power_toggle,
+    [ACTION_VOICE_START]          = action_voice_start,
+    [ACTION_VOICE_STOP]           = action_voice_stop,
+    [ACTION_RADIO_ROTARY_UP]      = action_radio_rotary_up,
+    [ACTION_RADIO_ROTARY_DOWN]    = action_radio_rotary_down,
+    [ACTION_RADIO_SHOW_FREQUENCY] = action_radio_show_frequency,
+    [ACTION_RADIO_BROWSE_TOGGLE]  = action_radio_browse_toggle,
+    [ACTION_RADIO_PRESET_RECALL]  = action_radio_preset_recall,
+    [ACTION_RADIO_PRESET_SAVE]    = action_radio_preset_save,
+    [ACTION_RADIO_SEEK_UP]        = action_radio_seek_up,
+    [ACTION_RADIO_SEEK_DOWN]      = action_radio_seek_down,
+    [ACTION_RADIO_RESCAN]         = action_radio_rescan,
+    [ACTION_BT_VOLUME_UP]         = action_bt_volume_up,
+    [ACTION_BT_VOLUME_DOWN]       = action_bt_volume_down,
+    [ACTION_BT_VOLUME_STEP_UP]    = action_bt_volume_step_up,
+    [ACTION_BT_VOLUME_STEP_DOWN]  = action_bt_volume_step_down,
+    [ACTION_BT_PLAY_PAUSE]        = action_bt_play_pause,
+    [ACTION_BT_NEXT]              = action_bt_next,
+    [ACTION_BT_PREV]              = action_bt_prev,
+    [ACTION_CALL_VOLUME_UP]       = action_call_volume_up,
+    [ACTION_CALL_VOLUME_DOWN]     = action_call_volume_down,
+    [ACTION_CALL_HANGUP]          = action_call_hangup,
+    [ACTION_PHONEBOOK_ENTER]      = action_phonebook_enter,
+    [ACTION_PHONEBOOK_EXIT]       = action_phonebook_exit,
+    [ACTION_PHONEBOOK_NEXT]       = action_phonebook_next,
+    [ACTION_PHONEBOOK_PREV]       = action_phonebook_prev,
+    [ACTION_PHONEBOOK_LETTER_NEXT] = action_phonebook_letter_next,
+    [ACTION_PHONEBOOK_LETTER_PREV] = action_phonebook_letter_prev,
+};
+
+#define ACTION_MODES   (MODE_PHONEBOOK + 1)
+#define ACTION_BUTTONS (BTN_UP + 1)
+#define ACTION_EVENTS  (BTN_EVENT_ROTARY_CCW + 1)
+
+_Static_assert(ACTION_COUNT <= UINT8_MAX, "button_action_t must fit the uint8_t table");
+
+// Bound in every mode, including OFF (the handlers check the mode themselves)
+#define POWER_BINDING   [BTN_EVENT_PRESS] = ACTION_POWER_TOGGLE
+#define VOICE_BINDINGS  [BTN_BAND_UM] = { [BTN_EVENT_PRESS] = ACTION_VOICE_START }, \
+                        [BTN_BAND_VF] = { [BTN_EVENT_PRESS] = ACTION_VOICE_STOP }
+
+// [mode][button][event] -> action. Remap per car variant by editing this
+// table; unlisted entries are ACTION_NONE. The rotary press is the power
+// toggle everywhere, which shadows ACTION_RADIO_SHOW_FREQUENCY and
+// ACTION_CALL_HANGUP - both stay available for variants that bind them.
+static const uint8_t g_button_actions[ACTION_MODES][ACTION_BUTTONS][ACTION_EVENTS] = {
+    [MODE_OFF] = {
+        [BTN_ROTARY] = { POWER_BINDING },
+        VOICE_BINDINGS,
+    },
+    [MODE_RADIO] = {
+        [BTN_ROTARY] = {
+            POWER_BINDING,
+            [BTN_EVENT_RELEASE]    = ACTION_RADIO_BROWSE_TOGGLE,
+            [BTN_EVENT_ROTARY_CW]  = ACTION_RADIO_ROTARY_UP,
+            [BTN_EVENT_ROTARY_CCW] = ACTION_RADIO_ROTARY_DOWN,
+        },
+        VOICE_BINDINGS,
+        [BTN_STATION_1] = { [BTN_EVENT_RELEASE] = ACTION_RADIO_PRESET_RECALL,
+                            [BTN_EVENT_LONG_PRESS] = ACTION_RADIO_PRESET_SAVE },
+        [BTN_STATION_2] = { [BTN_EVENT_RELEASE] = ACTION_RADIO_PRESET_RECALL,
+                            [BTN_EVENT_LONG_PRESS] = ACTION_RADIO_PRESET_SAVE },
+        [BTN_STATION_3] = { [BTN_EVENT_RELEASE] = ACTION_RADIO_PRESET_RECALL,
+                            [BTN_EVENT_LONG_PRESS] = ACTION_RADIO_PRESET_SAVE },
+        [BTN_STATION_4] = { [BTN_EVENT_RELEASE] = ACTION_RADIO_PRESET_RECALL,
+                            [BTN_EVENT_LONG_PRESS] = ACTION_RADIO_PRESET_SAVE },
+        [BTN_STATION_5] = { [BTN_EVENT_RELEASE] = ACTION_RADIO_PRESET_RECALL,
+                            [BTN_EVENT_LONG_PRESS] = ACTION_RADIO_PRESET_SAVE },
+        [BTN_UP]   = { [BTN_EVENT_RELEASE] = ACTION_RADIO_SEEK_UP,
+                       [BTN_EVENT_LONG_PRESS] = ACTION_RADIO_RESCAN },
+        [BTN_DOWN] = { [BTN_EVENT_RELEASE] = ACTION_RADIO_SEEK_DOWN },
+    },
+    [MODE_BLUETOOTH] = {
+        [BTN_ROTARY] = {
+            POWER_BINDING,
+            [BTN_EVENT_RELEASE]    = ACTION_BT_PLAY_PAUSE,
+            [BTN_EVENT_ROTARY_CW]  = ACTION_BT_VOLUME_UP,
+            [BTN_EVENT_ROTARY_CCW] = ACTION_BT_VOLUME_DOWN,
+        },
+        VOICE_BINDINGS,
+        [BTN_UP]   = { [BTN_EVENT_RELEASE] = ACTION_BT_NEXT,
+                       [BTN_EVENT_REPEAT]  = ACTION_BT_VOLUME_STEP_UP },
+        [BTN_DOWN] = { [BTN_EVENT_RELEASE] = ACTION_BT_PREV,
+                       [BTN_EVENT_REPEAT]  = ACTION_BT_VOLUME_STEP_DOWN },
+        [BTN_STATION_5] = { [BTN_EVENT_RELEASE] = ACTION_PHONEBOOK_ENTER },
+    },
+    [MODE_PHONE_CALL] = {
+        [BTN_ROTARY] = {
+            POWER_BINDING,
+            [BTN_EVENT_ROTARY_CW]  = ACTION_CALL_VOLUME_UP,
+            [BTN_EVENT_ROTARY_CCW] = ACTION_CALL_VOLUME_DOWN,
+        },
+        VOICE_BINDINGS,
+    },
+    [MODE_PHONEBOOK] = {
+        [BTN_ROTARY] = {
+            POWER_BINDING,
+            [BTN_EVENT_ROTARY_CW]  = ACTION_PHONEBOOK_NEXT,
+            [BTN_EVENT_ROTARY_CCW] = ACTION_PHONEBOOK_PREV,
+        },
+        VOICE_BINDINGS,
+        [BTN_UP]   = { [BTN_EVENT_RELEASE] = ACTION_PHONEBOOK_LETTER_NEXT },
+        [BTN_DOWN] = { [BTN_EVENT_RELEASE] = ACTION_PHONEBOOK_LETTER_PREV },
+        [BTN_STATION_5] = { [BTN_EVENT_RELEASE] = ACTION_PHONEBOOK_EXIT },
+    },
+};
+
+static void apply_bt_volume_changed(bt_volume_target_t target, uint8_t new_volume)
 {
     char vol_str[8];
     snprintf(vol_str, sizeof(vol_str), "%d", new_volume);
@@ -551,6 +1566,140 @@ static void on_bt_volume_changed(bt_volume_target_t target, uint8_t new_volume)
     send_display_notification(DISPLAY_VOLUME, vol_str, context, 1000, 120);
 }
 
+// ============================================================================
+// METADATA INGEST
+// ============================================================================
+
+// Phones resend identical AVRCP metadata and often deliver title, artist
+// and album as separate partial updates; RDS repeats PS/RT in every group.
+// Each field is hashed and compared with what was last shown, changes are
+// gathered for METADATA_MERGE_MS, and the display sees one update per track.
+typedef enum {
+    META_TITLE,
+    META_ARTIST,
+    META_ALBUM,
+    META_FIELD_COUNT
+} meta_field_t;
+
+typedef struct {
+    char text[META_FIELD_COUNT][64];
+    uint32_t hash[META_FIELD_COUNT];
+    uint8_t fields;             // Bit per meta_field_t received this window
+} metadata_pending_t;
+
+static metadata_pending_t g_metadata_pending;
+static uint32_t g_metadata_hash[META_FIELD_COUNT];  // Hash of what is shown
+static uint32_t g_rds_station_hash;
+static uint32_t g_rds_song_hash;
+
+// FNV-1a; 0 is reserved for "nothing seen yet"
+static uint32_t text_hash(const char *text)
+{
+    uint32_t hash = 2166136261u;
+    while (*text) {
+        hash ^= (uint8_t)*text++;
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+static char *a2dp_field(meta_field_t field)
+{
+    switch (field) {
+        case META_TITLE:  return g_a2dp_state.track;
+        case META_ARTIST: return g_a2dp_state.artist;
+        default:          return g_a2dp_state.album;
+    }
+}
+
+static void metadata_reset(void)
+{
+    deferred_cancel(DEFERRED_METADATA_PUBLISH);
+    memset(&g_metadata_pending, 0, sizeof(g_metadata_pending));
+    memset(g_metadata_hash, 0, sizeof(g_metadata_hash));
+}
+
+// Forget the shown RDS text, e.g. after retuning to another station
+static void rds_reset(void)
+{
+    g_rds_station_hash = 0;
+    g_rds_song_hash = 0;
+}
+
+// Fold one AVRCP callback into the pending window
+static void metadata_ingest(const char *const text[META_FIELD_COUNT])
+{
+    metadata_pending_t *p = &g_metadata_pending;
+
+    for (int f = 0; f < META_FIELD_COUNT; f++) {
+        if (!text[f]) continue;
+        uint8_t bit = 1 << f;
+
+        // A later partial update must not blank a field already received
+        if (!*text[f] && (p->fields & bit) && p->text[f][0]) continue;
+
+        uint32_t hash = text_hash(text[f]);
+        if (hash == ((p->fields & bit) ? p->hash[f] : g_metadata_hash[f])) continue;
+
+        strncpy(p->text[f], text[f], sizeof(p->text[f]) - 1);
+        p->text[f][sizeof(p->text[f]) - 1] = '\0';
+        p->hash[f] = hash;
+        p->fields |= bit;
+    }
+
+    // Not pushed back by further updates: latency stays bounded
+    if (p->fields && !deferred_pending(DEFERRED_METADATA_PUBLISH)) {
+        deferred_schedule(DEFERRED_METADATA_PUBLISH, METADATA_MERGE_MS);
+    }
+}
+
+// End of the merge window: apply what changed and redraw once
+static void metadata_publish(void)
+{
+    metadata_pending_t *p = &g_metadata_pending;
+    uint8_t fields = p->fields;
+    p->fields = 0;
+
+    if (g_current_mode != MODE_BLUETOOTH) return;
+
+    // A new title is a new track: fields it did not bring along are cleared.
+    // Otherwise only non-empty values fill in what is already shown.
+    bool new_track = (fields & (1 << META_TITLE)) && p->hash[META_TITLE] != g_metadata_hash[META_TITLE];
+    bool changed = false;
+
+    for (int f = 0; f < META_FIELD_COUNT; f++) {
+        char *dst = a2dp_field(f);
+        const char *src;
+        uint32_t hash;
+
+        if (fields & (1 << f)) {
+            if (!new_track && !p->text[f][0]) continue;
+            src = p->text[f];
+            hash = p->hash[f];
+        } else if (new_track) {
+            src = "";
+            hash = text_hash("");
+        } else {
+            continue;
+        }
+        if (hash == g_metadata_hash[f]) continue;
+
+        strncpy(dst, src, sizeof(g_a2dp_state.track) - 1);
+        dst[sizeof(g_a2dp_state.track) - 1] = '\0';
+        g_metadata_hash[f] = hash;
+        changed = true;
+    }
+
+    if (!changed) return;
+    if (new_track) track_begin(g_metadata_hash[META_TITLE]);
+
+    DLOGI(TAG, "Track: \"%s\" by \"%s\"", g_a2dp_state.track, g_a2dp_state.artist);
+
+    // Only display title on line 1, artist on line 2 for 5 seconds
+    send_display_notification(DISPLAY_BT_TRACK, g_a2dp_state.track,
+                              g_a2dp_state.artist, 5000, 80);
+}
+
 // ============================================================================
 // PUBLIC API
 // ============================================================================
@@ -584,19 +1733,29 @@ esp_err_t stereo_state_init(const stereo_config_t *config)
     g_hfp_state.mic_volume = 10;
     g_hfp_state.call_active = false;
     
+    esp_err_t err = deferred_actions_init();
+    if (err != ESP_OK) {
+        return err;
+    }
+    
+#if !CONFIG_IDF_TARGET_LINUX
+    // Anything still pending goes to flash before a software restart
+    esp_register_shutdown_handler(shutdown_flush);
+#endif
+    
     // Load from NVS
     load_from_nvs();
-    load_bt_device_settings();
+    load_bt_profiles();
+    
+    // Known stations come from flash; only a first boot has to scan
+    err = station_index_init(g_config.tuner, g_config.fm_radio_handle, on_station_scan_done);
+    if (err != ESP_OK) {
+        return err;
+    }
+    
+    // Optional: without a phonebook partition the stereo runs without contacts
+    phonebook_store_init();
     
-    // Initialize Bluetooth volume control
-    bt_volume_config_t vol_config = {
-        .default_a2dp_volume = g_a2dp_state.volume,
-        .default_hfp_speaker_volume = g_hfp_state.speaker_volume,
-        .default_hfp_mic_volume = g_hfp_state.mic_volume,
-        .on_volume_change = on_bt_volume_changed
-    };
-    bt_volume_control_init(&vol_config);
-
     // Restore state if was powered on
     if (g_powered_on && g_current_mode == MODE_RADIO) {
         ESP_LOGI(TAG, "Restoring radio at %.1f MHz", g_radio_state.frequency);
@@ -605,117 +1764,90 @@ esp_err_t stereo_state_init(const stereo_config_t *config)
         g_current_mode = MODE_OFF;
     }
     
+    // From here on only the state task touches state
+    g_save_lock = xSemaphoreCreateMutex();
+    g_save_done = xSemaphoreCreateBinary();
+    if (!g_save_lock || !g_save_done) {
+        ESP_LOGE(TAG, "Failed to create save semaphores");
+        return ESP_ERR_NO_MEM;
+    }
+    g_state_queue = xQueueCreate(STATE_QUEUE_LEN, sizeof(state_event_t));
+    if (!g_state_queue) {
+        ESP_LOGE(TAG, "Failed to create state event queue");
+        return ESP_ERR_NO_MEM;
+    }
+#if CONFIG_IDF_TARGET_LINUX
+    // Host harness: the calling task owns the state and dispatches through
+    // stereo_state_host_drain(), so a replay runs the same way every time
+    g_state_task = xTaskGetCurrentTaskHandle();
+    state_loop_start();
+#else
+    g_state_task = xTaskCreateStaticPinnedToCore(state_task, "stereo_state", TASK_STATE_STACK, NULL,
+                                                 TASK_STATE_PRIO, g_state_stack, &g_state_tcb,
+                                                 TASK_STATE_CORE);
+    if (!g_state_task) {
+        ESP_LOGE(TAG, "Failed to create state task");
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+    
+    if (station_index_count() == 0) {
+        station_index_scan_start();
+    }
+    
     return ESP_OK;
 }
 
-void stereo_state_handle_button(button_event_t event)
-{
-    ESP_LOGI(TAG, "State machine handling button: btn=%d, type=%d, current_mode=%d",
-             event.button, event.event, g_current_mode);
+// Actions that call into the BT stack; ignored until it is up
+static const bool g_action_needs_bt[ACTION_COUNT] = {
+    [ACTION_VOICE_START]          = true,
+    [ACTION_VOICE_STOP]           = true,
+    [ACTION_BT_VOLUME_UP]         = true,
+    [ACTION_BT_VOLUME_DOWN]       = true,
+    [ACTION_BT_VOLUME_STEP_UP]    = true,
+    [ACTION_BT_VOLUME_STEP_DOWN]  = true,
+    [ACTION_BT_PLAY_PAUSE]        = true,
+    [ACTION_BT_NEXT]              = true,
+    [ACTION_BT_PREV]              = true,
+    [ACTION_CALL_VOLUME_UP]       = true,
+    [ACTION_CALL_VOLUME_DOWN]     = true,
+    [ACTION_CALL_HANGUP]          = true,
+};
 
-    // ===== POWER CONTROL - SHORT PRESS ON ROTARY BUTTON ONLY =====
-    if (event.button == BTN_ROTARY && event.event == BTN_EVENT_PRESS) {
-        if (g_current_mode == MODE_OFF) {
-            // Power ON
-            ESP_LOGI(TAG, "Power ON");
-            g_powered_on = true;
-            g_current_mode = MODE_RADIO;
-            send_display_notification(DISPLAY_MODE_CHANGE, "Power ON", NULL, 1500, 150);
-            save_to_nvs();
-            if (g_config.on_mode_change) {
-                g_config.on_mode_change(MODE_OFF, g_current_mode);
-            }
-            return;
-        } else {
-            // Power OFF
-            ESP_LOGI(TAG, "Power OFF");
-            stereo_mode_t old_mode = g_current_mode;
-            g_powered_on = false;
-            g_current_mode = MODE_OFF;
-            send_display_notification(DISPLAY_MODE_CHANGE, "Power OFF", NULL, 1000, 150);
-            save_to_nvs();
-            if (g_config.on_mode_change) {
-                g_config.on_mode_change(old_mode, MODE_OFF);
-            }
-            return;
-        }
-    }
+static void apply_button(button_event_t event)
+{
+    trace_record(TRACE_STATE_DISPATCH, event.origin_us);
+    trace_input_handled(event.origin_us);
 
-    // ===== VOICE RECOGNITION - BUTTON 1 STARTS, BUTTON 2 STOPS =====
-    // BTN_BAND_UM = Button 1 (100kΩ resistor, threshold ~201)
-    // BTN_BAND_VF = Button 2 (68kΩ resistor, threshold ~346)
-    
-    if (event.button == BTN_BAND_UM && event.event == BTN_EVENT_PRESS) {
-        // Button 1: START voice recognition
-        if (!g_voice_recognition_active && 
-            (g_current_mode == MODE_BLUETOOTH || g_current_mode == MODE_RADIO)) {
-            ESP_LOGI(TAG, "Button 1 (BAND_UM): Starting voice recognition");
-            esp_err_t ret = a2dpSinkHfpHf_start_voice_recognition();
-            if (ret == ESP_OK) {
-                g_voice_recognition_active = true;
-                send_display_notification(DISPLAY_MODE_CHANGE, 
-                                        "Voice Assistant", 
-                                        "Listening...", 
-                                        0, 200);
-            } else {
-                ESP_LOGE(TAG, "Failed to start voice recognition: %s", 
-                        esp_err_to_name(ret));
-                send_display_notification(DISPLAY_MODE_CHANGE, 
-                                        "Voice Assistant", 
-                                        "Failed to Start", 
-                                        2000, 200);
-            }
-        } else if (g_voice_recognition_active) {
-            ESP_LOGW(TAG, "Voice recognition already active");
-        } else {
-            ESP_LOGW(TAG, "Voice recognition not available in current mode");
-        }
-        return;
-    }
+    DLOGI(TAG, "Button: btn=%d, type=%d, mode=%d", event.button, event.event, g_current_mode);
 
-    if (event.button == BTN_BAND_VF && event.event == BTN_EVENT_PRESS) {
-        // Button 2: STOP voice recognition
-        if (g_voice_recognition_active) {
-            ESP_LOGI(TAG, "Button 2 (BAND_VF): Stopping voice recognition");
-            esp_err_t ret = a2dpSinkHfpHf_stop_voice_recognition();
-            if (ret == ESP_OK) {
-                g_voice_recognition_active = false;
-                send_display_notification(DISPLAY_MODE_CHANGE, 
-                                        "Voice Assistant", 
-                                        "Stopped", 
-                                        1500, 180);
-            } else {
-                ESP_LOGE(TAG, "Failed to stop voice recognition: %s", 
-                        esp_err_to_name(ret));
-            }
-        } else {
-            ESP_LOGW(TAG, "Voice recognition not active");
-        }
+    if (event.button >= ACTION_BUTTONS || event.event >= ACTION_EVENTS ||
+        g_current_mode >= ACTION_MODES) {
         return;
     }
 
-    // If system is off, ignore all other buttons/events
-    if (g_current_mode == MODE_OFF) {
+    uint8_t action = g_button_actions[g_current_mode][event.button][event.event];
+    if (action == ACTION_NONE) return;
+    if (g_action_needs_bt[action] && !g_bt_ready) {
+        DLOGW(TAG, "Bluetooth not up yet, button ignored");
         return;
     }
+    g_action_handlers[action](&event);
+}
 
-    // ===== MODE-SPECIFIC BUTTON HANDLING =====
-    switch (g_current_mode) {
-        case MODE_BLUETOOTH:
-            handle_bluetooth_mode(event);
-            break;
-        case MODE_RADIO:
-            handle_radio_mode(event);
-            break;
-        case MODE_PHONE_CALL:
-            handle_phone_call_mode(event);
-            break;
-        case MODE_PHONEBOOK:
-            handle_phonebook_mode(event);
-            break;
-        default:
-            break;
-    }
+// The BT stack finished init: volume control can register with it
+static void apply_bt_ready(void)
+{
+    if (g_bt_ready) return;
+    bt_volume_config_t vol_config = {
+        .default_a2dp_volume = g_a2dp_state.volume,
+        .default_hfp_speaker_volume = g_hfp_state.speaker_volume,
+        .default_hfp_mic_volume = g_hfp_state.mic_volume,
+        .on_volume_change = on_bt_volume_changed
+    };
+    bt_volume_control_init(&vol_config);
+    g_bt_ready = true;
+    ESP_LOGI(TAG, "Bluetooth ready");
 }
 
 stereo_mode_t stereo_state_get_mode(void)
@@ -723,7 +1855,7 @@ stereo_mode_t stereo_state_get_mode(void)
     return g_current_mode;
 }
 
-void stereo_state_set_power(bool on)
+static void apply_set_power(bool on)
 {
     if (on == g_powered_on) return;
     
@@ -737,7 +1869,12 @@ void stereo_state_set_power(bool on)
         send_display_notification(DISPLAY_MODE_CHANGE, "Power OFF", "Goodbye", 2000, 200);
     }
     
-    save_to_nvs();
+    // Powering off is the last chance before ignition drops: write through
+    if (on) {
+        save_to_nvs();
+    } else {
+        flush_nvs();
+    }
     if (g_config.on_mode_change) g_config.on_mode_change(MODE_OFF, g_current_mode);
 }
 
@@ -784,15 +1921,19 @@ static void auto_power_on_if_off(stereo_mode_t target_mode, const char *reason)
     }
 }
 
-void stereo_state_hfp_call_status(bool call_active, const char *caller_id)
+static void apply_hfp_call_status(bool call_active, const char *caller_id)
 {
     if (call_active && g_current_mode != MODE_PHONE_CALL) {
         ESP_LOGI(TAG, "Incoming call: %s", caller_id ? caller_id : "Unknown");
         
-        // Store caller ID
+        // Store caller ID, shown as the contact name when the number is known
         if (caller_id) {
-            strncpy(g_caller_id, caller_id, sizeof(g_caller_id) - 1);
+            strncpy(g_hfp_state.caller_id, caller_id, sizeof(g_hfp_state.caller_id) - 1);
+            if (!phonebook_store_caller_name(caller_id, g_caller_id, sizeof(g_caller_id))) {
+                strncpy(g_caller_id, caller_id, sizeof(g_caller_id) - 1);
+            }
         } else {
+            g_hfp_state.caller_id[0] = '\0';
             strcpy(g_caller_id, "Unknown Caller");
         }
         
@@ -834,46 +1975,63 @@ void stereo_state_hfp_call_status(bool call_active, const char *caller_id)
     }
 }
 
-void stereo_state_rds_update(const char *station_name, const char *song_info)
+static void apply_rds_update(const char *station_name, const char *song_info)
 {
     if (g_current_mode != MODE_RADIO) return;
     
+    // PS/RT repeat in every RDS group; only redraw when the text changes
     if (station_name) {
-        strncpy(g_radio_state.station_name, station_name, sizeof(g_radio_state.station_name) - 1);
-        send_display_notification(DISPLAY_RADIO_STATION, station_name, NULL, 5000, 80);
+        uint32_t hash = text_hash(station_name);
+        if (hash != g_rds_station_hash) {
+            g_rds_station_hash = hash;
+            strncpy(g_radio_state.station_name, station_name, sizeof(g_radio_state.station_name) - 1);
+            station_index_set_fm_name(radio_freq_khz(), station_name);
+            save_to_nvs();
+            send_display_notification(DISPLAY_RADIO_STATION, station_name, NULL, 5000, 80);
+        }
     }
     
     if (song_info) {
-        strncpy(g_radio_state.song_info, song_info, sizeof(g_radio_state.song_info) - 1);
-        send_display_notification(DISPLAY_RADIO_SONG, song_info, station_name, 5000, 80);
+        uint32_t hash = text_hash(song_info);
+        if (hash != g_rds_song_hash) {
+            g_rds_song_hash = hash;
+            strncpy(g_radio_state.song_info, song_info, sizeof(g_radio_state.song_info) - 1);
+            send_display_notification(DISPLAY_RADIO_SONG, song_info, station_name, 5000, 80);
+        }
     }
 }
 
-void stereo_state_a2dp_metadata(const char *title, const char *artist, const char *album)
+static void apply_a2dp_metadata(const char *title, const char *artist, const char *album)
 {
     if (g_current_mode != MODE_BLUETOOTH) return;
     
-    // Only show title/artist, not album!
-    if (title) {
-        strncpy(g_a2dp_state.track, title, sizeof(g_a2dp_state.track) - 1);
-        g_a2dp_state.track[sizeof(g_a2dp_state.track) - 1] = '\0';
-    }
-    if (artist) {
-        strncpy(g_a2dp_state.artist, artist, sizeof(g_a2dp_state.artist) - 1);
-        g_a2dp_state.artist[sizeof(g_a2dp_state.artist) - 1] = '\0';
-    }
+    const char *text[META_FIELD_COUNT] = {
+        [META_TITLE] = title,
+        [META_ARTIST] = artist,
+        [META_ALBUM] = album,
+    };
+    metadata_ingest(text);
+}
 
-    // Only display title on line 1, artist on line 2 for 5 seconds
-    send_display_notification(
-        DISPLAY_BT_TRACK,      // or an appropriate type, e.g., DISPLAY_MODE_CHANGE
-        (title && *title) ? title : "",
-        (artist && *artist) ? artist : "",
-        5000,
-        80
-    );
+// Put the tuner on the station a profile last listened to
+static void restore_radio_source(const persisted_bt_profile_t *rec)
+{
+    memset(&g_radio_station, 0, sizeof(g_radio_station));
+    g_radio_station.kind = rec->station_kind;
+    g_radio_station.freq_khz = rec->station_khz;
+    g_radio_station.service_id = rec->service_id;
+    g_radio_station.component_id = rec->component_id;
+    if (rec->station_kind == STATION_KIND_FM) {
+        g_radio_state.frequency = rec->station_khz / 1000.0f;
+    }
+    rds_reset();
+    g_radio_state.station_name[0] = '\0';
+    g_radio_state.song_info[0] = '\0';
+    g_browsing_station_idx = browse_position();
+    save_to_nvs();
 }
 
-void stereo_state_bt_device_connected(const uint8_t *device_addr)
+static void apply_bt_device_connected(const uint8_t *device_addr)
 {
     if (!device_addr) return;
     
@@ -882,79 +2040,84 @@ void stereo_state_bt_device_connected(const uint8_t *device_addr)
              device_addr[3], device_addr[4], device_addr[5]);
     
     memcpy(g_current_bt_device_mac, device_addr, 6);
+    g_bt_device_connected = true;
+    phonebook_store_watch_sync();     // The phone's PBAP download follows the connect
     
-    int idx = find_bt_device_by_mac(device_addr);
-    if (idx >= 0) {
-        // Retrieve saved volumes
-        uint8_t saved_a2dp_vol = g_bt_devices[idx].a2dp_volume;
-        uint8_t saved_hfp_speaker_vol = g_bt_devices[idx].hfp_speaker_volume;
-        uint8_t saved_hfp_mic_vol = g_bt_devices[idx].hfp_mic_volume;
-        
-        ESP_LOGI(TAG, "Restoring volumes: A2DP=%d, HFP_SPK=%d, HFP_MIC=%d",
-                 saved_a2dp_vol, saved_hfp_speaker_vol, saved_hfp_mic_vol);
-        
-        // Update global state
-        g_a2dp_state.volume = saved_a2dp_vol;
-        g_hfp_state.speaker_volume = saved_hfp_speaker_vol;
-        g_hfp_state.mic_volume = saved_hfp_mic_vol;
-        
-        // Apply volumes by calling component APIs
-        a2dpSinkHfpHf_set_a2dp_volume(saved_a2dp_vol);
-        a2dpSinkHfpHf_set_hfp_speaker_volume(saved_hfp_speaker_vol);
-        a2dpSinkHfpHf_set_hfp_mic_volume(saved_hfp_mic_vol);
-        
-        // Optional: Notify user
-        send_display_notification(DISPLAY_MODE_CHANGE,
-                                  "Device Connected",
-                                  "Volumes Restored",
-                                  2000, 140);
-        
-    } else {
-        // New device - apply default volumes
+    int idx = find_bt_profile(device_addr);
+    if (idx < 0) {
+        // New device - it starts out with the current volumes
         ESP_LOGI(TAG, "New device. Applying default volumes.");
+        bt_profile_create(device_addr);
         
-        // Use defaults (replace with your defaults)
-        uint8_t default_a2dp_volume = g_a2dp_state.volume;
-        uint8_t default_hfp_speaker_volume = g_hfp_state.speaker_volume;
-        uint8_t default_hfp_mic_volume = g_hfp_state.mic_volume;
-        
-        a2dpSinkHfpHf_set_a2dp_volume(default_a2dp_volume);
-        a2dpSinkHfpHf_set_hfp_speaker_volume(default_hfp_speaker_volume);
-        a2dpSinkHfpHf_set_hfp_mic_volume(default_hfp_mic_volume);
+        a2dpSinkHfpHf_set_a2dp_volume(g_a2dp_state.volume);
+        a2dpSinkHfpHf_set_hfp_speaker_volume(g_hfp_state.speaker_volume);
+        a2dpSinkHfpHf_set_hfp_mic_volume(g_hfp_state.mic_volume);
         
         send_display_notification(DISPLAY_MODE_CHANGE,
                                   "New Device",
                                   "Default Volumes",
                                   2000, 140);
+        return;
+    }
+    
+    bt_profile_touch(idx);
+    const persisted_bt_profile_t *rec = &g_bt_profiles[idx].rec;
+    ESP_LOGI(TAG, "Restoring profile: A2DP=%d, HFP_SPK=%d, HFP_MIC=%d, mode %d, track at %lu s",
+             rec->a2dp_volume, rec->hfp_speaker_volume, rec->hfp_mic_volume,
+             rec->last_mode, (unsigned long)(rec->track_pos_ms / 1000));
+    
+    g_a2dp_state.volume = rec->a2dp_volume;
+    g_hfp_state.speaker_volume = rec->hfp_speaker_volume;
+    g_hfp_state.mic_volume = rec->hfp_mic_volume;
+    a2dpSinkHfpHf_set_a2dp_volume(rec->a2dp_volume);
+    a2dpSinkHfpHf_set_hfp_speaker_volume(rec->hfp_speaker_volume);
+    a2dpSinkHfpHf_set_hfp_mic_volume(rec->hfp_mic_volume);
+    
+    // If the phone resumes the same title, its position carries on from here
+    g_track_hash = rec->track_hash;
+    g_track_pos_ms = rec->track_pos_ms;
+    
+    // Source and mode only follow the phone while the stereo is playing
+    // something; a call, the phonebook or standby are left alone
+    if (g_powered_on && (g_current_mode == MODE_RADIO || g_current_mode == MODE_BLUETOOTH)) {
+        if (rec->station_khz) {
+            restore_radio_source(rec);
+            if (g_current_mode == MODE_RADIO && rec->last_mode == MODE_RADIO) radio_retune();
+        }
+        if (rec->last_mode == MODE_RADIO || rec->last_mode == MODE_BLUETOOTH) {
+            apply_set_mode((stereo_mode_t)rec->last_mode);
+        }
     }
+    
+    send_display_notification(DISPLAY_MODE_CHANGE,
+                              "Device Connected",
+                              "Profile Restored",
+                              2000, 140);
 }
 
 
-void stereo_state_bt_device_disconnected(const uint8_t *device_addr)
+static void apply_bt_device_disconnected(const uint8_t *device_addr)
 {
+    // Whatever plays after a reconnect is news, even if it is the same track
+    metadata_reset();
+    track_set_streaming(false);
+    
+    // The GAP callback has no address for a disconnect: it is the connected one
+    if (!device_addr && g_bt_device_connected) device_addr = g_current_bt_device_mac;
     if (!device_addr) return;
     
     ESP_LOGI(TAG, "BT device disconnected");
     
-    int idx = find_bt_device_by_mac(device_addr);
-    if (idx < 0) idx = find_free_bt_device_slot();
-    
-    memcpy(g_bt_devices[idx].mac_addr, device_addr, 6);
-    g_bt_devices[idx].a2dp_volume = g_a2dp_state.volume;
-    g_bt_devices[idx].hfp_speaker_volume = g_hfp_state.speaker_volume;
-    g_bt_devices[idx].hfp_mic_volume = g_hfp_state.mic_volume;
-    g_bt_devices[idx].valid = true;
+    int idx = find_bt_profile(device_addr);
+    if (idx < 0) idx = bt_profile_create(device_addr);
+    bt_profile_capture(idx);
+    bt_profiles_flush();
     
-    save_bt_device_settings();
+    g_bt_device_connected = false;
     memset(g_current_bt_device_mac, 0, 6);
 }
 
-void stereo_state_save(void)
-{
-    save_to_nvs();
-}
-
-void stereo_state_set_mode(stereo_mode_t mode)
+static void apply_set_mode(stereo_mode_t mode)
 {
     if (mode == g_current_mode) return;
     
@@ -976,15 +2139,448 @@ void stereo_state_set_mode(stereo_mode_t mode)
     }
 }
 
-void stereo_state_a2dp_streaming(bool streaming)
+static void apply_a2dp_streaming(bool streaming)
 {
     g_a2dp_state.playing = streaming;
+    track_set_streaming(streaming);
     
     if (streaming) {
         ESP_LOGI(TAG, "A2DP audio streaming started");
+        note_first_audio("A2DP");
         // **AUTO-POWER-ON if system is OFF, or switch to BT mode if already on**
         auto_power_on_if_off(MODE_BLUETOOTH, "Music Playing");
     } else {
         ESP_LOGI(TAG, "A2DP audio streaming stopped");
     }
 }
+
+static void apply_scan_done(uint16_t count)
+{
+    g_browsing_station_idx = browse_position();
+    if (g_current_mode == MODE_RADIO) {
+        // The scan left the tuner on whatever it probed last
+        radio_retune();
+        char msg[24];
+        snprintf(msg, sizeof(msg), "%u Stations", count);
+        send_display_notification(DISPLAY_MODE_CHANGE, "Scan Complete", msg, 2000, 110);
+    }
+}
+
+// ============================================================================
+// EVENT LOOP
+// ============================================================================
+
+// Producers never block: a full queue means the state task is wedged, and
+// dropping an input beats stalling the BT stack or an input ISR path
+static bool state_post(const state_event_t *event)
+{
+    if (!g_state_queue) {
+        DLOGW(TAG, "State event %d before init, dropped", event->type);
+        return false;
+    }
+    if (xQueueSend(g_state_queue, event, 0) != pdTRUE) {
+        DLOGW(TAG, "State queue full, event %d dropped", event->type);
+        return false;
+    }
+    return true;
+}
+
+static void state_dispatch(const state_event_t *e)
+{
+    switch (e->type) {
+        case STATE_EVT_BUTTON:
+            apply_button(e->button);
+            break;
+        case STATE_EVT_SET_POWER:
+            apply_set_power(e->on);
+            break;
+        case STATE_EVT_SET_MODE:
+            apply_set_mode(e->mode);
+            break;
+        case STATE_EVT_CALL_STATUS:
+            apply_hfp_call_status(e->call.active,
+                                  e->call.has_caller_id ? e->call.caller_id : NULL);
+            break;
+        case STATE_EVT_RDS:
+            apply_rds_update(e->rds.has_station ? e->rds.station : NULL,
+                             e->rds.has_song ? e->rds.song : NULL);
+            break;
+        case STATE_EVT_A2DP_METADATA:
+            apply_a2dp_metadata(e->metadata.has_title ? e->metadata.title : NULL,
+                                e->metadata.has_artist ? e->metadata.artist : NULL,
+                                e->metadata.has_album ? e->metadata.album : NULL);
+            break;
+        case STATE_EVT_A2DP_STREAMING:
+            apply_a2dp_streaming(e->on);
+            break;
+        case STATE_EVT_BT_CONNECTED:
+            apply_bt_device_connected(e->bt.has_addr ? e->bt.addr : NULL);
+            break;
+        case STATE_EVT_BT_DISCONNECTED:
+            apply_bt_device_disconnected(e->bt.has_addr ? e->bt.addr : NULL);
+            break;
+        case STATE_EVT_BT_READY:
+            apply_bt_ready();
+            break;
+        case STATE_EVT_BT_VOLUME:
+            apply_bt_volume_changed(e->volume.target, e->volume.volume);
+            break;
+        case STATE_EVT_DEFERRED:
+            deferred_fire(e->deferred.action, e->deferred.gen);
+            break;
+        case STATE_EVT_SAVE:
+            flush_nvs();
+            // Monotonic: a save that timed out and ran late must not undo a newer one
+            if ((int32_t)(e->save_seq - g_save_done_seq) > 0) g_save_done_seq = e->save_seq;
+            xSemaphoreGive(g_save_done);
+            break;
+        case STATE_EVT_SCAN_DONE:
+            apply_scan_done(e->station_count);
+            break;
+    }
+}
+
+static audio_source_t source_for_mode(stereo_mode_t mode)
+{
+    switch (mode) {
+        case MODE_RADIO:      return AUDIO_SOURCE_RADIO;
+        case MODE_BLUETOOTH:  return AUDIO_SOURCE_BLUETOOTH;
+        case MODE_PHONE_CALL: return AUDIO_SOURCE_PHONE;
+        case MODE_PHONEBOOK:  // Browsing contacts keeps what was playing
+            return g_mode_before_phonebook == MODE_PHONEBOOK ? AUDIO_SOURCE_NONE
+                                                             : source_for_mode(g_mode_before_phonebook);
+        default:              return AUDIO_SOURCE_NONE;
+    }
+}
+
+// The tuner is free for background work whenever it is not being listened
+// to, and stays parked on the last station so radio resumes without a
+// retune; in MODE_OFF it is powered down with the rest of the system
+static void mode_changed(stereo_mode_t mode)
+{
+    static bool standby = false;
+    bool off = mode == MODE_OFF;
+
+    station_index_set_background(mode == MODE_BLUETOOTH);
+    station_index_set_power(!off);
+    if (off != standby) {
+        standby = off;
+        ESP_LOGI(TAG, "%s standby", off ? "Entering" : "Leaving");
+        if (g_config.on_standby) g_config.on_standby(off);
+    }
+    if (mode == MODE_RADIO) {
+        radio_retune();     // No-op while the tuner is still parked there
+    }
+    source_select(source_for_mode(mode));
+}
+
+#if CONFIG_CAR_STEREO_EVENT_RECORD
+// "text" with quotes and backslashes escaped, or - for a missing field
+static void record_quote(char *dst, size_t size, const char *src, bool present)
+{
+    size_t n = 0;
+    if (!present) {
+        snprintf(dst, size, "-");
+        return;
+    }
+    dst[n++] = '"';
+    for (; *src && n + 3 < size; src++) {
+        if (*src == '"' || *src == '\\') dst[n++] = '\\';
+        dst[n++] = *src;
+    }
+    dst[n++] = '"';
+    dst[n] = '\0';
+}
+
+static void record_mac(char *dst, size_t size, const uint8_t *mac, bool present)
+{
+    if (!present) {
+        snprintf(dst, size, "-");
+        return;
+    }
+    snprintf(dst, size, "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+// One "EVT <ms> <event> <args>" line per external event, in dispatch order,
+// for host/ to replay. Timer and scan events are left out: the replay's own
+// clock and tuner recreate them.
+static void record_event(const state_event_t *e)
+{
+    char a[132], b[132], c[132];
+    unsigned long ms = (unsigned long)(esp_timer_get_time() / 1000);
+    switch (e->type) {
+        case STATE_EVT_BUTTON:
+            ESP_LOGI(TAG, "EVT %lu button %d %d %u %u %u", ms, e->button.button, e->button.event,
+                     e->button.detents, e->button.steps, e->button.velocity);
+            break;
+        case STATE_EVT_SET_POWER:
+            ESP_LOGI(TAG, "EVT %lu power %d", ms, e->on);
+            break;
+        case STATE_EVT_SET_MODE:
+            ESP_LOGI(TAG, "EVT %lu mode %d", ms, e->mode);
+            break;
+        case STATE_EVT_CALL_STATUS:
+            record_quote(a, sizeof(a), e->call.caller_id, e->call.has_caller_id);
+            ESP_LOGI(TAG, "EVT %lu call %d %s", ms, e->call.active, a);
+            break;
+        case STATE_EVT_RDS:
+            record_quote(a, sizeof(a), e->rds.station, e->rds.has_station);
+            record_quote(b, sizeof(b), e->rds.song, e->rds.has_song);
+            ESP_LOGI(TAG, "EVT %lu rds %s %s", ms, a, b);
+            break;
+        case STATE_EVT_A2DP_METADATA:
+            record_quote(a, sizeof(a), e->metadata.title, e->metadata.has_title);
+            record_quote(b, sizeof(b), e->metadata.artist, e->metadata.has_artist);
+            record_quote(c, sizeof(c), e->metadata.album, e->metadata.has_album);
+            ESP_LOGI(TAG, "EVT %lu meta %s %s %s", ms, a, b, c);
+            break;
+        case STATE_EVT_A2DP_STREAMING:
+            ESP_LOGI(TAG, "EVT %lu stream %d", ms, e->on);
+            break;
+        case STATE_EVT_BT_CONNECTED:
+        case STATE_EVT_BT_DISCONNECTED:
+            record_mac(a, sizeof(a), e->bt.addr, e->bt.has_addr);
+            ESP_LOGI(TAG, "EVT %lu %s %s", ms,
+                     e->type == STATE_EVT_BT_CONNECTED ? "connect" : "disconnect", a);
+            break;
+        case STATE_EVT_BT_VOLUME:
+            ESP_LOGI(TAG, "EVT %lu btvol %d %u", ms, e->volume.target, e->volume.volume);
+            break;
+        case STATE_EVT_BT_READY:
+            ESP_LOGI(TAG, "EVT %lu btready", ms);
+            break;
+        case STATE_EVT_SAVE:
+            ESP_LOGI(TAG, "EVT %lu save", ms);
+            break;
+        case STATE_EVT_DEFERRED:
+        case STATE_EVT_SCAN_DONE:
+            break;
+    }
+}
+#endif
+
+// Last mode and A2DP volume the side effects were run for (state task)
+static stereo_mode_t g_loop_mode;
+static uint8_t g_loop_a2dp_volume;
+
+static void state_loop_start(void)
+{
+    g_loop_mode = g_current_mode;
+    g_loop_a2dp_volume = g_a2dp_state.volume;
+    mode_changed(g_loop_mode);
+    if (g_config.on_a2dp_volume) g_config.on_a2dp_volume(g_loop_a2dp_volume);
+}
+
+static void state_handle(const state_event_t *event)
+{
+    UBaseType_t depth = uxQueueMessagesWaiting(g_state_queue) + 1;
+    if (depth > g_stats.queue_depth_max) g_stats.queue_depth_max = (uint8_t)depth;
+#if CONFIG_CAR_STEREO_EVENT_RECORD
+    record_event(event);
+#endif
+    int64_t start = esp_timer_get_time();
+    state_dispatch(event);
+    uint32_t took = (uint32_t)(esp_timer_get_time() - start);
+    g_stats.events++;
+    g_stats.dispatch_us_total += took;
+    if (took > g_stats.dispatch_us_max) g_stats.dispatch_us_max = took;
+    // Mode changes happen in many handlers; react to them in one place
+    if (g_current_mode != g_loop_mode) {
+        g_loop_mode = g_current_mode;
+        mode_changed(g_loop_mode);
+    }
+    // Buttons, the phone and profile restores all set the A2DP volume
+    if (g_a2dp_state.volume != g_loop_a2dp_volume) {
+        g_loop_a2dp_volume = g_a2dp_state.volume;
+        if (g_config.on_a2dp_volume) g_config.on_a2dp_volume(g_loop_a2dp_volume);
+    }
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+size_t stereo_state_host_drain(void)
+{
+    state_event_t event;
+    size_t count = 0;
+    while (xQueueReceive(g_state_queue, &event, 0) == pdTRUE) {
+        state_handle(&event);
+        count++;
+    }
+    return count;
+}
+#else
+static void state_task(void *arg)
+{
+    state_event_t event;
+    state_loop_start();
+    while (1) {
+        if (xQueueReceive(g_state_queue, &event, portMAX_DELAY) == pdTRUE) {
+            state_handle(&event);
+        }
+    }
+}
+#endif
+
+// Copy an optional string into a fixed event field; NULL stays distinguishable
+static bool copy_field(char *dst, size_t size, const char *src)
+{
+    if (!src) return false;
+    strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+    return true;
+}
+
+// ============================================================================
+// EVENT PRODUCERS (safe from any task)
+// ============================================================================
+
+void stereo_state_handle_button(button_event_t button)
+{
+    state_event_t event = { .type = STATE_EVT_BUTTON, .button = button };
+    state_post(&event);
+}
+
+void stereo_state_set_power(bool on)
+{
+    state_event_t event = { .type = STATE_EVT_SET_POWER, .on = on };
+    state_post(&event);
+}
+
+void stereo_state_set_mode(stereo_mode_t mode)
+{
+    state_event_t event = { .type = STATE_EVT_SET_MODE, .mode = mode };
+    state_post(&event);
+}
+
+void stereo_state_hfp_call_status(bool call_active, const char *caller_id)
+{
+    state_event_t event = { .type = STATE_EVT_CALL_STATUS };
+    event.call.active = call_active;
+    event.call.has_caller_id = copy_field(event.call.caller_id,
+                                          sizeof(event.call.caller_id), caller_id);
+    state_post(&event);
+}
+
+void stereo_state_rds_update(const char *station_name, const char *song_info)
+{
+    state_event_t event = { .type = STATE_EVT_RDS };
+    event.rds.has_station = copy_field(event.rds.station, sizeof(event.rds.station), station_name);
+    event.rds.has_song = copy_field(event.rds.song, sizeof(event.rds.song), song_info);
+    state_post(&event);
+}
+
+void stereo_state_a2dp_metadata(const char *title, const char *artist, const char *album)
+{
+    state_event_t event = { .type = STATE_EVT_A2DP_METADATA };
+    event.metadata.has_title = copy_field(event.metadata.title, sizeof(event.metadata.title), title);
+    event.metadata.has_artist = copy_field(event.metadata.artist, sizeof(event.metadata.artist), artist);
+    event.metadata.has_album = copy_field(event.metadata.album, sizeof(event.metadata.album), album);
+    state_post(&event);
+}
+
+void stereo_state_a2dp_streaming(bool streaming)
+{
+    state_event_t event = { .type = STATE_EVT_A2DP_STREAMING, .on = streaming };
+    state_post(&event);
+}
+
+void stereo_state_get_stats(stereo_state_stats_t *stats)
+{
+    // Unlocked: the counters only grow, a racing read is at most one event behind
+    *stats = g_stats;
+}
+
+void stereo_state_bt_device_connected(const uint8_t *device_addr)
+{
+    state_event_t event = { .type = STATE_EVT_BT_CONNECTED };
+    if (device_addr) {
+        event.bt.has_addr = true;
+        memcpy(event.bt.addr, device_addr, sizeof(event.bt.addr));
+    }
+    state_post(&event);
+}
+
+void stereo_state_bt_device_disconnected(const uint8_t *device_addr)
+{
+    state_event_t event = { .type = STATE_EVT_BT_DISCONNECTED };
+    if (device_addr) {
+        event.bt.has_addr = true;
+        memcpy(event.bt.addr, device_addr, sizeof(event.bt.addr));
+    }
+    state_post(&event);
+}
+
+void stereo_state_bt_ready(void)
+{
+    if (!g_state_queue) return;
+    // Once per boot and not from a BT callback: wait for room rather than drop it
+    state_event_t event = { .type = STATE_EVT_BT_READY };
+    xQueueSend(g_state_queue, &event, portMAX_DELAY);
+}
+
+static void on_bt_volume_changed(bt_volume_target_t target, uint8_t new_volume)
+{
+    state_event_t event = { .type = STATE_EVT_BT_VOLUME };
+    event.volume.target = target;
+    event.volume.volume = new_volume;
+    state_post(&event);
+}
+
+// Runs in the scan task
+static void on_station_scan_done(size_t count)
+{
+    state_event_t event = { .type = STATE_EVT_SCAN_DONE };
+    event.station_count = (uint16_t)count;
+    state_post(&event);
+}
+
+static TickType_t ticks_until(TickType_t deadline)
+{
+    TickType_t now = xTaskGetTickCount();
+    return (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+}
+
+esp_err_t stereo_state_save(void)
+{
+    if (!g_state_queue) {
+        return ESP_ERR_INVALID_STATE;   // Before init nothing can be waiting to be written
+    }
+    if (xTaskGetCurrentTaskHandle() == g_state_task) {
+        flush_nvs();
+        return ESP_OK;
+    }
+    
+    // The flush itself always runs on the state task, which owns the
+    // snapshot, the profile table and the deferred timers; this caller
+    // only waits for it
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(STATE_SAVE_TIMEOUT_MS);
+    if (xSemaphoreTake(g_save_lock, ticks_until(deadline)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    state_event_t event = { .type = STATE_EVT_SAVE };
+    event.save_seq = ++g_save_seq;
+    esp_err_t err = ESP_ERR_TIMEOUT;
+    // Ahead of queued input: on a supply warning getting to flash is what counts
+    if (xQueueSendToFront(g_state_queue, &event, ticks_until(deadline)) == pdTRUE) {
+        while ((int32_t)(g_save_done_seq - event.save_seq) < 0) {
+            if (xSemaphoreTake(g_save_done, ticks_until(deadline)) != pdTRUE) break;
+        }
+        if ((int32_t)(g_save_done_seq - event.save_seq) >= 0) err = ESP_OK;
+    }
+    xSemaphoreGive(g_save_lock);
+    
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "State task did not flush within %d ms", STATE_SAVE_TIMEOUT_MS);
+    }
+    return err;
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+// Shutdown handler: runs on whichever task called esp_restart(), so it goes
+// through the same state-task flush as any other caller
+static void shutdown_flush(void)
+{
+    stereo_state_save();
+}
+#endif
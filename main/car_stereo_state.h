@@ -3,8 +3,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "sdkconfig.h"
 #include "esp_err.h"
 #include "buttons.h"
+#include "station_index.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -96,13 +98,18 @@ typedef void (*display_callback_t)(display_notification_t notification);
 // Configuration
 typedef struct {
     void *fm_radio_handle;      // FM radio component handle
+    const radio_tuner_ops_t *tuner;     // Tuner driver for scan/tune (NULL = none)
     display_callback_t display_handler;  // Display notification handler
     void (*on_mode_change)(stereo_mode_t old_mode, stereo_mode_t new_mode);
+    void (*on_standby)(bool standby);   // Entering/leaving MODE_OFF (optional, state task)
+    void (*on_a2dp_volume)(uint8_t volume); // A2DP volume step changed (optional, state task)
 } stereo_config_t;
 
 /**
  * @brief Initialize car stereo state machine
- * Loads last state from NVS
+ * Loads last state from NVS and starts the state task. All state is owned by
+ * that task; the event functions below only queue an event and never block,
+ * so they are safe to call from any task, including BT stack callbacks.
  * @param config Configuration structure
  * @return ESP_OK on success
  */
@@ -114,6 +121,15 @@ esp_err_t stereo_state_init(const stereo_config_t *config);
  */
 void stereo_state_handle_button(button_event_t event);
 
+/**
+ * @brief Bluetooth stack is initialized
+ * Until this is called, buttons that would call into the stack (BT volume,
+ * AVRCP, voice recognition, call control) are ignored. Unlike the other
+ * event functions it waits for room in the queue, so it must not be called
+ * from a BT stack callback.
+ */
+void stereo_state_bt_ready(void);
+
 /**
  * @brief Handle Bluetooth device connection
  * Called when a device connects - loads its saved settings
@@ -170,9 +186,13 @@ void stereo_state_a2dp_metadata(const char *title, const char *artist, const cha
 
 /**
  * @brief Save current state to NVS (for power cycle persistence)
- * Called automatically, but can be called manually for immediate save
+ * State changes are written behind after a short debounce; this forces an
+ * immediate flush (e.g. from a supply-loss / brown-out warning). The
+ * state task does the write; the caller blocks until it is in flash.
+ * @return ESP_OK once flushed, ESP_ERR_TIMEOUT if the state task did not
+ *         get to it within a second, ESP_ERR_INVALID_STATE before init
  */
-void stereo_state_save(void);
+esp_err_t stereo_state_save(void);
 
 /**
  * @brief Set operating mode
@@ -186,6 +206,34 @@ void stereo_state_set_mode(stereo_mode_t mode);
  */
 void stereo_state_a2dp_streaming(bool streaming);
 
+/**
+ * @brief State machine counters since boot
+ */
+typedef struct {
+    uint32_t events;            // Events dispatched by the state task
+    uint32_t dispatch_us_max;   // Slowest single dispatch
+    uint64_t dispatch_us_total; // Sum over all dispatches
+    uint32_t nvs_commits;       // NVS commits issued by the state machine
+    uint8_t queue_depth_max;    // Most events waiting in the state queue
+} stereo_state_stats_t;
+
+/**
+ * @brief Snapshot the state machine counters
+ * @param stats Receives the counters
+ */
+void stereo_state_get_stats(stereo_state_stats_t *stats);
+
+#if CONFIG_IDF_TARGET_LINUX
+/**
+ * @brief Dispatch every queued event on the calling task (host builds only)
+ * On the linux target stereo_state_init() starts no state task: the task
+ * that called it owns the state and runs the event loop through this, so
+ * the host harness decides exactly when each event is handled.
+ * @return Number of events dispatched
+ */
+size_t stereo_state_host_drain(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,97 @@
+/*
+ * Deferred Logging
+ * Rate-limited RAM ring for log lines from latency-sensitive tasks
+ */
+
+#include "deferred_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TAG "DLOG"
+
+#define DLOG_LINES          32          // Power of two
+#define DLOG_LINE_LEN       96
+#define DLOG_RATE_PER_SEC   10          // Lines accepted per one-second window
+
+typedef struct {
+    const char *tag;
+    uint32_t at_ms;
+    uint8_t level;
+    char text[DLOG_LINE_LEN];
+} dlog_line_t;
+
+static dlog_line_t g_lines[DLOG_LINES];
+static uint32_t g_head = 0;                 // Next line to write
+static uint32_t g_tail = 0;                 // Next line to print
+static uint32_t g_window_ms = 0;            // Start of the current rate window
+static uint16_t g_window_count = 0;
+static uint32_t g_dropped_unreported = 0;
+static dlog_stats_t g_stats;
+static portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt, ...)
+{
+    char text[DLOG_LINE_LEN];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+
+    uint32_t now = (uint32_t)(esp_timer_get_time() / 1000);
+
+    portENTER_CRITICAL(&g_lock);
+    if (now - g_window_ms >= 1000) {
+        g_window_ms = now;
+        g_window_count = 0;
+    }
+    uint32_t depth = g_head - g_tail;
+    if (g_window_count < DLOG_RATE_PER_SEC && depth < DLOG_LINES) {
+        dlog_line_t *line = &g_lines[g_head++ & (DLOG_LINES - 1)];
+        line->tag = tag;
+        line->at_ms = now;
+        line->level = (uint8_t)level;
+        memcpy(line->text, text, sizeof(text));
+        g_window_count++;
+        g_stats.written++;
+        if (depth + 1 > g_stats.depth_max) g_stats.depth_max = (uint8_t)(depth + 1);
+    } else {
+        g_stats.dropped++;
+        g_dropped_unreported++;
+    }
+    portEXIT_CRITICAL(&g_lock);
+}
+
+void dlog_flush(void)
+{
+    while (1) {
+        dlog_line_t line;
+        uint32_t dropped;
+
+        portENTER_CRITICAL(&g_lock);
+        bool empty = g_tail == g_head;
+        if (!empty) {
+            line = g_lines[g_tail++ & (DLOG_LINES - 1)];
+        }
+        dropped = g_dropped_unreported;
+        g_dropped_unreported = 0;
+        portEXIT_CRITICAL(&g_lock);
+
+        if (dropped) {
+            ESP_LOGW(TAG, "%lu log lines dropped", (unsigned long)dropped);
+        }
+        if (empty) break;
+        ESP_LOG_LEVEL((esp_log_level_t)line.level, line.tag, "(%lu) %s",
+                      (unsigned long)line.at_ms, line.text);
+    }
+}
+
+void dlog_get_stats(dlog_stats_t *stats)
+{
+    portENTER_CRITICAL(&g_lock);
+    *stats = g_stats;
+    portEXIT_CRITICAL(&g_lock);
+}
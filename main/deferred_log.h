@@ -0,0 +1,58 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <stdint.h>
+#include "esp_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DLOG_FLUSH_MS           1000    // Main loop flush interval
+
+// Hot-path logging. ESP_LOGx writes to the UART from the calling task and
+// blocks it for ~90 us per character at 115200 baud once the FIFO is full;
+// a DLOGx line is formatted into a RAM ring instead and printed later by
+// the main loop. Lines over the rate budget, or with the ring full, are
+// dropped and counted. Task context only (formats with vsnprintf).
+#define DLOGW(tag, fmt, ...) do { \
+        if (LOG_LOCAL_LEVEL >= ESP_LOG_WARN) dlog_write(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__); \
+    } while (0)
+#define DLOGI(tag, fmt, ...) do { \
+        if (LOG_LOCAL_LEVEL >= ESP_LOG_INFO) dlog_write(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__); \
+    } while (0)
+
+/**
+ * @brief Deferred log counters since boot
+ */
+typedef struct {
+    uint32_t written;           // Lines queued
+    uint32_t dropped;           // Lines lost to the rate limit or a full ring
+    uint8_t depth_max;          // Most lines waiting at once
+} dlog_stats_t;
+
+/**
+ * @brief Queue one log line (use the DLOGx macros)
+ * Never blocks on the UART; the tag must be a string literal.
+ */
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief Print the queued lines through ESP_LOGx
+ * Call from one low-priority task (the main loop). Each line keeps the
+ * time it was written.
+ */
+void dlog_flush(void);
+
+/**
+ * @brief Snapshot the deferred log counters
+ * @param stats Receives the counters
+ */
+void dlog_get_stats(dlog_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEFERRED_LOG_H
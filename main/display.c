@@ -1,9 +1,15 @@
 #include "display.h"
+#include "task_map.h"
+#include "trace.h"
+#include "deferred_log.h"
+#include "sdkconfig.h"
 #include "esp_log.h"
-#include "driver/i2c.h"
+#include "driver/i2c_master.h"
 #include "esp_rom_sys.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include <string.h>
 #include <stdint.h>
 
@@ -33,6 +39,10 @@
 #define LCD_ENTRY_INC           0x02
 #define LCD_ENTRY_SHIFT         0x01
 
+// Cursor/display shift flags
+#define LCD_SHIFT_DISPLAY       0x08
+#define LCD_SHIFT_RIGHT         0x04
+
 // Display control flags
 #define LCD_DISPLAY_ON          0x04
 #define LCD_CURSOR_ON           0x02
@@ -48,77 +58,156 @@
 
 #define DEBUG_DISPLAY 0  // Set to 0 to disable debug; 1 to enable
 
+// One HD44780 byte is two nibbles, each sent as E-low / E-high / E-low
+// so RS and data are stable around both strobe edges.
+#define LCD_TX_BYTES_PER_NIBBLE 3
+#define LCD_TX_BYTES_PER_BYTE   (2 * LCD_TX_BYTES_PER_NIBBLE)
+#define LCD_TX_BUF_SIZE         256
+#define LCD_I2C_TIMEOUT_MS      50
+
+#define DISPLAY_QUEUE_LEN       8
+#define DISPLAY_FRAME_MS        40  // Minimum spacing between redraws
+#define DISPLAY_SPLASH_MS       3000
+
 static bool display_initialized = false;
+static StackType_t display_stack[TASK_DISPLAY_STACK];
+static StaticTask_t display_tcb;
+static bool splash_up = false;          // Display task holds off rendering until splash_until
+static TickType_t splash_until;
+static QueueHandle_t display_queue = NULL;
+static SemaphoreHandle_t lcd_mutex = NULL;
 static uint8_t backlight_state = LCD_BIT_BL;
 
+static i2c_master_bus_handle_t lcd_bus = NULL;
+static i2c_master_dev_handle_t lcd_dev = NULL;
+static uint32_t lcd_bus_freq = LCD_I2C_FREQ;
+
+// Batched transfer buffer: a whole command/data sequence is encoded here
+// as PCF8574 port values and sent in a single I2C transaction.
+static uint8_t lcd_tx_buf[LCD_TX_BUF_SIZE];
+static size_t lcd_tx_len = 0;
+static uint32_t lcd_i2c_bytes = 0;      // Bytes put on the bus since boot
+static uint32_t lcd_redraws = 0;
+static uint16_t lcd_redraw_last = 0;
+static uint16_t lcd_redraw_max = 0;
+static uint8_t display_queue_max = 0;   // Producer side, state task
+static uint32_t display_queue_dropped = 0;
 
+// Shadow framebuffer: lcd_glass mirrors all of DDRAM (40 cells per line),
+// lcd_frame is the next DDRAM image. The visible 16 columns start at the
+// display shift; a row marked full is diffed over all 40 cells, otherwise
+// only its visible window is.
+#define LCD_CURSOR_UNKNOWN      0xFF
+#define LCD_DDRAM_COLS          40
+static char lcd_glass[DISPLAY_ROWS][LCD_DDRAM_COLS];
+static char lcd_frame[DISPLAY_ROWS][LCD_DDRAM_COLS];
+static bool lcd_frame_full[DISPLAY_ROWS];
+static bool lcd_glass_valid = false;
+static uint8_t lcd_cursor_addr = LCD_CURSOR_UNKNOWN;
+static uint8_t lcd_glass_shift = 0;     // Current hardware display shift
+static uint8_t lcd_frame_shift = 0;     // Shift the next flush should leave
 
+// Forward declarations
+static void display_task(void *arg);
+static size_t lcd_glyph_for(uint32_t cp, char glyph[3]);
+static bool tick_reached(TickType_t now, TickType_t deadline);
 
-// Write byte to PCF8574
-static esp_err_t pcf8574_write(uint8_t data)
+
+// Send everything queued so far as one I2C write
+static esp_err_t lcd_flush(void)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (LCD_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, data, true);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(LCD_I2C_PORT, cmd, pdMS_TO_TICKS(50));
-    i2c_cmd_link_delete(cmd);
+    if (lcd_tx_len == 0) return ESP_OK;
+
+    esp_err_t ret = i2c_master_transmit(lcd_dev, lcd_tx_buf, lcd_tx_len, LCD_I2C_TIMEOUT_MS);
+    if (ret == ESP_OK) {
+        lcd_i2c_bytes += lcd_tx_len;
+    }
+    lcd_tx_len = 0;
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "I2C transmit failed: %s", esp_err_to_name(ret));
+    }
     return ret;
 }
 
-// Pulse enable pin
-static void lcd_strobe_enable(uint8_t data)
+// Queue 4 bits (upper nibble of data) with RS/E/backlight encoded
+static void lcd_queue_4bits(uint8_t data, bool is_data)
 {
-    pcf8574_write(data | LCD_BIT_E);
-    esp_rom_delay_us(1);
-    pcf8574_write(data & ~LCD_BIT_E);
-    esp_rom_delay_us(50);
-}
+    if (lcd_tx_len + LCD_TX_BYTES_PER_NIBBLE > sizeof(lcd_tx_buf)) {
+        lcd_flush();
+    }
 
-// Write 4 bits to LCD
-static void lcd_write_4bits(uint8_t data, bool is_data)
-{
-    uint8_t upper = (data & 0xF0);
-    uint8_t output = upper | backlight_state;
-    
+    uint8_t output = (data & 0xF0) | backlight_state;
     if (is_data) {
         output |= LCD_BIT_RS;
     }
-    
-    pcf8574_write(output);
-    lcd_strobe_enable(output);
+
+    // At 100-400 kHz each port update takes 22-90 us on the wire, which
+    // already covers the HD44780 setup, pulse width and 37 us execution time.
+    lcd_tx_buf[lcd_tx_len++] = output;
+    lcd_tx_buf[lcd_tx_len++] = output | LCD_BIT_E;
+    lcd_tx_buf[lcd_tx_len++] = output;
 }
 
-// Write byte in 4-bit mode
-static void lcd_write_byte(uint8_t data, bool is_data)
+// Queue byte in 4-bit mode
+static void lcd_queue_byte(uint8_t data, bool is_data)
 {
-    lcd_write_4bits(data & 0xF0, is_data);
-    lcd_write_4bits((data << 4) & 0xF0, is_data);
-    esp_rom_delay_us(50);
+    if (lcd_tx_len + LCD_TX_BYTES_PER_BYTE > sizeof(lcd_tx_buf)) {
+        lcd_flush();
+    }
+    lcd_queue_4bits(data & 0xF0, is_data);
+    lcd_queue_4bits((data << 4) & 0xF0, is_data);
+}
+
+// Send a single init nibble immediately (init needs real delays in between)
+static void lcd_write_4bits(uint8_t data, bool is_data)
+{
+    lcd_queue_4bits(data, is_data);
+    lcd_flush();
 }
 
-// Update lcd_command function:
 static void lcd_command(uint8_t cmd)
 {
     #if DEBUG_DISPLAY
     ESP_LOGI(TAG, "CMD: 0x%02X", cmd);
     #endif
     
-    lcd_write_byte(cmd, false);
+    lcd_queue_byte(cmd, false);
     if (cmd == LCD_CMD_CLEAR || cmd == LCD_CMD_HOME) {
-        vTaskDelay(pdMS_TO_TICKS(2));
+        // Clear/home take 1.52 ms, far longer than the bus naturally paces.
+        // Busy-wait: pdMS_TO_TICKS(2) rounds to 0 ticks at a 100 Hz tick.
+        lcd_flush();
+        esp_rom_delay_us(2000);
+        lcd_glass_shift = 0;    // Both also undo any display shift
     }
 }
 
-// Update lcd_data function:
 static void lcd_data(uint8_t data)
 {
     #if DEBUG_DISPLAY
     ESP_LOGI(TAG, "DATA: '%c' (0x%02X)", (data >= 32 && data <= 126) ? data : '.', data);
     #endif
     
-    lcd_write_byte(data, true);
+    lcd_queue_byte(data, true);
+}
+
+// Attach the PCF8574 backpack at the given SCL speed
+static esp_err_t lcd_add_device(uint32_t scl_speed_hz)
+{
+    if (lcd_dev) {
+        i2c_master_bus_rm_device(lcd_dev);
+        lcd_dev = NULL;
+    }
+
+    i2c_device_config_t dev_conf = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = LCD_I2C_ADDR,
+        .scl_speed_hz = scl_speed_hz,
+    };
+    esp_err_t ret = i2c_master_bus_add_device(lcd_bus, &dev_conf, &lcd_dev);
+    if (ret == ESP_OK) {
+        lcd_bus_freq = scl_speed_hz;
+    }
+    return ret;
 }
 
 // Initialize LCD
@@ -126,30 +215,49 @@ esp_err_t display_init(void)
 {
     ESP_LOGI(TAG, "Initializing I2C LCD1602 (SLC1602A3)");
     
+    lcd_mutex = xSemaphoreCreateMutex();
+    display_queue = xQueueCreate(DISPLAY_QUEUE_LEN, sizeof(display_notification_t));
+    if (!lcd_mutex || !display_queue) {
+        ESP_LOGE(TAG, "Failed to create display queue");
+        return ESP_ERR_NO_MEM;
+    }
+    
     // Configure I2C
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
+    i2c_master_bus_config_t bus_conf = {
+        .i2c_port = LCD_I2C_PORT,
         .sda_io_num = LCD_I2C_SDA,
         .scl_io_num = LCD_I2C_SCL,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = LCD_I2C_FREQ,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
     };
     
-    esp_err_t ret = i2c_param_config(LCD_I2C_PORT, &conf);
+    esp_err_t ret = i2c_new_master_bus(&bus_conf, &lcd_bus);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "I2C config failed: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "I2C bus init failed: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    ret = i2c_driver_install(LCD_I2C_PORT, conf.mode, 0, 0, 0);
-    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
-        ESP_LOGE(TAG, "I2C install failed: %s", esp_err_to_name(ret));
+    ret = lcd_add_device(LCD_I2C_FREQ);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "I2C add device failed: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    ESP_LOGI(TAG, "I2C OK - SDA:%d SCL:%d addr:0x%02X", 
-             LCD_I2C_SDA, LCD_I2C_SCL, LCD_I2C_ADDR);
+    // Not every SLC1602A3 backpack is happy at fast mode; drop back to 100kHz
+    lcd_tx_buf[lcd_tx_len++] = backlight_state;
+    if (lcd_flush() != ESP_OK && LCD_I2C_FREQ > LCD_I2C_FREQ_STD) {
+        ESP_LOGW(TAG, "LCD not responding at %d Hz, falling back to %d Hz",
+                 LCD_I2C_FREQ, LCD_I2C_FREQ_STD);
+        ret = lcd_add_device(LCD_I2C_FREQ_STD);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "I2C add device failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    
+    ESP_LOGI(TAG, "I2C OK - SDA:%d SCL:%d addr:0x%02X freq:%luHz", 
+             LCD_I2C_SDA, LCD_I2C_SCL, LCD_I2C_ADDR, (unsigned long)lcd_bus_freq);
     
     // Wait for LCD power-up
     vTaskDelay(pdMS_TO_TICKS(50));
@@ -174,19 +282,63 @@ esp_err_t display_init(void)
     lcd_command(LCD_CMD_DISPLAY_CTRL | LCD_DISPLAY_ON);
     lcd_command(LCD_CMD_CLEAR);
     lcd_command(LCD_CMD_ENTRY_MODE | LCD_ENTRY_INC);
+    lcd_flush();
+    memset(lcd_glass, ' ', sizeof(lcd_glass));
+    lcd_glass_valid = true;
+    lcd_cursor_addr = 0;
     
     display_initialized = true;
     ESP_LOGI(TAG, "LCD initialized successfully!");
     
     display_show_splash();
+    
+#if CONFIG_IDF_TARGET_LINUX
+    // Host build: the linux FreeRTOS port has a single core to pin to
+    TaskHandle_t task = xTaskCreateStatic(display_task, "display", TASK_DISPLAY_STACK, NULL,
+                                          TASK_DISPLAY_PRIO, display_stack, &display_tcb);
+#else
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(display_task, "display", TASK_DISPLAY_STACK,
+                                                      NULL, TASK_DISPLAY_PRIO, display_stack,
+                                                      &display_tcb, TASK_DISPLAY_CORE);
+#endif
+    if (!task) {
+        ESP_LOGE(TAG, "Failed to create display task");
+        return ESP_ERR_NO_MEM;
+    }
     return ESP_OK;
 }
 
+// Forget what is on the glass; the next flush rewrites every cell
+static void lcd_glass_invalidate(void)
+{
+    lcd_glass_valid = false;
+    lcd_cursor_addr = LCD_CURSOR_UNKNOWN;
+}
+
+// The display task owns the LCD, but the public draw calls may still come
+// from other tasks, so every bus/framebuffer access goes through lcd_mutex.
+static void lcd_lock(void)
+{
+    xSemaphoreTake(lcd_mutex, portMAX_DELAY);
+}
+
+static void lcd_unlock(void)
+{
+    xSemaphoreGive(lcd_mutex);
+}
+
 // Clear display
 void display_clear(void)
 {
     if (!display_initialized) return;
+    lcd_lock();
     lcd_command(LCD_CMD_CLEAR);
+    memset(lcd_glass, ' ', sizeof(lcd_glass));
+    memset(lcd_frame, ' ', sizeof(lcd_frame));
+    lcd_frame_shift = 0;
+    lcd_glass_valid = true;
+    lcd_cursor_addr = 0;
+    lcd_unlock();
 }
 
 // Set cursor position
@@ -196,13 +348,253 @@ static void lcd_set_cursor(uint8_t col, uint8_t row)
     if (row >= DISPLAY_ROWS) row = 0;
     if (col >= DISPLAY_COLS) col = 0;
     lcd_command(LCD_CMD_DDRAM_ADDR | (col + row_offsets[row]));
+    lcd_cursor_addr = col + row_offsets[row];
+}
+
+// ============================================================================
+// SHADOW FRAMEBUFFER
+// ============================================================================
+
+// Blank the pending frame, keeping whatever display shift is in effect
+static void frame_clear(void)
+{
+    memset(lcd_frame, ' ', sizeof(lcd_frame));
+    memset(lcd_frame_full, 0, sizeof(lcd_frame_full));
+    lcd_frame_shift = lcd_glass_shift;
 }
 
-// Print string
-static void lcd_print(const char *str)
+// DDRAM column shown at visible column col under the pending shift
+static uint8_t frame_ddram_col(uint8_t col)
 {
-    while (*str) {
-        lcd_data((uint8_t)*str++);
+    return (uint8_t)((col + lcd_frame_shift) % LCD_DDRAM_COLS);
+}
+
+// Write text into the pending frame at col/row, clipped to the line
+static void frame_put(uint8_t col, uint8_t row, const char *text)
+{
+    if (row >= DISPLAY_ROWS || !text) return;
+    while (*text && col < DISPLAY_COLS) {
+        lcd_frame[row][frame_ddram_col(col++)] = *text++;
+    }
+}
+
+// Replace a whole line of the pending frame, padding with spaces
+static void frame_set_line(uint8_t row, const char *text)
+{
+    if (row >= DISPLAY_ROWS) return;
+    for (uint8_t col = 0; col < DISPLAY_COLS; col++) {
+        lcd_frame[row][frame_ddram_col(col)] = ' ';
+    }
+    frame_put(0, row, text);
+}
+
+// Is this DDRAM cell part of what the next flush has to get right?
+static bool frame_cell_wanted(uint8_t row, uint8_t ddram_col)
+{
+    if (lcd_frame_full[row]) return true;
+    return (uint8_t)((ddram_col + LCD_DDRAM_COLS - lcd_frame_shift) % LCD_DDRAM_COLS) < DISPLAY_COLS;
+}
+
+// ============================================================================
+// CGRAM GLYPH CACHE
+// ============================================================================
+
+// Frame bytes >= 0x80 are glyph tokens: 0x80-0x9F are icons (LCD_GLYPH_*),
+// 0xA0-0xFF are Latin-1 letters the transliterator kept because they have a
+// bitmap here. At flush time each token is mapped to one of the 8 CGRAM
+// slots, least recently used first. Slots are addressed as 0x08-0x0F (the
+// HD44780 mirrors 0x00-0x07 there) so a NUL never lands in the framebuffer.
+#define LCD_GLYPH_TOKEN_FIRST   0x80
+#define LCD_CGRAM_SLOTS         8
+#define LCD_CGRAM_CODE(slot)    (0x08 + (slot))
+
+// 5x8 bitmaps, top row first; an all-zero entry means "no custom glyph"
+static const uint8_t lcd_glyph_bitmaps[256 - LCD_GLYPH_TOKEN_FIRST][8] = {
+    // Icons
+    [0x80 - 0x80] = { 0x10, 0x18, 0x1C, 0x1E, 0x1C, 0x18, 0x10, 0x00 },  // Play
+    [0x81 - 0x80] = { 0x1B, 0x1B, 0x1B, 0x1B, 0x1B, 0x1B, 0x1B, 0x00 },  // Pause
+    [0x82 - 0x80] = { 0x00, 0x01, 0x01, 0x05, 0x05, 0x15, 0x15, 0x00 },  // Signal
+    [0x83 - 0x80] = { 0x0E, 0x1B, 0x11, 0x11, 0x1F, 0x1F, 0x1F, 0x00 },  // Battery
+    [0x84 - 0x80] = { 0x06, 0x15, 0x0E, 0x04, 0x0E, 0x15, 0x06, 0x00 },  // Bluetooth
+    [0x85 - 0x80] = { 0x02, 0x03, 0x02, 0x02, 0x0E, 0x1E, 0x0C, 0x00 },  // Note
+    // German / Dutch / French letters
+    [0xC4 - 0x80] = { 0x0A, 0x00, 0x0E, 0x11, 0x1F, 0x11, 0x11, 0x00 },  // Ä
+    [0xC9 - 0x80] = { 0x02, 0x04, 0x1F, 0x10, 0x1E, 0x10, 0x1F, 0x00 },  // É
+    [0xD6 - 0x80] = { 0x0A, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 },  // Ö
+    [0xDC - 0x80] = { 0x0A, 0x00, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00 },  // Ü
+    [0xDF - 0x80] = { 0x0E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E, 0x10 },  // ß
+    [0xE0 - 0x80] = { 0x08, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00 },  // à
+    [0xE1 - 0x80] = { 0x02, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00 },  // á
+    [0xE4 - 0x80] = { 0x0A, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00 },  // ä
+    [0xE7 - 0x80] = { 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x04, 0x08 },  // ç
+    [0xE8 - 0x80] = { 0x08, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 },  // è
+    [0xE9 - 0x80] = { 0x02, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 },  // é
+    [0xEA - 0x80] = { 0x04, 0x0A, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 },  // ê
+    [0xEB - 0x80] = { 0x0A, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 },  // ë
+    [0xEF - 0x80] = { 0x0A, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00 },  // ï
+    [0xF1 - 0x80] = { 0x0D, 0x16, 0x00, 0x16, 0x19, 0x11, 0x11, 0x00 },  // ñ
+    [0xF3 - 0x80] = { 0x02, 0x04, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 },  // ó
+    [0xF6 - 0x80] = { 0x0A, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 },  // ö
+    [0xFC - 0x80] = { 0x0A, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00 },  // ü
+};
+
+// ASCII stand-ins for icons when all CGRAM slots are taken
+static const char lcd_icon_fallback[] = { '>', '"', '|', '#', 'B', 'd' };
+
+typedef struct {
+    uint8_t token;          // 0 = empty
+    uint32_t last_used;     // Flush counter at last use, for LRU
+} cgram_slot_t;
+
+static cgram_slot_t lcd_cgram[LCD_CGRAM_SLOTS];
+static uint32_t lcd_cgram_clock = 0;
+
+static bool lcd_glyph_has_bitmap(uint8_t token)
+{
+    if (token < LCD_GLYPH_TOKEN_FIRST) return false;
+    const uint8_t *rows = lcd_glyph_bitmaps[token - LCD_GLYPH_TOKEN_FIRST];
+    for (int i = 0; i < 8; i++) {
+        if (rows[i]) return true;
+    }
+    return false;
+}
+
+static char cgram_fallback(uint8_t token)
+{
+    if (token < 0xA0) {
+        size_t idx = token - LCD_GLYPH_TOKEN_FIRST;
+        return idx < sizeof(lcd_icon_fallback) ? lcd_icon_fallback[idx] : '?';
+    }
+    char glyph[3];
+    return lcd_glyph_for(token, glyph) ? glyph[0] : '?';
+}
+
+// Find a resident token, or load it into the least recently used slot that
+// the frame being resolved does not already use. Returns -1 if none is free.
+static int cgram_acquire(uint8_t token, uint8_t pinned)
+{
+    int victim = -1;
+    for (int i = 0; i < LCD_CGRAM_SLOTS; i++) {
+        if (lcd_cgram[i].token == token) return i;
+        if (pinned & (1 << i)) continue;
+        if (victim < 0 || (lcd_cgram[victim].token != 0 &&
+                           (lcd_cgram[i].token == 0 ||
+                            lcd_cgram[i].last_used < lcd_cgram[victim].last_used))) {
+            victim = i;
+        }
+    }
+    if (victim < 0 || !lcd_glyph_has_bitmap(token)) return -1;
+
+    // Queued with the rest of the flush; the cursor is now in CGRAM
+    const uint8_t *rows = lcd_glyph_bitmaps[token - LCD_GLYPH_TOKEN_FIRST];
+    lcd_command(LCD_CMD_CGRAM_ADDR | (victim << 3));
+    for (int i = 0; i < 8; i++) {
+        lcd_data(rows[i]);
+    }
+    lcd_cursor_addr = LCD_CURSOR_UNKNOWN;
+    lcd_cgram[victim].token = token;
+    return victim;
+}
+
+// Translate the wanted cells of the pending frame into HD44780 character
+// codes; cells nobody asked for keep what the glass already shows
+static void cgram_resolve(char out[DISPLAY_ROWS][LCD_DDRAM_COLS])
+{
+    uint8_t pinned = 0;
+    lcd_cgram_clock++;
+
+    for (uint8_t row = 0; row < DISPLAY_ROWS; row++) {
+        for (uint8_t col = 0; col < LCD_DDRAM_COLS; col++) {
+            if (!frame_cell_wanted(row, col)) {
+                out[row][col] = lcd_glass_valid ? lcd_glass[row][col] : ' ';
+                continue;
+            }
+            uint8_t c = (uint8_t)lcd_frame[row][col];
+            if (c < LCD_GLYPH_TOKEN_FIRST) {
+                out[row][col] = (char)c;
+                continue;
+            }
+            int slot = cgram_acquire(c, pinned);
+            if (slot < 0) {
+                out[row][col] = cgram_fallback(c);
+                continue;
+            }
+            pinned |= 1 << slot;
+            lcd_cgram[slot].last_used = lcd_cgram_clock;
+            out[row][col] = LCD_CGRAM_CODE(slot);
+        }
+    }
+}
+
+// Move the hardware window to lcd_frame_shift, one command byte per column
+static void frame_apply_shift(void)
+{
+    uint8_t left = (uint8_t)((lcd_frame_shift + LCD_DDRAM_COLS - lcd_glass_shift) % LCD_DDRAM_COLS);
+    uint8_t right = (uint8_t)((LCD_DDRAM_COLS - left) % LCD_DDRAM_COLS);
+
+    if (left <= right) {
+        while (left--) lcd_command(LCD_CMD_SHIFT | LCD_SHIFT_DISPLAY);
+    } else {
+        while (right--) lcd_command(LCD_CMD_SHIFT | LCD_SHIFT_DISPLAY | LCD_SHIFT_RIGHT);
+    }
+    lcd_glass_shift = lcd_frame_shift;
+}
+
+// Push only the cells that differ from the glass, one run at a time
+static void frame_flush(void)
+{
+    static const uint8_t row_offsets[] = {0x00, 0x40};
+    char out[DISPLAY_ROWS][LCD_DDRAM_COLS];
+    uint32_t sent = lcd_i2c_bytes;
+
+    cgram_resolve(out);
+
+    for (uint8_t row = 0; row < DISPLAY_ROWS; row++) {
+        uint8_t col = 0;
+        while (col < LCD_DDRAM_COLS) {
+            if (lcd_glass_valid && out[row][col] == lcd_glass[row][col]) {
+                col++;
+                continue;
+            }
+
+            // Extend the run; a single clean cell between two dirty ones is
+            // cheaper to rewrite than to skip with another cursor move.
+            uint8_t start = col;
+            uint8_t end = col + 1;
+            while (end < LCD_DDRAM_COLS) {
+                if (!lcd_glass_valid || out[row][end] != lcd_glass[row][end]) {
+                    end++;
+                } else if (end + 1 < LCD_DDRAM_COLS &&
+                           out[row][end + 1] != lcd_glass[row][end + 1]) {
+                    end += 2;
+                } else {
+                    break;
+                }
+            }
+
+            uint8_t addr = row_offsets[row] + start;
+            if (lcd_cursor_addr != addr) {
+                lcd_command(LCD_CMD_DDRAM_ADDR | addr);
+            }
+            for (uint8_t i = start; i < end; i++) {
+                lcd_data((uint8_t)out[row][i]);
+                lcd_glass[row][i] = out[row][i];
+            }
+            lcd_cursor_addr = row_offsets[row] + end;
+            col = end;
+        }
+    }
+
+    // Shift last so the new window is already filled when it comes into view
+    frame_apply_shift();
+    lcd_glass_valid = true;
+    lcd_flush();
+    if (lcd_i2c_bytes != sent) {
+        uint32_t bytes = lcd_i2c_bytes - sent;
+        lcd_redraws++;
+        lcd_redraw_last = bytes > UINT16_MAX ? UINT16_MAX : (uint16_t)bytes;
+        if (lcd_redraw_last > lcd_redraw_max) lcd_redraw_max = lcd_redraw_last;
+        trace_display_flushed();
     }
 }
 
@@ -212,100 +604,109 @@ void display_show_splash(void)
     if (!display_initialized) return;
     
     ESP_LOGI(TAG, "Displaying splash screen...");
-    display_clear();
-    
-    lcd_set_cursor(1, 0);
-    lcd_print("Car Stereo");
-    
-    lcd_set_cursor(0, 1);
-    lcd_print("ESP32 Audio");
-    
-    vTaskDelay(pdMS_TO_TICKS(3000));
-    display_clear();
+    lcd_lock();
+    frame_clear();
+    frame_put(1, 0, "Car Stereo");
+    frame_put(0, 1, "ESP32 Audio");
+    frame_flush();
+    splash_until = xTaskGetTickCount() + pdMS_TO_TICKS(DISPLAY_SPLASH_MS);
+    splash_up = true;
+    lcd_unlock();
 }
 
-// Update display
-void display_update(const display_state_t *state)
+// Compose a display state into the pending frame (caller holds lcd_mutex)
+static void compose_state(const display_state_t *state)
 {
-    if (!display_initialized || !state) return;
-    
-    display_clear();
-    
     // Line 1
-    lcd_set_cursor(0, 0);
     if (strlen(state->line1) > 0) {
-        char line[17];
-        strncpy(line, state->line1, 16);
-        line[16] = '\0';
-        lcd_print(line);
+        frame_set_line(0, state->line1);
     } else {
         switch(state->mode) {
             case DISPLAY_MODE_RADIO:
-                lcd_print("FM Radio");
+                frame_set_line(0, "FM Radio");
                 break;
             case DISPLAY_MODE_BLUETOOTH:
-                lcd_print(state->connected ? "BT: Connected" : "BT: Waiting");
+                frame_set_line(0, state->connected ? "BT: Connected" : "BT: Waiting");
                 break;
             case DISPLAY_MODE_PHONE_CALL:
-                lcd_print("CALL");
+                frame_set_line(0, "CALL");
                 break;
             case DISPLAY_MODE_OFF:
-                lcd_print("System OFF");
+                frame_set_line(0, "System OFF");
                 break;
             default:
+                frame_set_line(0, "");
                 break;
         }
     }
     
     // Line 2
-    lcd_set_cursor(0, 1);
     if (strlen(state->line2) > 0) {
-        char line[17];
-        strncpy(line, state->line2, 16);
-        line[16] = '\0';
-        lcd_print(line);
+        frame_set_line(1, state->line2);
     } else {
         char status[17];
         snprintf(status, sizeof(status), "Vol:%02d %s", 
                 state->volume, 
-                state->playing ? ">" : " ");
-        lcd_print(status);
+                state->playing ? LCD_GLYPH_PLAY : LCD_GLYPH_PAUSE);
+        frame_set_line(1, status);
     }
 }
 
+// Compose and flush a display state (caller holds lcd_mutex)
+static void render_state(const display_state_t *state)
+{
+    frame_clear();
+    compose_state(state);
+    frame_flush();
+}
+
+// Update display
+void display_update(const display_state_t *state)
+{
+    if (!display_initialized || !state) return;
+    
+    lcd_lock();
+    render_state(state);
+    lcd_unlock();
+}
+
 // Show notification
 void display_notification(const char *line1, const char *line2, uint16_t duration_ms)
 {
-    if (!display_initialized) return;
-    
-    display_clear();
-    
-    if (line1) {
-        lcd_set_cursor(0, 0);
-        char line[17];
-        strncpy(line, line1, 16);
-        line[16] = '\0';
-        lcd_print(line);
-    }
-    
-    if (line2) {
-        lcd_set_cursor(0, 1);
-        char line[17];
-        strncpy(line, line2, 16);
-        line[16] = '\0';
-        lcd_print(line);
-    }
-    
-    if (duration_ms > 0) {
-        vTaskDelay(pdMS_TO_TICKS(duration_ms));
-    }
+    display_notification_t notification = {
+        .type = DISPLAY_MODE_CHANGE,
+        .duration_ms = duration_ms,
+        .priority = 100
+    };
+    if (line1) strncpy(notification.text, line1, sizeof(notification.text) - 1);
+    if (line2) strncpy(notification.subtext, line2, sizeof(notification.subtext) - 1);
+    display_handle_notification(notification);
 }
 
 // Backlight control
 void display_set_backlight(bool on)
 {
+    if (!lcd_mutex) {
+        backlight_state = on ? LCD_BIT_BL : 0;
+        return;
+    }
+    lcd_lock();
     backlight_state = on ? LCD_BIT_BL : 0;
-    pcf8574_write(backlight_state);
+    lcd_tx_buf[lcd_tx_len++] = backlight_state;
+    lcd_flush();
+    lcd_unlock();
+}
+
+void display_get_stats(display_stats_t *stats)
+{
+    if (lcd_mutex) lcd_lock();
+    stats->i2c_bytes = lcd_i2c_bytes;
+    stats->redraws = lcd_redraws;
+    stats->redraw_bytes_last = lcd_redraw_last;
+    stats->redraw_bytes_max = lcd_redraw_max;
+    if (lcd_mutex) lcd_unlock();
+    stats->queue_depth_max = display_queue_max;
+    stats->queue_dropped = display_queue_dropped;
 }
 
 
@@ -314,6 +715,7 @@ void display_set_backlight(bool on)
 void display_test_simple(void)
 {
     ESP_LOGI(TAG, "=== SIMPLE DISPLAY TEST ===");
+    lcd_lock();
     
     // Test 1: Clear and write 'A'
     ESP_LOGI(TAG, "Test 1: Clear display");
@@ -323,6 +725,7 @@ void display_test_simple(void)
     ESP_LOGI(TAG, "Test 2: Write 'A' to position 0,0");
     lcd_set_cursor(0, 0);
     lcd_data('A');
+    lcd_flush();
     vTaskDelay(pdMS_TO_TICKS(2000));
     
     ESP_LOGI(TAG, "Test 3: Write 'HELLO'");
@@ -332,6 +735,7 @@ void display_test_simple(void)
     lcd_data('L');
     lcd_data('L');
     lcd_data('O');
+    lcd_flush();
     vTaskDelay(pdMS_TO_TICKS(2000));
     
     ESP_LOGI(TAG, "Test 4: Full screen test");
@@ -352,18 +756,104 @@ void display_test_simple(void)
     for (char c = 'a'; c <= 'p'; c++) {
         lcd_data(c);
     }
+    lcd_flush();
     
     vTaskDelay(pdMS_TO_TICKS(5000));
+    lcd_glass_invalidate();
+    lcd_unlock();
     
     ESP_LOGI(TAG, "=== TEST COMPLETE ===");
     ESP_LOGI(TAG, "Did you see any characters on the display?");
 }
 
-// Handler for state machine display notifications
-void display_handle_notification(display_notification_t notification)
+// ============================================================================
+// MARQUEE
+// ============================================================================
+
+// Line 1 text wider than the glass scrolls. Up to LCD_DDRAM_COLS minus a
+// gap it is written to DDRAM once and scrolled with LCD_CMD_SHIFT, one
+// command byte per step; line 2 is re-placed under the moving window by the
+// normal diff, so it looks static. Longer text is scrolled in software
+// through the framebuffer diff instead.
+#define MARQUEE_GAP             4       // Blank columns between repeats
+#define MARQUEE_HW_MAX_LEN      (LCD_DDRAM_COLS - MARQUEE_GAP)
+#define MARQUEE_STEP_MS         350
+#define MARQUEE_HOLD_MS         2000    // Pause with the start of the text shown
+
+typedef struct {
+    char text[sizeof(((display_notification_t *)0)->text)];
+    uint16_t len;
+    uint16_t offset;        // Columns scrolled in the current loop
+    TickType_t next_step;
+    bool active;
+} marquee_t;
+
+static marquee_t lcd_marquee;
+
+// Start scrolling text on line 1, or keep going if it is already scrolling;
+// returns false if the text fits and no marquee is needed
+static bool marquee_prepare(const char *text)
 {
-    if (!display_initialized) return;
-    
+    size_t len = strlen(text);
+    if (len <= DISPLAY_COLS) {
+        lcd_marquee.active = false;
+        return false;
+    }
+
+    if (!lcd_marquee.active || strcmp(lcd_marquee.text, text) != 0) {
+        strncpy(lcd_marquee.text, text, sizeof(lcd_marquee.text) - 1);
+        lcd_marquee.text[sizeof(lcd_marquee.text) - 1] = '\0';
+        lcd_marquee.len = (uint16_t)strlen(lcd_marquee.text);
+        lcd_marquee.offset = 0;
+        lcd_marquee.next_step = xTaskGetTickCount() + pdMS_TO_TICKS(MARQUEE_HOLD_MS);
+        lcd_marquee.active = true;
+    }
+
+    // The hardware window must be positioned before line 2 is composed
+    if (lcd_marquee.len <= MARQUEE_HW_MAX_LEN) {
+        lcd_frame_shift = (uint8_t)(lcd_marquee.offset % LCD_DDRAM_COLS);
+    }
+    return true;
+}
+
+// Fill line 1 of the pending frame for the current scroll position
+static void marquee_compose(void)
+{
+    if (lcd_marquee.len <= MARQUEE_HW_MAX_LEN) {
+        // The whole 40-column line is the tape; DDRAM already holds it
+        // after the first frame, so steps cost no data bytes
+        memset(lcd_frame[0], ' ', LCD_DDRAM_COLS);
+        memcpy(lcd_frame[0], lcd_marquee.text, lcd_marquee.len);
+        lcd_frame_full[0] = true;
+        return;
+    }
+
+    uint16_t period = lcd_marquee.len + MARQUEE_GAP;
+    for (uint8_t col = 0; col < DISPLAY_COLS; col++) {
+        uint16_t pos = (lcd_marquee.offset + col) % period;
+        lcd_frame[0][frame_ddram_col(col)] = pos < lcd_marquee.len ? lcd_marquee.text[pos] : ' ';
+    }
+}
+
+// Advance one column if the step is due; returns true if a redraw is needed
+static bool marquee_tick(TickType_t now)
+{
+    if (!lcd_marquee.active || !tick_reached(now, lcd_marquee.next_step)) {
+        return false;
+    }
+
+    uint16_t period = lcd_marquee.len <= MARQUEE_HW_MAX_LEN ?
+                      LCD_DDRAM_COLS : lcd_marquee.len + MARQUEE_GAP;
+    lcd_marquee.offset = (lcd_marquee.offset + 1) % period;
+    lcd_marquee.next_step = now + pdMS_TO_TICKS(lcd_marquee.offset == 0 ?
+                                                MARQUEE_HOLD_MS : MARQUEE_STEP_MS);
+    return true;
+}
+
+// Render a notification for the current mode (display task, holds lcd_mutex)
+static void render_notification(const display_notification_t *notif)
+{
+    display_notification_t notification = *notif;
     display_state_t state = {0};
     
     // Get current mode
@@ -372,9 +862,10 @@ void display_handle_notification(display_notification_t notification)
     switch(current_mode) {
         case MODE_OFF:
             state.mode = DISPLAY_MODE_OFF;
-            display_clear();
-            lcd_set_cursor(3, 0);
-            lcd_print("System OFF");
+            lcd_marquee.active = false;
+            frame_clear();
+            frame_put(3, 0, "System OFF");
+            frame_flush();
             return;
             
         case MODE_RADIO:
@@ -450,143 +941,335 @@ void display_handle_notification(display_notification_t notification)
             return;
     }
     
-    display_update(&state);
+    frame_clear();
+    bool scrolling = marquee_prepare(notification.text);
+    compose_state(&state);
+    if (scrolling) {
+        marquee_compose();
+    }
+    frame_flush();
 }
 
+// ============================================================================
+// NOTIFICATION SCHEDULER
+// ============================================================================
+
+// A permanent (0 ms) notification becomes the mode's base screen; a timed
+// one is an overlay on top of it. A lower-priority timed notification that
+// arrives while the overlay is up waits in the deferred slot.
+typedef struct {
+    display_notification_t notif;
+    TickType_t expires_at;
+    bool valid;
+} sched_slot_t;
 
-// PASS 1: Strip known Spotify/streaming patterns (bullet + trailing text)
-static void strip_known_patterns(char *str)
+static sched_slot_t sched_base;
+static sched_slot_t sched_overlay;
+static sched_slot_t sched_deferred;
+static stereo_mode_t sched_base_mode = MODE_OFF;
+
+static bool tick_reached(TickType_t now, TickType_t deadline)
 {
-    if (!str) return;
+    return (int32_t)(now - deadline) >= 0;
+}
 
-    // Look for UTF-8 bullet (E2 80 A2) and remove it + everything after
-    char *bullet_pos = strstr(str, "\xE2\x80\xA2");  // UTF-8 bullet
-    if (bullet_pos) {
-        *bullet_pos = '\0';  // Truncate at bullet
+static void sched_fill(sched_slot_t *slot, const display_notification_t *n, TickType_t now)
+{
+    slot->notif = *n;
+    slot->expires_at = now + pdMS_TO_TICKS(n->duration_ms);
+    slot->valid = true;
+}
+
+static const sched_slot_t *sched_active(void)
+{
+    if (sched_overlay.valid) return &sched_overlay;
+    if (sched_base.valid) return &sched_base;
+    return NULL;
+}
+
+// Apply one incoming notification; returns true if the visible screen changed
+static bool sched_submit(const display_notification_t *n, TickType_t now)
+{
+    const sched_slot_t *active = sched_active();
+    bool timed = n->duration_ms > 0;
+
+    // Same type always supersedes (coalescing volume spins etc.); otherwise
+    // lower priority than what is showing never preempts it.
+    if (active && n->type != active->notif.type && n->priority < active->notif.priority) {
+        if (timed) {
+            if (!sched_deferred.valid || n->type == sched_deferred.notif.type ||
+                n->priority >= sched_deferred.notif.priority) {
+                sched_fill(&sched_deferred, n, now);
+            }
+        } else if (active == &sched_overlay &&
+                   (!sched_base.valid || n->type == sched_base.notif.type ||
+                    n->priority >= sched_base.notif.priority)) {
+            // Only the overlay is in the way: it becomes the fallback
+            sched_fill(&sched_base, n, now);
+            sched_base_mode = stereo_state_get_mode();
+        }
+        return false;
+    }
+
+    if (timed) {
+        sched_fill(&sched_overlay, n, now);
+        if (sched_base.valid && sched_base.notif.type == n->type) {
+            sched_base.valid = false;
+        }
+    } else {
+        sched_fill(&sched_base, n, now);
+        sched_base_mode = stereo_state_get_mode();
+        sched_overlay.valid = false;
+    }
+    if (sched_deferred.valid && sched_deferred.notif.type == n->type) {
+        sched_deferred.valid = false;
+    }
+    return true;
+}
+
+// Retire an expired overlay; returns true if the visible screen changed
+static bool sched_expire(TickType_t now)
+{
+    if (sched_deferred.valid && tick_reached(now, sched_deferred.expires_at)) {
+        sched_deferred.valid = false;
+    }
+    if (!sched_overlay.valid || !tick_reached(now, sched_overlay.expires_at)) {
+        return false;
     }
 
-    // Also strip ASCII patterns like " ? " just in case
-    char *pos = strstr(str, " ? ");
-    if (pos) {
-        *pos = '\0';
+    sched_overlay.valid = false;
+    if (sched_deferred.valid) {
+        sched_overlay = sched_deferred;
+        sched_deferred.valid = false;
     }
+    return true;
+}
 
-    // Trim trailing spaces
-    size_t len = strlen(str);
-    while (len > 0 && (str[len - 1] == ' ' || str[len - 1] == '\t')) {
-        str[--len] = '\0';
+// Ticks until the next overlay expiry or marquee step, or portMAX_DELAY
+static TickType_t sched_next_wait(TickType_t now)
+{
+    TickType_t wait = portMAX_DELAY;
+    if (sched_overlay.valid) {
+        wait = tick_reached(now, sched_overlay.expires_at) ? 0 : sched_overlay.expires_at - now;
     }
+    if (lcd_marquee.active) {
+        TickType_t step = tick_reached(now, lcd_marquee.next_step) ? 0 : lcd_marquee.next_step - now;
+        if (step < wait) wait = step;
+    }
+    return wait;
 }
 
-// PASS 2: Convert remaining UTF-8 sequences to ASCII
-static void convert_utf8_to_ascii(char *str)
+// Draw whatever the scheduler says is on top (display task, holds lcd_mutex)
+static void sched_render(void)
 {
-    if (!str) return;
+    // A base screen belongs to the mode it was raised in
+    if (sched_base.valid && sched_base_mode != stereo_state_get_mode()) {
+        sched_base.valid = false;
+    }
 
-    char temp[256];
-    size_t dst = 0, src = 0;
-    size_t len = strlen(str);
+    const sched_slot_t *active = sched_active();
+    if (active) {
+        render_notification(&active->notif);
+    } else {
+        display_notification_t idle = {0};
+        render_notification(&idle);
+    }
+}
 
-    while (src < len && dst < sizeof(temp) - 1) {
-        unsigned char c = (unsigned char)str[src];
+// Display task: sole consumer of display_queue, owns notification expiry
+static void display_task(void *arg)
+{
+    display_notification_t notification;
+    TickType_t last_render = xTaskGetTickCount() - pdMS_TO_TICKS(DISPLAY_FRAME_MS);
 
-        // ASCII printable - keep as-is
-        if (c >= 0x20 && c <= 0x7E) {
-            temp[dst++] = str[src++];
+    while (1) {
+        bool dirty = false;
+        TickType_t now = xTaskGetTickCount();
+
+        TickType_t wait = sched_next_wait(now);
+        if (splash_up) {
+            TickType_t left = tick_reached(now, splash_until) ? 0 : splash_until - now;
+            if (left < wait) wait = left;
         }
-        // UTF-8 3-byte (E2 80 xx - dashes, quotes, etc.)
-        else if (c == 0xE2 && src + 2 < len) {
-            unsigned char b2 = (unsigned char)str[src + 1];
-            unsigned char b3 = (unsigned char)str[src + 2];
-            
-            if (b2 == 0x80) {
-                if (b3 >= 0x90 && b3 <= 0x95) temp[dst++] = '-';
-                else if (b3 == 0x98 || b3 == 0x99) temp[dst++] = '\'';
-                else if (b3 == 0x9C || b3 == 0x9D) temp[dst++] = '"';
-                else if (b3 == 0xA2) temp[dst++] = '*';
-                else temp[dst++] = '?';
-            } else {
-                temp[dst++] = '?';
+
+        if (xQueueReceive(display_queue, &notification, wait) == pdTRUE) {
+            dirty |= sched_submit(&notification, xTaskGetTickCount());
+
+            // Hold the frame until DISPLAY_FRAME_MS after the last render and
+            // fold everything that arrives meanwhile into a single redraw.
+            TickType_t frame_end = last_render + pdMS_TO_TICKS(DISPLAY_FRAME_MS);
+            while (1) {
+                now = xTaskGetTickCount();
+                TickType_t wait = tick_reached(now, frame_end) ? 0 : frame_end - now;
+                if (xQueueReceive(display_queue, &notification, wait) != pdTRUE) break;
+                dirty |= sched_submit(&notification, xTaskGetTickCount());
             }
-            src += 3;
         }
-        // UTF-8 2-byte (C3 xx - accented chars)
-        else if (c == 0xC3 && src + 1 < len) {
-            unsigned char next = (unsigned char)str[src + 1];
-            if (next >= 0x80 && next <= 0xBF) {
-                temp[dst++] = 'a' + ((next - 0x80) % 32);
-            }
-            src += 2;
+
+        now = xTaskGetTickCount();
+        dirty |= sched_expire(now);
+        dirty |= marquee_tick(now);
+
+        // Notifications keep being scheduled under the splash; the screen
+        // they leave behind is drawn once it times out.
+        if (splash_up) {
+            if (!tick_reached(now, splash_until)) continue;
+            splash_up = false;
+            dirty = true;
         }
-        // Skip other non-ASCII
-        else {
-            src++;
+
+        if (dirty) {
+            lcd_lock();
+            sched_render();
+            lcd_unlock();
+            last_render = now;
         }
     }
-
-    temp[dst] = '\0';
-    strcpy(str, temp);
 }
 
-// PASS 3: Scan backward and truncate at first non-ASCII
-static void truncate_trailing_garbage(char *str)
+// Handler for state machine display notifications: non-blocking enqueue
+void display_handle_notification(display_notification_t notification)
 {
-    if (!str) return;
-
-    size_t len = strlen(str);
+    if (!display_queue) return;
     
-    while (len > 0) {
-        unsigned char c = (unsigned char)str[len - 1];
-        
-        // Valid ASCII printable = keep
-        if (c >= 0x20 && c <= 0x7E) {
-            break;
-        }
-        
-        // Garbage = truncate
-        str[--len] = '\0';
+    if (xQueueSend(display_queue, &notification, 0) != pdTRUE) {
+        display_queue_dropped++;
+        DLOGW(TAG, "Display queue full, dropping notification type %d", notification.type);
+        return;
     }
+    UBaseType_t depth = uxQueueMessagesWaiting(display_queue);
+    if (depth > display_queue_max) display_queue_max = (uint8_t)depth;
+}
+
+
+// ============================================================================
+// UTF-8 -> LCD TRANSLITERATION
+// ============================================================================
+
+// The HD44780 ROM only has ASCII in common across variants, so everything
+// else is folded to its closest ASCII spelling. One entry per codepoint; an
+// empty entry drops the character. Expansions never exceed the UTF-8 length
+// of the source character, which is what makes in-place conversion safe.
+#define LCD_LATIN_LUT_FIRST 0x00A0  // Latin-1 Supplement (after C1 controls)
+#define LCD_LATIN_LUT_LAST  0x017F  // ... through Latin Extended-A
+#define LCD_PUNCT_LUT_FIRST 0x2010  // General Punctuation: dashes, quotes,
+#define LCD_PUNCT_LUT_LAST  0x203F  // ... bullets, ellipsis, primes
+#define LCD_CP_BULLET       0x2022
+
+static const char lcd_latin_lut[LCD_LATIN_LUT_LAST - LCD_LATIN_LUT_FIRST + 1][2] = {
+    /* U+00A0 */ " ", "!", "c", "L", "", "Y", "|", "S", "\"", "C", "a", "<<", "-", "", "R", "-",
+    /* U+00B0 */ "o", "+-", "2", "3", "'", "u", "P", ".", ",", "1", "o", ">>", "", "", "", "?",
+    /* U+00C0 */ "A", "A", "A", "A", "A", "A", "AE", "C", "E", "E", "E", "E", "I", "I", "I", "I",
+    /* U+00D0 */ "D", "N", "O", "O", "O", "O", "O", "x", "O", "U", "U", "U", "U", "Y", "Th", "ss",
+    /* U+00E0 */ "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    /* U+00F0 */ "d", "n", "o", "o", "o", "o", "o", "/", "o", "u", "u", "u", "u", "y", "th", "y",
+    /* U+0100 */ "A", "a", "A", "a", "A", "a", "C", "c", "C", "c", "C", "c", "C", "c", "D", "d",
+    /* U+0110 */ "D", "d", "E", "e", "E", "e", "E", "e", "E", "e", "E", "e", "G", "g", "G", "g",
+    /* U+0120 */ "G", "g", "G", "g", "H", "h", "H", "h", "I", "i", "I", "i", "I", "i", "I", "i",
+    /* U+0130 */ "I", "i", "IJ", "ij", "J", "j", "K", "k", "k", "L", "l", "L", "l", "L", "l", "L",
+    /* U+0140 */ "l", "L", "l", "N", "n", "N", "n", "N", "n", "'n", "N", "n", "O", "o", "O", "o",
+    /* U+0150 */ "O", "o", "OE", "oe", "R", "r", "R", "r", "R", "r", "S", "s", "S", "s", "S", "s",
+    /* U+0160 */ "S", "s", "T", "t", "T", "t", "T", "t", "U", "u", "U", "u", "U", "u", "U", "u",
+    /* U+0170 */ "U", "u", "U", "u", "W", "w", "Y", "y", "Y", "Z", "z", "Z", "z", "Z", "z", "s",
+};
+
+static const char lcd_punct_lut[LCD_PUNCT_LUT_LAST - LCD_PUNCT_LUT_FIRST + 1][3] = {
+    /* U+2010 */ "-", "-", "-", "-", "-", "-", "|", "_", "'", "'", "'", "'", "\"", "\"", "\"", "\"",
+    /* U+2020 */ "+", "+", "*", ">", ".", "..", "...", "-", " ", " ", "", "", "", "", "", " ",
+    /* U+2030 */ "%", "%", "'", "\"", "\"", "`", "\"", "", "^", "<", ">", "*", "!!", "?", "-", "_",
+};
+
+// Decode one UTF-8 sequence; malformed input consumes a single byte and
+// yields 0 so it is dropped
+static uint32_t utf8_next(const unsigned char **p)
+{
+    const unsigned char *s = *p;
+    uint32_t cp;
+    int extra;
 
-    // Trim trailing spaces
-    while (len > 0 && (str[len - 1] == ' ' || str[len - 1] == '\t')) {
-        str[--len] = '\0';
+    if (s[0] < 0x80)        { *p = s + 1; return s[0]; }
+    else if ((s[0] & 0xE0) == 0xC0) { cp = s[0] & 0x1F; extra = 1; }
+    else if ((s[0] & 0xF0) == 0xE0) { cp = s[0] & 0x0F; extra = 2; }
+    else if ((s[0] & 0xF8) == 0xF0) { cp = s[0] & 0x07; extra = 3; }
+    else                    { *p = s + 1; return 0; }
+
+    for (int i = 1; i <= extra; i++) {
+        if ((s[i] & 0xC0) != 0x80) {    // Also stops at the terminator
+            *p = s + 1;
+            return 0;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
     }
+    *p = s + 1 + extra;
+    return cp;
 }
 
-// Combined cleanup - Strip patterns FIRST, then convert, then cleanup
-void strip_spotify_junk(char *str)
+// ASCII spelling of a codepoint into glyph[3]; returns its length (0 = drop)
+static size_t lcd_glyph_for(uint32_t cp, char glyph[3])
 {
-    if (!str) return;
-    
-    // Pass 1: FIRST - Strip known Spotify/streaming patterns (bullet + everything after)
-    strip_known_patterns(str);
-    
-    // Pass 2: Convert UTF-8 to ASCII (for any remaining special chars)
-    convert_utf8_to_ascii(str);
-    
-    // Pass 3: Truncate trailing garbage (e.g., invalid bytes)
-    truncate_trailing_garbage(str);
-}
+    if (cp >= 0x20 && cp <= 0x7E) {
+        glyph[0] = (char)cp;
+        return 1;
+    }
 
+    const char *entry;
+    size_t max;
+    if (cp >= LCD_LATIN_LUT_FIRST && cp <= LCD_LATIN_LUT_LAST) {
+        entry = lcd_latin_lut[cp - LCD_LATIN_LUT_FIRST];
+        max = sizeof(lcd_latin_lut[0]);
+    } else if (cp >= LCD_PUNCT_LUT_FIRST && cp <= LCD_PUNCT_LUT_LAST) {
+        entry = lcd_punct_lut[cp - LCD_PUNCT_LUT_FIRST];
+        max = sizeof(lcd_punct_lut[0]);
+    } else {
+        return 0;
+    }
+
+    size_t len = strnlen(entry, max);
+    memcpy(glyph, entry, len);
+    return len;
+}
 
-// Simplified sanitize_for_lcd - just removes leading control chars
+// One streaming pass straight into dest (dest == src is allowed):
+// - leading control characters and undisplayable codepoints are dropped
+// - letters with a CGRAM bitmap stay as their Latin-1 byte (glyph token)
+// - everything else goes through the ASCII tables above
+// - with CONFIG_CAR_STEREO_LCD_STRIP_TRAILER, a bullet or " ? " ends the
+//   text (Spotify appends " • <album / playlist>")
+// - trailing blanks are trimmed
 void sanitize_for_lcd(char *dest, const char *src, size_t max_len)
 {
     if (!src || !dest || max_len < 2) return;
 
-    char temp[256];
-    strncpy(temp, src, sizeof(temp) - 1);
-    temp[sizeof(temp) - 1] = '\0';
+    const unsigned char *p = (const unsigned char *)src;
+    size_t out = 0;
+    size_t keep = 0;        // Length without trailing blanks
+#if CONFIG_CAR_STEREO_LCD_STRIP_TRAILER
+    uint32_t prev = 0;
+#endif
+
+    while (*p && out < max_len - 1) {
+        uint32_t cp = utf8_next(&p);
 
-    // Trim leading control/non-ASCII
-    size_t start = 0;
-    while (temp[start] && (unsigned char)temp[start] < 0x20) start++;
-    memmove(temp, temp + start, strlen(temp + start) + 1);
+#if CONFIG_CAR_STEREO_LCD_STRIP_TRAILER
+        if (cp == LCD_CP_BULLET) break;
+        if (cp == '?' && prev == ' ' && *p == ' ') break;
+        prev = cp;
+#endif
 
-    // Clean with two-pass approach
-    strip_spotify_junk(temp);
+        char glyph[3];
+        size_t len;
+        if (cp >= 0xA0 && cp <= 0xFF && lcd_glyph_has_bitmap((uint8_t)cp)) {
+            glyph[0] = (char)cp;    // Drawn from CGRAM at flush time
+            len = 1;
+        } else {
+            len = lcd_glyph_for(cp, glyph);
+        }
+        if (out + len > max_len - 1) break;
+        for (size_t i = 0; i < len; i++) {
+            dest[out++] = glyph[i];
+            if (glyph[i] != ' ') keep = out;
+        }
+    }
 
-    // Copy to dest (now guaranteed ASCII-clean)
-    strncpy(dest, temp, max_len - 1);
-    dest[max_len - 1] = '\0';
+    dest[keep] = '\0';
 }
@@ -14,9 +14,19 @@
 #define LCD_I2C_PORT    I2C_NUM_0
 #define LCD_I2C_SDA     21
 #define LCD_I2C_SCL     22
-#define LCD_I2C_FREQ    100000  // 100kHz
+#define LCD_I2C_FREQ_STD    100000  // 100kHz standard mode
+#define LCD_I2C_FREQ_FAST   400000  // 400kHz fast mode
+#define LCD_I2C_FREQ    LCD_I2C_FREQ_FAST  // Falls back to standard mode if the backpack NAKs
 #define LCD_I2C_ADDR    0x27    // PCF8574 default address
 
+// Custom glyphs, drawn from CGRAM; embed in any display string
+#define LCD_GLYPH_PLAY      "\x80"
+#define LCD_GLYPH_PAUSE     "\x81"
+#define LCD_GLYPH_SIGNAL    "\x82"
+#define LCD_GLYPH_BATTERY   "\x83"
+#define LCD_GLYPH_BT        "\x84"
+#define LCD_GLYPH_NOTE      "\x85"
+
 // Display mode enumeration
 typedef enum {
     DISPLAY_MODE_OFF,
@@ -54,6 +64,9 @@ void display_update(const display_state_t *state);
 
 /**
  * @brief Show splash screen on boot
+ * 
+ * Called by display_init() and returns immediately; the display task
+ * replaces the splash with the current screen after a few seconds.
  */
 void display_show_splash(void);
 
@@ -65,9 +78,11 @@ void display_clear(void);
 /**
  * @brief Display a notification message
  * 
+ * Queued to the display task; returns immediately.
+ * 
  * @param line1 First line of text (max 16 chars)
  * @param line2 Second line of text (max 16 chars)
- * @param duration_ms Duration to show message in milliseconds
+ * @param duration_ms Duration to show message in milliseconds (0 = permanent)
  */
 void display_notification(const char *line1, const char *line2, uint16_t duration_ms);
 
@@ -78,8 +93,43 @@ void display_notification(const char *line1, const char *line2, uint16_t duratio
  */
 void display_set_backlight(bool on);
 
+/**
+ * @brief Queue a state machine notification for the display task
+ * 
+ * Never blocks; the notification is dropped if the queue is full.
+ * 
+ * @param notification Notification to show
+ */
 void display_handle_notification(display_notification_t notification);
 
+/**
+ * @brief Transliterate UTF-8 text for the LCD
+ * 
+ * Letters with a CGRAM glyph (ä, ö, ü, é, ...) are kept as Latin-1 bytes and
+ * drawn from CGRAM; everything else is folded to ASCII. dest may equal src.
+ */
 void sanitize_for_lcd(char *dest, const char *src, size_t max_len);
 
+/**
+ * @brief Display counters since boot
+ */
+typedef struct {
+    uint32_t i2c_bytes;         // All bytes put on the I2C bus
+    uint32_t redraws;           // Frame flushes that changed the glass
+    uint16_t redraw_bytes_last; // Bus bytes of the last such flush
+    uint16_t redraw_bytes_max;  // Bus bytes of the largest one
+    uint8_t queue_depth_max;    // Most notifications waiting for the display task
+    uint32_t queue_dropped;     // Notifications lost to a full queue
+} display_stats_t;
+
+/**
+ * @brief Snapshot the display counters
+ * 
+ * I2C bytes per redraw is the cost the shadow framebuffer and the batched
+ * transfers exist to keep down; six bus bytes go out per character.
+ * 
+ * @param stats Receives the counters
+ */
+void display_get_stats(display_stats_t *stats);
+
 #endif // DISPLAY_H
@@ -1,18 +1,28 @@
+#include "sdkconfig.h"
 #include "a2dpSinkHfpHf.h"
 #include "car_stereo_state.h"
 #include "buttons.h"
 
 // Add these missing includes:
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_bt.h"
 #include "esp_bt_main.h"
 #include "esp_gap_bt_api.h"
+#include <stdlib.h>
 #include <string.h>
 #include "display.h"
-#include "driver/i2c.h" // for scanning i2c bus. dev.
+#include "power.h"
+#include "audio_dsp.h"
+#include "source.h"
+#include "task_map.h"
+#include "trace.h"
+#include "telemetry.h"
+#include "deferred_log.h"
+#include "driver/i2c_master.h" // for scanning i2c bus. dev.
 // debugging non standard characters
 #include <stdio.h>
 #include <ctype.h>
@@ -28,8 +38,11 @@
 // Forward declarations
 static void button_event_callback(button_event_t event);
 static void mode_change_callback(stereo_mode_t old_mode, stereo_mode_t new_mode);
-static void display_handler(display_notification_t notification);
 
+static TaskHandle_t g_main_task = NULL;
+static esp_err_t g_bt_init_result = ESP_FAIL;
+
+#if CONFIG_CAR_STEREO_METADATA_DEBUG_DUMP
 void debug_dump_ascii_and_hex(const char *label, const char *s)
 {
     printf("%s: \"", label);
@@ -40,6 +53,7 @@ void debug_dump_ascii_and_hex(const char *label, const char *s)
         printf(" %02X", (unsigned char)*p);
     printf("\n");
 }
+#endif
 
 static void bt_connection_callback(bool connected, const uint8_t *remote_bda)
 {
@@ -58,6 +72,26 @@ static void bt_connection_callback(bool connected, const uint8_t *remote_bda)
     }
 }
 
+#if CONFIG_CAR_STEREO_PCM_HOOK
+// Decoded A2DP audio on its way to I2S (BT audio task)
+static void a2dp_pcm_callback(int16_t *pcm, size_t frames)
+{
+#if CONFIG_CAR_STEREO_DSP
+    audio_dsp_process(pcm, frames);
+#endif
+    source_mix(AUDIO_SOURCE_BLUETOOTH, pcm, frames);
+}
+
+#if CONFIG_CAR_STEREO_DSP
+// SBC sample rate from the A2DP codec config event (BT task)
+static void a2dp_audio_cfg_callback(uint32_t sample_rate)
+{
+    ESP_LOGI(TAG, "A2DP codec at %lu Hz", (unsigned long)sample_rate);
+    audio_dsp_set_sample_rate(sample_rate);
+}
+#endif
+#endif
+
 static void a2dp_audio_state_callback(bool streaming)
 {
     ESP_LOGI(TAG, "=== A2DP AUDIO %s ===", streaming ? "STARTED" : "STOPPED");
@@ -99,9 +133,11 @@ static void avrcp_metadata_callback(const bt_avrc_metadata_t *metadata)
 {
     if (!metadata) return;
     
+#if CONFIG_CAR_STEREO_METADATA_DEBUG_DUMP
     debug_dump_ascii_and_hex("ARTIST RAW", metadata->artist);
     debug_dump_ascii_and_hex("TITLE RAW", metadata->title);
     debug_dump_ascii_and_hex("ALBUM RAW", metadata->album);
+#endif
 
     char title_clean[128];
     char artist_clean[64];
@@ -112,12 +148,10 @@ static void avrcp_metadata_callback(const bt_avrc_metadata_t *metadata)
     sanitize_for_lcd(artist_clean, metadata->artist, sizeof(artist_clean));
     sanitize_for_lcd(album_clean, metadata->album, sizeof(album_clean));
     
-    ESP_LOGI(TAG, "=== TRACK CHANGED ===");
-    ESP_LOGI(TAG, "♫ Title:  %s", title_clean);
-    ESP_LOGI(TAG, "♪ Artist: %s", artist_clean);
-    ESP_LOGI(TAG, "⊙ Album:  %s", album_clean);
+    ESP_LOGD(TAG, "AVRCP metadata: \"%s\" / \"%s\" / \"%s\"",
+             title_clean, artist_clean, album_clean);
     
-    // Use the existing public API to update display
+    // Deduplicated and merged by the state machine before it is displayed
     stereo_state_a2dp_metadata(
         title_clean,
         artist_clean,
@@ -151,21 +185,30 @@ static void gap_event_handler(esp_bt_gap_cb_event_t event, esp_bt_gap_cb_param_t
 
 void i2c_scan(void)
 {
+    i2c_master_bus_handle_t bus;
+    if (i2c_master_get_bus_handle(LCD_I2C_PORT, &bus) != ESP_OK) {
+        ESP_LOGW(TAG, "I2C bus not initialized, call display_init() first");
+        return;
+    }
+    
     ESP_LOGI(TAG, "Scanning I2C bus...");
     for (uint8_t addr = 0x08; addr < 0x78; addr++) {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, true);
-        i2c_master_stop(cmd);
-        esp_err_t ret = i2c_master_cmd_begin(I2C_NUM_0, cmd, pdMS_TO_TICKS(50));
-        i2c_cmd_link_delete(cmd);
-        
-        if (ret == ESP_OK) {
+        if (i2c_master_probe(bus, addr, 50) == ESP_OK) {
             ESP_LOGI(TAG, "Found device at address: 0x%02X", addr);
         }
     }
 }
 
+// Bring up the BT controller and stack while the rest of the system starts;
+// the phone can begin reconnecting as soon as this returns.
+static void bt_init_task(void *arg)
+{
+    g_bt_init_result = a2dpSinkHfpHf_init(NULL);
+    ESP_LOGI(TAG, "Bluetooth up after %d ms", (int)(esp_timer_get_time() / 1000));
+    xTaskNotifyGive(g_main_task);
+    vTaskDelete(NULL);
+}
+
 void app_main(void)
 {
     esp_err_t ret;
@@ -181,39 +224,78 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
     
+    // Bluetooth first (it needs NVS for bonding keys), on the protocol core
+    g_main_task = xTaskGetCurrentTaskHandle();
+    if (xTaskCreatePinnedToCore(bt_init_task, "bt_init", TASK_BT_INIT_STACK, NULL,
+                                TASK_BT_INIT_PRIO, NULL, TASK_BT_INIT_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create BT init task");
+        abort();
+    }
+    
     ESP_LOGI(TAG, "Initializing display...");
     ESP_ERROR_CHECK(display_init());
     
+    // Initialize button handler (before the state machine, which may put it
+    // straight into standby when the stereo was left off)
+    ESP_ERROR_CHECK(buttons_init(ADC_BUTTON_PIN, ROTARY_CLK_PIN,
+                                 ROTARY_DT_PIN, ROTARY_SW_PIN,
+                                 button_event_callback));
+    ESP_LOGI(TAG, "Buttons initialized on ADC GPIO%d", ADC_BUTTON_PIN);
+    ESP_LOGI(TAG, "Rotary encoder: CLK=GPIO%d, DT=GPIO%d", ROTARY_CLK_PIN, ROTARY_DT_PIN);
+    ESP_ERROR_CHECK(power_init());
+    
+#if CONFIG_CAR_STEREO_DSP
+    ESP_ERROR_CHECK(audio_dsp_init(44100));     // Until the phone's codec config says otherwise
+#endif
+    
     // Initialize state machine
     stereo_config_t config = {
         .display_handler = display_handle_notification,
-        .on_mode_change = mode_change_callback
+        .on_mode_change = mode_change_callback,
+        .on_standby = power_set_standby,
+#if CONFIG_CAR_STEREO_DSP
+        .on_a2dp_volume = audio_dsp_set_volume,
+#endif
     };
     ESP_ERROR_CHECK(stereo_state_init(&config));
     
-    // Initialize button handler
-    ESP_ERROR_CHECK(buttons_init(ADC_BUTTON_PIN, ROTARY_CLK_PIN,
-                                 ROTARY_DT_PIN, ROTARY_SW_PIN,
-                                 button_event_callback));
-    ESP_LOGI(TAG, "Buttons initialized on ADC GPIO%d", ADC_BUTTON_PIN);
-    ESP_LOGI(TAG, "Rotary encoder: CLK=GPIO%d, DT=GPIO%d", ROTARY_CLK_PIN, ROTARY_DT_PIN);
+    ESP_LOGI(TAG, "UI up after %d ms", (int)(esp_timer_get_time() / 1000));
     
-    // Initialize Bluetooth A2DP/HFP component
-    ESP_ERROR_CHECK(a2dpSinkHfpHf_init(NULL));
+    // Wait for the Bluetooth A2DP/HFP component
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    ESP_ERROR_CHECK(g_bt_init_result);
+    stereo_state_bt_ready();    // Lets BT buttons through and sets up volume control
     
-    // Register connection/audio callbacks
+    // Register connection/audio callbacks; the state machine is up by now
     a2dp_sink_hfp_hf_register_connection_cb(bt_connection_callback);
     a2dp_sink_hfp_hf_register_audio_state_cb(a2dp_audio_state_callback);
     a2dp_sink_hfp_hf_register_call_state_cb(hfp_call_state_callback);
     a2dpSinkHfpHf_register_avrc_metadata_callback(avrcp_metadata_callback);
+#if CONFIG_CAR_STEREO_PCM_HOOK
+    a2dp_sink_hfp_hf_register_pcm_cb(a2dp_pcm_callback);
+#if CONFIG_CAR_STEREO_DSP
+    a2dp_sink_hfp_hf_register_audio_cfg_cb(a2dp_audio_cfg_callback);
+#endif
+#endif
     
     ESP_LOGI(TAG, "========================================");
     ESP_LOGI(TAG, " Car Stereo Ready!");
     ESP_LOGI(TAG, "========================================");
     
-    // Main loop
+    // Main loop: lowest priority, so it prints the deferred log lines and
+    // the health report on otherwise idle time. In standby it only wakes
+    // for the report, to keep light sleep residency up.
+    TickType_t last_report = xTaskGetTickCount();
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(10000));
+        power_stats_t power;
+        power_get_stats(&power);
+        vTaskDelay(pdMS_TO_TICKS(power.standby ? TELEMETRY_PERIOD_MS : DLOG_FLUSH_MS));
+        dlog_flush();
+
+        if (xTaskGetTickCount() - last_report >= pdMS_TO_TICKS(TELEMETRY_PERIOD_MS)) {
+            last_report = xTaskGetTickCount();
+            telemetry_report();
+        }
         // int clk = gpio_get_level(ROTARY_CLK_PIN);
         // int dt  = gpio_get_level(ROTARY_DT_PIN);
         // int sw  = gpio_get_level(ROTARY_SW_PIN);
@@ -234,28 +316,12 @@ static void button_event_callback(button_event_t event)
 }
 
 // Mode change callback
+// Audio routing follows the mode in the state task (source_select); the
+// tuner stays parked on the last station, so this only logs
 static void mode_change_callback(stereo_mode_t old_mode, stereo_mode_t new_mode)
 {
     const char *mode_names[] = {"OFF", "RADIO", "BLUETOOTH", "PHONE_CALL", "PHONEBOOK"};
     
     ESP_LOGI(TAG, "Mode changed: %s -> %s", 
              mode_names[old_mode], mode_names[new_mode]);
-    
-    // Handle mode-specific initialization/cleanup here
-    switch (new_mode) {
-        case MODE_RADIO:
-            // Enable radio tuner, etc.
-            break;
-            
-        case MODE_BLUETOOTH:
-            // Ensure BT audio is ready
-            break;
-            
-        case MODE_PHONE_CALL:
-            // Switch audio routing to call
-            break;
-            
-        default:
-            break;
-    }
 }
@@ -0,0 +1,708 @@
+/*
+ * Phonebook Store
+ * Compact binary contact store built from the PBAP vCard dump and read
+ * through a flash mapping for browsing and caller-ID lookup
+ */
+
+#include "phonebook_store.h"
+#include "task_map.h"
+#include "sdkconfig.h"
+#include "esp_partition.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <sys/stat.h>
+
+#define TAG "PHONEBOOK"
+
+#define PB_MAGIC        0x4B425050      // "PPBK"
+#define PB_VERSION      1
+#define PB_SECTOR_SIZE  4096
+
+#define CALLER_CACHE_SIZE 8         // Recent callers, hits and misses alike
+#define PB_SYNC_POLL_MS   5000      // Dump re-check interval after a phone connects
+#define PB_SYNC_WINDOW_MS (3 * 60 * 1000)   // A large PBAP download is done well within this
+
+typedef struct {
+    uint64_t number;            // phonebook_normalize_number()
+    uint32_t contact;           // Record index in name order
+    uint32_t reserved;
+} pb_number_t;
+
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t reserved[3];
+    uint32_t contact_count;
+    uint32_t number_count;
+    uint32_t source_size;       // vCard dump the store was built from
+    uint32_t source_mtime;
+    uint16_t letter_first[PHONEBOOK_LETTER_OTHER + 1];
+    uint16_t reserved2;
+    uint32_t crc;
+} pb_header_t;
+
+// Partition layout: header sector, records in name order, number index in
+// number order, then the staging areas the builder fills in vCard order
+#define PB_RECORDS_OFFSET       PB_SECTOR_SIZE
+#define PB_NUMBERS_OFFSET       (PB_RECORDS_OFFSET + PHONEBOOK_MAX_CONTACTS * sizeof(phonebook_contact_t))
+#define PB_STAGE_RECORDS_OFFSET (PB_NUMBERS_OFFSET + PHONEBOOK_MAX_NUMBERS * sizeof(pb_number_t))
+#define PB_STAGE_NUMBERS_OFFSET (PB_STAGE_RECORDS_OFFSET + PHONEBOOK_MAX_CONTACTS * sizeof(phonebook_contact_t))
+#define PB_PARTITION_SIZE       (PB_STAGE_NUMBERS_OFFSET + PHONEBOOK_MAX_NUMBERS * sizeof(pb_number_t))
+#define PB_MAPPED_SIZE          PB_STAGE_RECORDS_OFFSET     // Staging is never read mapped
+
+_Static_assert(sizeof(phonebook_contact_t) == 64, "records are addressed by index");
+_Static_assert(sizeof(pb_number_t) == 16, "number entries are addressed by index");
+_Static_assert(PHONEBOOK_MAX_CONTACTS <= UINT16_MAX, "letter table and sort order are 16-bit");
+_Static_assert(PB_STAGE_RECORDS_OFFSET % PB_SECTOR_SIZE == 0, "regions are sector aligned");
+
+static const esp_partition_t *g_partition = NULL;
+static SemaphoreHandle_t g_pb_lock = NULL;
+static esp_partition_mmap_handle_t g_map_handle;
+static const uint8_t *g_map = NULL;         // NULL while there is no valid store
+static pb_header_t g_header;
+static TaskHandle_t g_build_task = NULL;
+static StackType_t g_build_stack[TASK_PB_BUILD_STACK];
+static StaticTask_t g_build_tcb;
+
+typedef struct {
+    uint64_t number;            // 0 = free slot
+    uint32_t last_used;
+    bool found;
+    char name[PHONEBOOK_NAME_LEN];
+} caller_cache_entry_t;
+
+static caller_cache_entry_t g_caller_cache[CALLER_CACHE_SIZE];
+static uint32_t g_caller_clock = 0;
+
+// ============================================================================
+// NUMBERS AND NAMES
+// ============================================================================
+
+uint64_t phonebook_normalize_number(const char *number)
+{
+    if (!number) return 0;
+
+    const char *p = number;
+    while (*p && *p != '+' && !isdigit((unsigned char)*p)) p++;
+    bool international = (*p == '+');
+    if (international) p++;
+
+    // E.164 numbers are at most 15 digits; spaces, dashes, dots and
+    // brackets are formatting, a pause/wait or ';' starts a DTMF suffix
+    char digits[17];
+    size_t n = 0;
+    for (; *p && n < sizeof(digits) - 1; p++) {
+        if (isdigit((unsigned char)*p)) {
+            digits[n++] = *p;
+        } else if (*p == ',' || *p == ';' || *p == 'p' || *p == 'P' ||
+                   *p == 'w' || *p == 'W') {
+            break;
+        }
+    }
+    digits[n] = '\0';
+
+    const char *d = digits;
+    if (!international && d[0] == '0' && d[1] == '0') {
+        international = true;   // International call prefix
+        d += 2;
+    }
+    uint64_t value = 0;
+    if (!international && d[0] == '0') {
+        value = CONFIG_CAR_STEREO_COUNTRY_CODE;     // Trunk prefix: national number
+        d++;
+    }
+    for (; *d; d++) {
+        value = value * 10 + (uint64_t)(*d - '0');
+    }
+    return value;
+}
+
+uint8_t phonebook_letter_class(const char *name)
+{
+    unsigned char c = (unsigned char)name[0];
+    if (isalpha(c) && c < 0x80) {
+        return (uint8_t)(toupper(c) - 'A');
+    }
+    return PHONEBOOK_LETTER_OTHER;
+}
+
+// ============================================================================
+// MAPPING
+// ============================================================================
+
+static uint32_t header_crc(const pb_header_t *hdr)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)hdr, sizeof(*hdr) - sizeof(hdr->crc));
+}
+
+// Called with g_pb_lock held
+static void store_map(void)
+{
+    const void *ptr;
+    esp_err_t err = esp_partition_mmap(g_partition, 0, PB_MAPPED_SIZE,
+                                       ESP_PARTITION_MMAP_DATA, &ptr, &g_map_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Mapping phonebook partition failed: %s", esp_err_to_name(err));
+        return;
+    }
+
+    pb_header_t hdr;
+    memcpy(&hdr, ptr, sizeof(hdr));
+    if (hdr.magic != PB_MAGIC || hdr.version != PB_VERSION || hdr.crc != header_crc(&hdr) ||
+        hdr.contact_count > PHONEBOOK_MAX_CONTACTS || hdr.number_count > PHONEBOOK_MAX_NUMBERS) {
+        ESP_LOGI(TAG, "No valid phonebook store");
+        esp_partition_munmap(g_map_handle);
+        memset(&g_header, 0, sizeof(g_header));
+        return;
+    }
+    g_header = hdr;
+    g_map = ptr;
+    memset(g_caller_cache, 0, sizeof(g_caller_cache));
+    ESP_LOGI(TAG, "Phonebook: %lu contacts, %lu numbers",
+             (unsigned long)hdr.contact_count, (unsigned long)hdr.number_count);
+}
+
+// Called with g_pb_lock held
+static void store_unmap(void)
+{
+    if (g_map) {
+        esp_partition_munmap(g_map_handle);
+        g_map = NULL;
+    }
+    memset(&g_header, 0, sizeof(g_header));
+    memset(g_caller_cache, 0, sizeof(g_caller_cache));
+}
+
+// ============================================================================
+// BUILDER
+// ============================================================================
+
+typedef struct {
+    char line[512];             // Logical property line, unfolded
+    char next[256];             // Physical line read ahead
+    bool have_next;
+    phonebook_contact_t contact;
+    uint64_t numbers[PHONEBOOK_NUMBERS_PER_CONTACT];
+    size_t number_count;
+    bool has_fn;
+    uint32_t contacts;          // Staged so far
+    uint32_t staged_numbers;
+} pb_builder_t;
+
+// Truncates on a UTF-8 character boundary, so a decoded name never ends
+// in half a character
+static void copy_text(char *dst, size_t size, const char *src)
+{
+    size_t len = strlen(src);
+    if (len > size - 1) {
+        len = size - 1;
+        while (len && ((unsigned char)src[len] & 0xC0) == 0x80) len--;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+static esp_err_t stage_contact(pb_builder_t *b)
+{
+    phonebook_contact_t *c = &b->contact;
+    if (c->name[0] == '\0') {
+        if (c->number[0] == '\0') return ESP_OK;
+        copy_text(c->name, sizeof(c->name), c->number);
+    }
+    if (b->contacts >= PHONEBOOK_MAX_CONTACTS) {
+        ESP_LOGW(TAG, "Phonebook full, '%s' dropped", c->name);
+        return ESP_OK;
+    }
+
+    esp_err_t err = esp_partition_write(g_partition,
+                                        PB_STAGE_RECORDS_OFFSET + b->contacts * sizeof(*c),
+                                        c, sizeof(*c));
+    for (size_t i = 0; i < b->number_count && err == ESP_OK; i++) {
+        if (b->staged_numbers >= PHONEBOOK_MAX_NUMBERS) break;
+        pb_number_t entry = { .number = b->numbers[i], .contact = b->contacts };
+        err = esp_partition_write(g_partition,
+                                  PB_STAGE_NUMBERS_OFFSET + b->staged_numbers * sizeof(entry),
+                                  &entry, sizeof(entry));
+        b->staged_numbers++;
+    }
+    b->contacts++;
+    return err;
+}
+
+// "N:Family;Given;Middle;;" -> "Given Family", only used without an FN
+static void name_from_n(char *dst, size_t size, const char *value)
+{
+    const char *given = strchr(value, ';');
+    size_t family_len = given ? (size_t)(given - value) : strlen(value);
+    if (!given) {
+        copy_text(dst, size, value);
+        return;
+    }
+    given++;
+    size_t given_len = strcspn(given, ";");
+    snprintf(dst, size, "%.*s%s%.*s", (int)given_len, given,
+             given_len && family_len ? " " : "", (int)family_len, value);
+}
+
+// ";ENCODING=QUOTED-PRINTABLE", or vCard 2.1's bare ";QUOTED-PRINTABLE",
+// among the parameters before the first ':'
+static bool is_quoted_printable(const char *line)
+{
+    const char *colon = strchr(line, ':');
+    for (const char *p = strchr(line, ';'); p && (!colon || p < colon); p = strchr(p, ';')) {
+        p++;
+        size_t len = strcspn(p, ";:");
+        if ((len == 25 && strncasecmp(p, "ENCODING=QUOTED-PRINTABLE", len) == 0) ||
+            (len == 16 && strncasecmp(p, "QUOTED-PRINTABLE", len) == 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// "=C3=89" -> "\xC3\x89" in place
+static void qp_decode(char *text)
+{
+    char *out = text;
+    for (const char *in = text; *in; in++) {
+        if (in[0] == '=' && isxdigit((unsigned char)in[1]) && isxdigit((unsigned char)in[2])) {
+            char hex[3] = { in[1], in[2], '\0' };
+            *out++ = (char)strtol(hex, NULL, 16);
+            in += 2;
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+}
+
+static void append_text(char *dst, size_t size, size_t *len, const char *src)
+{
+    size_t n = strlen(src);
+    if (n > size - 1 - *len) n = size - 1 - *len;
+    memcpy(dst + *len, src, n);
+    *len += n;
+    dst[*len] = '\0';
+}
+
+// Next logical property line into b->line. Joins lines folded with a
+// leading space or tab, and quoted-printable soft line breaks (a trailing
+// '='), which Android and iOS both use for non-ASCII names.
+static bool read_property(pb_builder_t *b, FILE *f)
+{
+    if (!b->have_next && !fgets(b->next, sizeof(b->next), f)) {
+        return false;
+    }
+    b->have_next = false;
+    b->next[strcspn(b->next, "\r\n")] = '\0';
+    size_t len = 0;
+    b->line[0] = '\0';
+    append_text(b->line, sizeof(b->line), &len, b->next);
+    bool qp = is_quoted_printable(b->line);
+
+    while (fgets(b->next, sizeof(b->next), f)) {
+        b->next[strcspn(b->next, "\r\n")] = '\0';
+        if (qp && len && b->line[len - 1] == '=') {
+            b->line[--len] = '\0';
+            append_text(b->line, sizeof(b->line), &len, b->next);
+        } else if (b->next[0] == ' ' || b->next[0] == '\t') {
+            append_text(b->line, sizeof(b->line), &len, b->next + 1);
+        } else {
+            b->have_next = true;
+            break;
+        }
+    }
+    return true;
+}
+
+// One unfolded vCard property line
+static esp_err_t parse_line(pb_builder_t *b)
+{
+    char *line = b->line;
+    char *value = strchr(line, ':');
+    if (!value) return ESP_OK;
+    *value++ = '\0';
+    if (is_quoted_printable(line)) {
+        qp_decode(value);
+    }
+    line[strcspn(line, ";")] = '\0';        // Drop parameters
+    char *dot = strchr(line, '.');          // Drop "item1." groups
+    const char *prop = dot ? dot + 1 : line;
+
+    if (strcasecmp(prop, "BEGIN") == 0) {
+        memset(&b->contact, 0, sizeof(b->contact));
+        b->number_count = 0;
+        b->has_fn = false;
+    } else if (strcasecmp(prop, "FN") == 0 && value[0]) {
+        copy_text(b->contact.name, sizeof(b->contact.name), value);
+        b->has_fn = true;
+    } else if (strcasecmp(prop, "N") == 0 && !b->has_fn) {
+        name_from_n(b->contact.name, sizeof(b->contact.name), value);
+    } else if (strcasecmp(prop, "TEL") == 0 && b->number_count < PHONEBOOK_NUMBERS_PER_CONTACT) {
+        uint64_t number = phonebook_normalize_number(value);
+        if (number) {
+            if (b->number_count == 0) {
+                copy_text(b->contact.number, sizeof(b->contact.number), value);
+            }
+            b->numbers[b->number_count++] = number;
+        }
+    } else if (strcasecmp(prop, "END") == 0) {
+        return stage_contact(b);
+    }
+    return ESP_OK;
+}
+
+// qsort has no context argument; the builder runs in one task at a time
+static int compare_staged_contacts(const void *a, const void *b)
+{
+    uint16_t ia = *(const uint16_t *)a, ib = *(const uint16_t *)b;
+    char na[PHONEBOOK_NAME_LEN], nb[PHONEBOOK_NAME_LEN];
+    esp_partition_read(g_partition, PB_STAGE_RECORDS_OFFSET + ia * sizeof(phonebook_contact_t),
+                       na, sizeof(na));
+    esp_partition_read(g_partition, PB_STAGE_RECORDS_OFFSET + ib * sizeof(phonebook_contact_t),
+                       nb, sizeof(nb));
+    na[sizeof(na) - 1] = nb[sizeof(nb) - 1] = '\0';
+
+    int ca = phonebook_letter_class(na), cb = phonebook_letter_class(nb);
+    if (ca != cb) return ca - cb;
+    int r = strcasecmp(na, nb);
+    return r ? r : (int)ia - (int)ib;
+}
+
+static int compare_staged_numbers(const void *a, const void *b)
+{
+    uint16_t ia = *(const uint16_t *)a, ib = *(const uint16_t *)b;
+    uint64_t na, nb;
+    esp_partition_read(g_partition, PB_STAGE_NUMBERS_OFFSET + ia * sizeof(pb_number_t),
+                       &na, sizeof(na));
+    esp_partition_read(g_partition, PB_STAGE_NUMBERS_OFFSET + ib * sizeof(pb_number_t),
+                       &nb, sizeof(nb));
+    if (na != nb) return na < nb ? -1 : 1;
+    return (int)ia - (int)ib;
+}
+
+// Copy staged records out in name order; fills rank[] (staged -> sorted)
+// and the letter table
+static esp_err_t write_sorted_contacts(pb_header_t *hdr, uint16_t *order, uint16_t *rank)
+{
+    uint32_t count = hdr->contact_count;
+    for (uint32_t i = 0; i < count; i++) order[i] = (uint16_t)i;
+    qsort(order, count, sizeof(order[0]), compare_staged_contacts);
+
+    uint8_t next_letter = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        phonebook_contact_t c;
+        esp_err_t err = esp_partition_read(g_partition,
+                                           PB_STAGE_RECORDS_OFFSET + order[i] * sizeof(c),
+                                           &c, sizeof(c));
+        if (err == ESP_OK) {
+            err = esp_partition_write(g_partition, PB_RECORDS_OFFSET + i * sizeof(c), &c, sizeof(c));
+        }
+        if (err != ESP_OK) return err;
+
+        rank[order[i]] = (uint16_t)i;
+        uint8_t letter = phonebook_letter_class(c.name);
+        while (next_letter <= letter) hdr->letter_first[next_letter++] = (uint16_t)i;
+    }
+    while (next_letter <= PHONEBOOK_LETTER_OTHER) hdr->letter_first[next_letter++] = (uint16_t)count;
+    return ESP_OK;
+}
+
+static esp_err_t write_sorted_numbers(pb_header_t *hdr, uint32_t staged,
+                                      uint16_t *order, const uint16_t *rank)
+{
+    for (uint32_t i = 0; i < staged; i++) order[i] = (uint16_t)i;
+    qsort(order, staged, sizeof(order[0]), compare_staged_numbers);
+
+    pb_number_t prev = {0};
+    hdr->number_count = 0;
+    for (uint32_t i = 0; i < staged; i++) {
+        pb_number_t entry;
+        esp_err_t err = esp_partition_read(g_partition,
+                                           PB_STAGE_NUMBERS_OFFSET + order[i] * sizeof(entry),
+                                           &entry, sizeof(entry));
+        if (err != ESP_OK) return err;
+        entry.contact = rank[entry.contact];
+        // Same number listed twice on one contact (e.g. CELL and PREF)
+        if (hdr->number_count && entry.number == prev.number && entry.contact == prev.contact) {
+            continue;
+        }
+        err = esp_partition_write(g_partition,
+                                  PB_NUMBERS_OFFSET + hdr->number_count * sizeof(entry),
+                                  &entry, sizeof(entry));
+        if (err != ESP_OK) return err;
+        prev = entry;
+        hdr->number_count++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t phonebook_store_build_from_vcard(const char *path)
+{
+    if (!g_partition) return ESP_ERR_INVALID_STATE;
+
+    struct stat st;
+    FILE *f = fopen(path, "r");
+    if (!f || stat(path, &st) != 0) {
+        if (f) fclose(f);
+        ESP_LOGW(TAG, "Cannot open %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_LOGI(TAG, "Building phonebook store from %s (%ld bytes)", path, (long)st.st_size);
+
+    // Readers see an empty store until the new one is complete
+    xSemaphoreTake(g_pb_lock, portMAX_DELAY);
+    store_unmap();
+    xSemaphoreGive(g_pb_lock);
+
+    pb_builder_t *b = calloc(1, sizeof(*b));
+    uint16_t *order = malloc(PHONEBOOK_MAX_NUMBERS * sizeof(uint16_t));
+    uint16_t *rank = malloc(PHONEBOOK_MAX_CONTACTS * sizeof(uint16_t));
+    esp_err_t err = (b && order && rank) ? ESP_OK : ESP_ERR_NO_MEM;
+
+    if (err == ESP_OK) {
+        err = esp_partition_erase_range(g_partition, 0, PB_PARTITION_SIZE);
+    }
+    while (err == ESP_OK && read_property(b, f)) {
+        err = parse_line(b);
+    }
+
+    pb_header_t hdr = {
+        .magic = PB_MAGIC,
+        .version = PB_VERSION,
+        .source_size = (uint32_t)st.st_size,
+        .source_mtime = (uint32_t)st.st_mtime,
+    };
+    if (err == ESP_OK) {
+        hdr.contact_count = b->contacts;
+        err = write_sorted_contacts(&hdr, order, rank);
+    }
+    if (err == ESP_OK) {
+        err = write_sorted_numbers(&hdr, b->staged_numbers, order, rank);
+    }
+    if (err == ESP_OK) {
+        // Header last: an interrupted build leaves no valid store behind
+        hdr.crc = header_crc(&hdr);
+        err = esp_partition_write(g_partition, 0, &hdr, sizeof(hdr));
+    }
+
+    fclose(f);
+    free(b);
+    free(order);
+    free(rank);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Phonebook build failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    xSemaphoreTake(g_pb_lock, portMAX_DELAY);
+    store_map();
+    xSemaphoreGive(g_pb_lock);
+    return ESP_OK;
+}
+
+static bool store_is_stale(const struct stat *st)
+{
+    xSemaphoreTake(g_pb_lock, portMAX_DELAY);
+    bool stale = !g_map || g_header.source_size != (uint32_t)st->st_size ||
+                 g_header.source_mtime != (uint32_t)st->st_mtime;
+    xSemaphoreGive(g_pb_lock);
+    return stale;
+}
+
+// Rebuild whenever the PBAP dump no longer matches the store: at boot, and
+// after each connect once the download has stopped growing. The PBAP
+// client reports no completion, so a dump that kept its size and mtime
+// over one poll interval counts as complete.
+static void phonebook_build_task(void *arg)
+{
+    const char *path = CONFIG_CAR_STEREO_PHONEBOOK_VCARD_PATH;
+    struct stat st;
+    if (stat(path, &st) == 0 && store_is_stale(&st)) {
+        phonebook_store_build_from_vcard(path);
+    }
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        struct stat last = {0};
+        bool seen = false;
+        for (uint32_t waited = 0; waited < PB_SYNC_WINDOW_MS; waited += PB_SYNC_POLL_MS) {
+            if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PB_SYNC_POLL_MS))) {
+                waited = 0;     // Another connect: its download starts the window over
+            }
+            if (stat(path, &st) != 0) {
+                seen = false;
+                continue;
+            }
+            if (seen && st.st_size == last.st_size && st.st_mtime == last.st_mtime &&
+                store_is_stale(&st)) {
+                phonebook_store_build_from_vcard(path);
+            }
+            last = st;
+            seen = true;
+        }
+    }
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+esp_err_t phonebook_store_init(void)
+{
+    g_pb_lock = xSemaphoreCreateMutex();
+    if (!g_pb_lock) {
+        ESP_LOGE(TAG, "Failed to create phonebook lock");
+        return ESP_ERR_NO_MEM;
+    }
+
+    g_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                           PHONEBOOK_PARTITION_LABEL);
+    if (!g_partition) {
+        ESP_LOGW(TAG, "No '%s' partition, phonebook disabled", PHONEBOOK_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (g_partition->size < PB_PARTITION_SIZE) {
+        ESP_LOGE(TAG, "Phonebook partition too small (%lu < %u bytes)",
+                 (unsigned long)g_partition->size, (unsigned)PB_PARTITION_SIZE);
+        g_partition = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(g_pb_lock, portMAX_DELAY);
+    store_map();
+    xSemaphoreGive(g_pb_lock);
+
+    g_build_task = xTaskCreateStaticPinnedToCore(phonebook_build_task, "pb_build",
+                                                 TASK_PB_BUILD_STACK, NULL, TASK_PB_BUILD_PRIO,
+                                                 g_build_stack, &g_build_tcb, TASK_PB_BUILD_CORE);
+    if (!g_build_task) {
+        ESP_LOGE(TAG, "Failed to create phonebook build task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void phonebook_store_watch_sync(void)
+{
+    if (g_build_task) {
+        xTaskNotifyGive(g_build_task);
+    }
+}
+
+size_t phonebook_store_count(void)
+{
+    return g_map ? g_header.contact_count : 0;
+}
+
+bool phonebook_store_get(size_t idx, phonebook_contact_t *out)
+{
+    if (!g_pb_lock) return false;
+
+    xSemaphoreTake(g_pb_lock, portMAX_DELAY);
+    bool ok = g_map && idx < g_header.contact_count;
+    if (ok) {
+        memcpy(out, g_map + PB_RECORDS_OFFSET + idx * sizeof(*out), sizeof(*out));
+        out->name[sizeof(out->name) - 1] = '\0';
+        out->number[sizeof(out->number) - 1] = '\0';
+    }
+    xSemaphoreGive(g_pb_lock);
+    return ok;
+}
+
+size_t phonebook_store_letter_first(uint8_t letter)
+{
+    if (!g_pb_lock) return 0;
+    if (letter > PHONEBOOK_LETTER_OTHER) letter = PHONEBOOK_LETTER_OTHER;
+
+    xSemaphoreTake(g_pb_lock, portMAX_DELAY);
+    size_t idx = g_map ? g_header.letter_first[letter] : 0;
+    xSemaphoreGive(g_pb_lock);
+    return idx;
+}
+
+// Lower-bound binary search over the mapped number index. Called with
+// g_pb_lock held.
+static bool find_number(uint64_t number, phonebook_contact_t *out)
+{
+    if (!g_map) return false;
+
+    const pb_number_t *numbers = (const pb_number_t *)(g_map + PB_NUMBERS_OFFSET);
+    uint32_t lo = 0, hi = g_header.number_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (numbers[mid].number < number) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == g_header.number_count || numbers[lo].number != number ||
+        numbers[lo].contact >= g_header.contact_count) {
+        return false;
+    }
+    memcpy(out, g_map + PB_RECORDS_OFFSET + numbers[lo].contact * sizeof(*out), sizeof(*out));
+    out->name[sizeof(out->name) - 1] = '\0';
+    out->number[sizeof(out->number) - 1] = '\0';
+    return true;
+}
+
+bool phonebook_store_find_number(const char *number, phonebook_contact_t *out)
+{
+    uint64_t key = phonebook_normalize_number(number);
+    if (!key || !g_pb_lock) return false;
+
+    xSemaphoreTake(g_pb_lock, portMAX_DELAY);
+    bool found = find_number(key, out);
+    xSemaphoreGive(g_pb_lock);
+    return found;
+}
+
+bool phonebook_store_caller_name(const char *number, char *name, size_t size)
+{
+    uint64_t key = phonebook_normalize_number(number);
+    if (!key || !g_pb_lock) return false;
+
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(g_pb_lock, portMAX_DELAY);
+
+    caller_cache_entry_t *entry = NULL;
+    caller_cache_entry_t *victim = &g_caller_cache[0];
+    for (int i = 0; i < CALLER_CACHE_SIZE; i++) {
+        if (g_caller_cache[i].number == key) {
+            entry = &g_caller_cache[i];
+            break;
+        }
+        if (g_caller_cache[i].last_used < victim->last_used) {
+            victim = &g_caller_cache[i];
+        }
+    }
+    if (!entry) {
+        phonebook_contact_t contact;
+        entry = victim;
+        entry->number = key;
+        entry->found = find_number(key, &contact);
+        copy_text(entry->name, sizeof(entry->name), entry->found ? contact.name : "");
+    }
+    entry->last_used = ++g_caller_clock;
+
+    bool found = entry->found;
+    if (found) {
+        copy_text(name, size, entry->name);
+    }
+    xSemaphoreGive(g_pb_lock);
+
+    ESP_LOGD(TAG, "Caller %s: %s (%d us)", number, found ? name : "not in phonebook",
+             (int)(esp_timer_get_time() - start));
+    return found;
+}
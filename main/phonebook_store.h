@@ -0,0 +1,111 @@
+#ifndef PHONEBOOK_STORE_H
+#define PHONEBOOK_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PHONEBOOK_PARTITION_LABEL   "phonebook"
+#define PHONEBOOK_MAX_CONTACTS      2048
+#define PHONEBOOK_MAX_NUMBERS       4096
+#define PHONEBOOK_NAME_LEN          40
+#define PHONEBOOK_NUMBER_LEN        24
+#define PHONEBOOK_NUMBERS_PER_CONTACT 4
+#define PHONEBOOK_LETTER_OTHER      26      // Names not starting with A-Z
+
+/**
+ * @brief One contact record, as stored in the partition
+ */
+typedef struct {
+    char name[PHONEBOOK_NAME_LEN];      // Display name, UTF-8 as received
+    char number[PHONEBOOK_NUMBER_LEN];  // First number, as received
+} phonebook_contact_t;
+
+/**
+ * @brief Map the phonebook partition and check it against the PBAP dump
+ * The store lives in a data partition labelled "phonebook" (at least
+ * 0x61000 bytes). Contacts are fixed-size records sorted by name, with a
+ * first-letter offset table and a sorted table of normalized numbers. It is
+ * read through a flash mapping, so browsing needs no heap whatever the
+ * phonebook size. If the vCard dump is newer than the store, a rebuild is
+ * started in the background.
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND without a partition
+ */
+esp_err_t phonebook_store_init(void);
+
+/**
+ * @brief Watch the vCard dump for a PBAP download
+ * Call when a phone connects. For the next few minutes the dump is
+ * re-checked every few seconds, and once it has stopped changing and no
+ * longer matches the store, the store is rebuilt in the background.
+ */
+void phonebook_store_watch_sync(void);
+
+/**
+ * @brief Rebuild the store from a PBAP vCard dump (blocking, seconds)
+ * @param path vCard file, e.g. the PBAP download on SPIFFS
+ * @return ESP_OK on success
+ */
+esp_err_t phonebook_store_build_from_vcard(const char *path);
+
+/**
+ * @brief Number of contacts in the store (0 while a rebuild runs)
+ */
+size_t phonebook_store_count(void);
+
+/**
+ * @brief Read one contact by its position in name order
+ * @return false if idx is out of range
+ */
+bool phonebook_store_get(size_t idx, phonebook_contact_t *out);
+
+/**
+ * @brief Letter class of a contact name: 0-25 for A-Z, else PHONEBOOK_LETTER_OTHER
+ */
+uint8_t phonebook_letter_class(const char *name);
+
+/**
+ * @brief First contact whose name is in letter class `letter` or later
+ * @param letter 0-25 for A-Z, PHONEBOOK_LETTER_OTHER for the rest
+ * @return Contact index (== count if nothing follows)
+ */
+size_t phonebook_store_letter_first(uint8_t letter);
+
+/**
+ * @brief Find the contact owning a phone number
+ * Binary search over the number index, so a few thousand contacts cost a
+ * dozen mapped reads.
+ * @param number Number in any format phonebook_normalize_number() accepts
+ * @return false if no contact has this number
+ */
+bool phonebook_store_find_number(const char *number, phonebook_contact_t *out);
+
+/**
+ * @brief Resolve a caller ID to a contact name, through a recent-callers cache
+ * Misses are cached too, so repeated CLIPs of an unknown number are cheap.
+ * The cache is dropped whenever the store is rebuilt.
+ * @param number Caller ID as received from HFP
+ * @param name Receives the contact name if found
+ * @param size Size of name
+ * @return false if the number is not in the phonebook
+ */
+bool phonebook_store_caller_name(const char *number, char *name, size_t size);
+
+/**
+ * @brief Normalize a phone number to its international digits
+ * "+31 6 1234 5678", "0031612345678" and "06-12345678" all give
+ * 31612345678 with CONFIG_CAR_STEREO_COUNTRY_CODE 31.
+ * @return Number as an integer, 0 if it has no digits
+ */
+uint64_t phonebook_normalize_number(const char *number);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHONEBOOK_STORE_H
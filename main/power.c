@@ -0,0 +1,119 @@
+/*
+ * Standby Power Management
+ * Backlight, input polling and automatic light sleep while MODE_OFF
+ */
+
+#include "power.h"
+#include "buttons.h"
+#include "display.h"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+#define TAG "POWER"
+
+static bool g_standby = false;
+static int64_t g_standby_since = 0;
+static uint32_t g_standby_count = 0;
+static uint64_t g_standby_us = 0;       // Completed standby periods
+static volatile uint64_t g_sleep_us = 0;
+static volatile uint32_t g_wakeups = 0;
+
+#if CONFIG_PM_ENABLE
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+// Runs on the idle task with interrupts off, right after each light sleep
+static esp_err_t IRAM_ATTR on_light_sleep_exit(int64_t sleep_time_us, void *arg)
+{
+    g_sleep_us += sleep_time_us;
+    g_wakeups++;
+    return ESP_OK;
+}
+#endif
+
+static void pm_apply(bool light_sleep)
+{
+    esp_pm_config_t pm = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = light_sleep ? CONFIG_XTAL_FREQ : CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .light_sleep_enable = light_sleep,
+    };
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Power management config failed: %s", esp_err_to_name(err));
+    }
+}
+
+#endif // CONFIG_PM_ENABLE
+
+esp_err_t power_init(void)
+{
+    // buttons_set_standby() puts the rotary switch on a level wake interrupt
+    esp_err_t err = esp_sleep_enable_gpio_wakeup();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO wakeup enable failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+#if CONFIG_PM_ENABLE
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t cbs = {
+        .exit_cb = on_light_sleep_exit,
+    };
+    err = esp_pm_light_sleep_register_cbs(&cbs);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Light sleep callbacks unavailable: %s", esp_err_to_name(err));
+    }
+#endif
+    pm_apply(false);
+#else
+    ESP_LOGW(TAG, "CONFIG_PM_ENABLE is off, standby will not light sleep");
+#endif
+    return ESP_OK;
+}
+
+void power_set_standby(bool standby)
+{
+    if (standby == g_standby) return;
+    g_standby = standby;
+
+    int64_t now = esp_timer_get_time();
+    if (standby) {
+        g_standby_since = now;
+        g_standby_count++;
+        display_set_backlight(false);
+        buttons_set_standby(true);
+#if CONFIG_PM_ENABLE
+        pm_apply(true);
+#endif
+    } else {
+#if CONFIG_PM_ENABLE
+        pm_apply(false);
+#endif
+        buttons_set_standby(false);
+        display_set_backlight(true);
+
+        int64_t took = now - g_standby_since;
+        g_standby_us += took;
+        ESP_LOGI(TAG, "Standby for %d s, %u wakeups so far", (int)(took / 1000000),
+                 (unsigned)g_wakeups);
+    }
+}
+
+void power_get_stats(power_stats_t *stats)
+{
+    uint64_t standby_us = g_standby_us;
+    if (g_standby) {
+        standby_us += esp_timer_get_time() - g_standby_since;
+    }
+    stats->standby = g_standby;
+    stats->standby_count = g_standby_count;
+    stats->standby_ms = (uint32_t)(standby_us / 1000);
+    stats->sleep_ms = (uint32_t)(g_sleep_us / 1000);
+    stats->wakeups = g_wakeups;
+}
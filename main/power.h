@@ -0,0 +1,55 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Standby counters since boot
+ */
+typedef struct {
+    bool standby;               // Currently in standby
+    uint32_t standby_count;     // Times standby was entered
+    uint32_t standby_ms;        // Total time spent in standby
+    uint32_t sleep_ms;          // Of which in automatic light sleep
+    uint32_t wakeups;           // Light sleep exits (any wake source)
+} power_stats_t;
+
+/**
+ * @brief Arm the standby wake sources
+ * Call once after buttons_init(). Light sleep needs CONFIG_PM_ENABLE and
+ * CONFIG_FREERTOS_USE_TICKLESS_IDLE; with Classic BT enabled the controller
+ * only lets the chip sleep when its low-power clock is an external 32 kHz
+ * crystal, otherwise standby stays at modem sleep.
+ * @return ESP_OK on success
+ */
+esp_err_t power_init(void);
+
+/**
+ * @brief Enter or leave standby
+ * Standby turns the LCD backlight off, stops the button polling and lets
+ * the CPU drop into automatic light sleep between BT activity. The rotary
+ * switch wakes it. Bluetooth stays connectable throughout.
+ * Used as stereo_config_t.on_standby.
+ * @param standby true to enter standby
+ */
+void power_set_standby(bool standby);
+
+/**
+ * @brief Snapshot the standby counters
+ * Sleep residency is what standby current follows: the board has no
+ * current sensor, so sleep_ms / standby_ms is the figure to watch.
+ * @param stats Receives the counters
+ */
+void power_get_stats(power_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POWER_H
@@ -0,0 +1,77 @@
+/*
+ * Audio Source Manager
+ * Which source is audible, and the crossfade between them at the I2S mixer
+ */
+
+#include "source.h"
+#include "deferred_log.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define TAG "SOURCE"
+
+#define SOURCE_SAMPLE_RATE  44100
+#define SOURCE_FADE_MS      40          // Short enough to feel instant, long enough not to click
+#define SOURCE_GAIN_ONE     32768       // Q15 unity
+#define SOURCE_FADE_STEP    (SOURCE_GAIN_ONE / (SOURCE_SAMPLE_RATE * SOURCE_FADE_MS / 1000))
+
+static const char *const g_source_names[AUDIO_SOURCE_COUNT] = {
+    [AUDIO_SOURCE_NONE]      = "none",
+    [AUDIO_SOURCE_RADIO]     = "radio",
+    [AUDIO_SOURCE_BLUETOOTH] = "bluetooth",
+    [AUDIO_SOURCE_PHONE]     = "phone",
+};
+
+static volatile audio_source_t g_selected = AUDIO_SOURCE_NONE;
+static int32_t g_gain[AUDIO_SOURCE_COUNT];  // Q15, each written by its own source's task
+static int64_t g_selected_at = 0;           // esp_timer us of the last switch
+static bool g_pending = false;              // New source not heard yet
+static source_stats_t g_stats;
+
+void source_select(audio_source_t source)
+{
+    if (source >= AUDIO_SOURCE_COUNT || source == g_selected) return;
+
+    DLOGI(TAG, "Source %s -> %s", g_source_names[g_selected], g_source_names[source]);
+    g_stats.switches++;
+    g_selected_at = esp_timer_get_time();
+    __atomic_store_n(&g_pending, source != AUDIO_SOURCE_NONE, __ATOMIC_RELEASE);
+    g_selected = source;
+}
+
+void source_mix(audio_source_t source, int16_t *pcm, size_t frames)
+{
+    if (source == AUDIO_SOURCE_NONE || source >= AUDIO_SOURCE_COUNT) return;
+
+    int32_t gain = g_gain[source];
+    int32_t target = g_selected == source ? SOURCE_GAIN_ONE : 0;
+
+    if (gain == target) {
+        if (gain == 0) memset(pcm, 0, frames * 2 * sizeof(int16_t));
+    } else {
+        int32_t step = target > gain ? SOURCE_FADE_STEP : -SOURCE_FADE_STEP;
+        for (size_t i = 0; i < frames; i++) {
+            if (gain != target) {
+                gain += step;
+                if ((step > 0 && gain > target) || (step < 0 && gain < target)) gain = target;
+            }
+            pcm[2 * i] = (int16_t)((pcm[2 * i] * gain) >> 15);
+            pcm[2 * i + 1] = (int16_t)((pcm[2 * i + 1] * gain) >> 15);
+        }
+        g_gain[source] = gain;
+    }
+
+    if (target && __atomic_exchange_n(&g_pending, false, __ATOMIC_ACQUIRE)) {
+        uint32_t ms = (uint32_t)((esp_timer_get_time() - g_selected_at) / 1000);
+        g_stats.audible_ms_last = ms;
+        if (ms > g_stats.audible_ms_max) g_stats.audible_ms_max = ms;
+        ESP_LOGD(TAG, "%s audible %lu ms after switch", g_source_names[source], (unsigned long)ms);
+    }
+}
+
+void source_get_stats(source_stats_t *stats)
+{
+    *stats = g_stats;
+}
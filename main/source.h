@@ -0,0 +1,58 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    AUDIO_SOURCE_NONE,
+    AUDIO_SOURCE_RADIO,
+    AUDIO_SOURCE_BLUETOOTH,
+    AUDIO_SOURCE_PHONE,
+    AUDIO_SOURCE_COUNT
+} audio_source_t;
+
+/**
+ * @brief Source switch timing since boot
+ */
+typedef struct {
+    uint32_t switches;          // source_select() calls that changed source
+    uint32_t audible_ms_last;   // Select -> first non-silent block of the new source
+    uint32_t audible_ms_max;
+} source_stats_t;
+
+/**
+ * @brief Make a source the audible one
+ * Starts a crossfade: the old source ramps down while the new one ramps
+ * up over a few tens of milliseconds. Never blocks; call from the state
+ * task. AUDIO_SOURCE_NONE fades everything out.
+ * @param source Source to hear
+ */
+void source_select(audio_source_t source);
+
+/**
+ * @brief Apply a source's crossfade gain to its PCM in place
+ * Each source's PCM producer calls this on every block before the block
+ * reaches the I2S mixer; a source that is faded out comes out silent.
+ * One task per source.
+ * @param source Source the block belongs to
+ * @param pcm Interleaved 16-bit stereo samples
+ * @param frames Number of stereo frames
+ */
+void source_mix(audio_source_t source, int16_t *pcm, size_t frames);
+
+/**
+ * @brief Snapshot the switch timing
+ * @param stats Receives the counters
+ */
+void source_get_stats(source_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOURCE_H
@@ -0,0 +1,737 @@
+/*
+ * Station Index
+ * Background FM + DAB band scan and the persisted list of known stations
+ * that browse, seek and presets work from
+ */
+
+#include "station_index.h"
+#include "task_map.h"
+#include "trace.h"
+#include "sdkconfig.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "STATION_INDEX"
+#define NVS_NAMESPACE "car_stereo"
+
+// NVS Keys
+#define NVS_KEY_STATIONS_META   "st_meta"       // station_meta_blob_t
+#define NVS_KEY_STATIONS_FM     "st_fm"         // FM entries
+#define NVS_KEY_STATIONS_DAB    "st_dab%02u"    // One blob per DAB ensemble
+
+#define STATIONS_BLOB_VERSION   1
+
+#define SCAN_BIT_FULL   (1u << 0)
+#define SCAN_BIT_WAKE   (1u << 1)   // Background policy changed
+#define SCAN_BIT_POWER  (1u << 2)   // Power-down requested
+#define SCAN_BIT_PARK   (1u << 3)   // Put the tuner back on g_parked
+#define REFRESH_STEP_MS 10000       // Pause between single-ensemble refreshes
+
+// DAB Band III channel raster, 5A .. 13F (ETSI EN 300 401)
+static const uint32_t g_dab_band3_khz[] = {
+    174928, 176640, 178352, 180064,         // 5A-5D
+    181936, 183648, 185360, 187072,         // 6A-6D
+    188928, 190640, 192352, 194064,         // 7A-7D
+    195936, 197648, 199360, 201072,         // 8A-8D
+    202928, 204640, 206352, 208064,         // 9A-9D
+    209936, 210096, 211648, 213360, 215072, // 10A, 10N, 10B-10D
+    216928, 217088, 218640, 220352, 222064, // 11A, 11N, 11B-11D
+    223936, 224096, 225648, 227360, 229072, // 12A, 12N, 12B-12D
+    230784, 232496, 234208, 235776, 237488, 239200, // 13A-13F
+};
+#define DAB_ENSEMBLE_COUNT (sizeof(g_dab_band3_khz) / sizeof(g_dab_band3_khz[0]))
+
+_Static_assert(sizeof(station_entry_t) == 32, "station_entry_t is stored in flash as is");
+_Static_assert(DAB_ENSEMBLE_COUNT <= 64, "ensemble dirty mask is 64 bits");
+
+// Entry blobs are a header, `count` entries and a CRC over both
+typedef struct {
+    uint8_t version;
+    uint8_t count;
+    uint8_t reserved[2];
+} station_blob_hdr_t;
+
+typedef struct {
+    uint8_t version;
+    uint8_t reserved[3];
+    uint32_t ensembles[2];      // Bitmask of ensembles with a blob
+    uint32_t crc;
+} station_meta_blob_t;
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static station_entry_t g_stations[STATION_INDEX_MAX];
+static size_t g_station_count = 0;
+static SemaphoreHandle_t g_stations_lock = NULL;
+
+static bool g_fm_dirty = false;
+static uint64_t g_dab_dirty = 0;            // Ensembles whose blob is stale
+static uint64_t g_stored_ensembles = 0;     // Ensembles the meta blob lists
+static bool g_meta_stored = false;
+
+// Scan results are built here and only replace the index once complete
+static station_entry_t g_scan[STATION_INDEX_MAX];
+static size_t g_scan_count = 0;
+
+static uint8_t g_blob_buf[sizeof(station_blob_hdr_t) +
+                          STATION_INDEX_MAX * sizeof(station_entry_t) + sizeof(uint32_t)];
+
+static const radio_tuner_ops_t *g_ops = NULL;
+static void *g_tuner_handle = NULL;
+static station_scan_done_cb_t g_on_scan_done = NULL;
+static TaskHandle_t g_scan_task = NULL;
+static StackType_t g_scan_stack[TASK_SCAN_STACK];
+static StaticTask_t g_scan_tcb;
+static SemaphoreHandle_t g_tuner_lock = NULL;  // One tuner user at a time
+static volatile bool g_scanning = false;
+static volatile bool g_background = false;      // Refresh allowed (tuner not audible)
+static volatile bool g_power_wanted = true;     // False in standby
+static bool g_tuner_powered = true;             // Actual tuner power, under g_tuner_lock
+static uint8_t g_refresh_next = 0;              // Round-robin ensemble cursor
+static station_entry_t g_parked;                // Last station tuned for listening
+static bool g_park_valid = false;
+static bool g_on_park = false;                  // Tuner is on g_parked now, under g_tuner_lock
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static void lock(void)
+{
+    xSemaphoreTake(g_stations_lock, portMAX_DELAY);
+}
+
+static void unlock(void)
+{
+    xSemaphoreGive(g_stations_lock);
+}
+
+// FM entries are a prefix of the table
+static size_t fm_count(void)
+{
+    size_t n = 0;
+    while (n < g_station_count && g_stations[n].kind == STATION_KIND_FM) n++;
+    return n;
+}
+
+// Contiguous run of services belonging to one ensemble
+static size_t ensemble_range(uint8_t ensemble, size_t *first)
+{
+    size_t i = fm_count();
+    while (i < g_station_count && g_stations[i].ensemble < ensemble) i++;
+    *first = i;
+    while (i < g_station_count && g_stations[i].ensemble == ensemble) i++;
+    return i - *first;
+}
+
+static uint64_t present_ensembles(void)
+{
+    uint64_t mask = 0;
+    for (size_t i = fm_count(); i < g_station_count; i++) {
+        mask |= 1ULL << g_stations[i].ensemble;
+    }
+    return mask;
+}
+
+// Fixed-width PS/labels come space padded
+static void copy_name(char *dst, const char *src)
+{
+    strncpy(dst, src, STATION_NAME_LEN - 1);
+    dst[STATION_NAME_LEN - 1] = '\0';
+    size_t len = strlen(dst);
+    while (len > 0 && dst[len - 1] == ' ') dst[--len] = '\0';
+}
+
+// ============================================================================
+// NVS PERSISTENCE
+// ============================================================================
+
+static esp_err_t write_entries(nvs_handle_t nvs_handle, const char *key,
+                               const station_entry_t *entries, size_t count)
+{
+    station_blob_hdr_t hdr = { .version = STATIONS_BLOB_VERSION, .count = (uint8_t)count };
+    size_t len = sizeof(hdr) + count * sizeof(station_entry_t);
+    memcpy(g_blob_buf, &hdr, sizeof(hdr));
+    memcpy(g_blob_buf + sizeof(hdr), entries, count * sizeof(station_entry_t));
+    uint32_t crc = esp_rom_crc32_le(0, g_blob_buf, len);
+    memcpy(g_blob_buf + len, &crc, sizeof(crc));
+    return nvs_set_blob(nvs_handle, key, g_blob_buf, len + sizeof(crc));
+}
+
+// Returns the number of entries read into out (0 on any error)
+static size_t read_entries(nvs_handle_t nvs_handle, const char *key,
+                           station_entry_t *out, size_t max)
+{
+    size_t len = sizeof(g_blob_buf);
+    if (nvs_get_blob(nvs_handle, key, g_blob_buf, &len) != ESP_OK) {
+        return 0;
+    }
+    station_blob_hdr_t hdr;
+    memcpy(&hdr, g_blob_buf, sizeof(hdr));
+    size_t body = sizeof(hdr) + hdr.count * sizeof(station_entry_t);
+    if (hdr.version != STATIONS_BLOB_VERSION || len != body + sizeof(uint32_t)) {
+        ESP_LOGW(TAG, "Blob '%s' has unknown layout (len %u, v%u)",
+                 key, (unsigned)len, hdr.version);
+        return 0;
+    }
+    uint32_t crc;
+    memcpy(&crc, g_blob_buf + body, sizeof(crc));
+    if (crc != esp_rom_crc32_le(0, g_blob_buf, body)) {
+        ESP_LOGW(TAG, "Blob '%s' failed CRC check", key);
+        return 0;
+    }
+    if (hdr.count > max) {
+        ESP_LOGW(TAG, "Blob '%s' does not fit the index, truncated", key);
+        hdr.count = (uint8_t)max;
+    }
+    memcpy(out, g_blob_buf + sizeof(hdr), hdr.count * sizeof(station_entry_t));
+    return hdr.count;
+}
+
+static void load_stations(void)
+{
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+
+    station_meta_blob_t meta;
+    size_t len = sizeof(meta);
+    if (nvs_get_blob(nvs_handle, NVS_KEY_STATIONS_META, &meta, &len) != ESP_OK ||
+        len != sizeof(meta) || meta.version != STATIONS_BLOB_VERSION ||
+        meta.crc != esp_rom_crc32_le(0, (const uint8_t *)&meta, sizeof(meta) - sizeof(meta.crc))) {
+        nvs_close(nvs_handle);
+        return;
+    }
+    g_stored_ensembles = ((uint64_t)meta.ensembles[1] << 32) | meta.ensembles[0];
+    g_meta_stored = true;
+
+    g_station_count = read_entries(nvs_handle, NVS_KEY_STATIONS_FM,
+                                   g_stations, STATION_INDEX_MAX);
+    for (uint8_t e = 0; e < DAB_ENSEMBLE_COUNT; e++) {
+        if (!(g_stored_ensembles & (1ULL << e))) continue;
+        char key[16];
+        snprintf(key, sizeof(key), NVS_KEY_STATIONS_DAB, e);
+        g_station_count += read_entries(nvs_handle, key, g_stations + g_station_count,
+                                        STATION_INDEX_MAX - g_station_count);
+    }
+    nvs_close(nvs_handle);
+}
+
+esp_err_t station_index_flush(void)
+{
+    if (!g_stations_lock) return ESP_ERR_INVALID_STATE;
+
+    lock();
+    uint64_t present = present_ensembles();
+    bool meta_stale = !g_meta_stored || present != g_stored_ensembles;
+    if (!g_fm_dirty && !g_dab_dirty && !meta_stale) {
+        unlock();
+        return ESP_OK;
+    }
+
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        unlock();
+        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    uint32_t t0 = trace_now();
+
+    if (g_fm_dirty) {
+        err = write_entries(nvs_handle, NVS_KEY_STATIONS_FM, g_stations, fm_count());
+    }
+    for (uint8_t e = 0; e < DAB_ENSEMBLE_COUNT && err == ESP_OK; e++) {
+        if (!(g_dab_dirty & (1ULL << e))) continue;
+        char key[16];
+        snprintf(key, sizeof(key), NVS_KEY_STATIONS_DAB, e);
+        size_t first;
+        size_t n = ensemble_range(e, &first);
+        if (n) {
+            err = write_entries(nvs_handle, key, g_stations + first, n);
+        } else if (g_stored_ensembles & (1ULL << e)) {
+            err = nvs_erase_key(nvs_handle, key);
+            if (err == ESP_ERR_NVS_NOT_FOUND) err = ESP_OK;
+        }
+    }
+    if (err == ESP_OK && meta_stale) {
+        station_meta_blob_t meta = {
+            .version = STATIONS_BLOB_VERSION,
+            .ensembles = { (uint32_t)present, (uint32_t)(present >> 32) },
+        };
+        meta.crc = esp_rom_crc32_le(0, (const uint8_t *)&meta, sizeof(meta) - sizeof(meta.crc));
+        err = nvs_set_blob(nvs_handle, NVS_KEY_STATIONS_META, &meta, sizeof(meta));
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+    trace_record(TRACE_NVS_COMMIT, t0);
+
+    if (err == ESP_OK) {
+        g_fm_dirty = false;
+        g_dab_dirty = 0;
+        g_stored_ensembles = present;
+        g_meta_stored = true;
+        ESP_LOGD(TAG, "Station index saved (%u stations)", (unsigned)g_station_count);
+    } else {
+        ESP_LOGE(TAG, "Saving station index failed: %s", esp_err_to_name(err));
+    }
+    unlock();
+    return err;
+}
+
+// ============================================================================
+// TUNING
+// ============================================================================
+
+// Caller holds g_tuner_lock
+static esp_err_t tune_locked(const station_entry_t *entry)
+{
+    if (entry->kind == STATION_KIND_DAB) {
+        if (!g_ops->tune_dab) return ESP_ERR_NOT_SUPPORTED;
+        return g_ops->tune_dab(g_tuner_handle, entry->freq_khz,
+                               entry->service_id, entry->component_id);
+    }
+    if (!g_ops->tune_fm) return ESP_ERR_NOT_SUPPORTED;
+    return g_ops->tune_fm(g_tuner_handle, entry->freq_khz);
+}
+
+static bool same_tune(const station_entry_t *a, const station_entry_t *b)
+{
+    if (a->kind != b->kind || a->freq_khz != b->freq_khz) return false;
+    return a->kind != STATION_KIND_DAB ||
+           (a->service_id == b->service_id && a->component_id == b->component_id);
+}
+
+// Scans leave the tuner on whatever they probed last. Going back to the
+// last station straight away keeps it locked and decoding, so a switch
+// back to radio is audible at once instead of after a DAB acquisition.
+// Caller holds g_tuner_lock.
+static void repark_locked(void)
+{
+    g_on_park = false;
+    if (!g_park_valid || !g_tuner_powered) return;
+    esp_err_t err = tune_locked(&g_parked);
+    g_on_park = err == ESP_OK;
+    if (err != ESP_OK) {
+        ESP_LOGD(TAG, "Repark failed: %s", esp_err_to_name(err));
+    }
+}
+
+// ============================================================================
+// BAND SCAN
+// ============================================================================
+
+static void scan_add(const station_entry_t *entry)
+{
+    if (g_scan_count >= STATION_INDEX_MAX) {
+        ESP_LOGW(TAG, "Station index full, dropping %s", entry->name);
+        return;
+    }
+    g_scan[g_scan_count++] = *entry;
+}
+
+static void scan_fm(void)
+{
+    for (uint32_t freq = STATION_FM_MIN_KHZ; freq <= STATION_FM_MAX_KHZ; freq += STATION_FM_STEP_KHZ) {
+        uint8_t rssi = 0;
+        int8_t snr = 0;
+        bool valid = false;
+        if (g_ops->fm_probe(g_tuner_handle, freq, &rssi, &snr, &valid) != ESP_OK || !valid) {
+            continue;
+        }
+
+        // A strong transmitter also shows up one channel over; keep the stronger
+        if (g_scan_count > 0) {
+            station_entry_t *prev = &g_scan[g_scan_count - 1];
+            if (prev->freq_khz + STATION_FM_STEP_KHZ == freq) {
+                if (rssi <= prev->rssi) continue;
+                g_scan_count--;
+            }
+        }
+
+        station_entry_t entry = {
+            .freq_khz = freq,
+            .kind = STATION_KIND_FM,
+            .rssi = rssi,
+            .snr = snr,
+        };
+        char ps[STATION_NAME_LEN] = {0};
+        if (g_ops->fm_read_ps && g_ops->fm_read_ps(g_tuner_handle, ps, sizeof(ps)) == ESP_OK) {
+            copy_name(entry.name, ps);
+        }
+        scan_add(&entry);
+        ESP_LOGD(TAG, "FM %lu kHz: %u dBuV, %d dB '%s'",
+                 (unsigned long)freq, rssi, snr, entry.name);
+    }
+}
+
+static void scan_dab_add(const station_entry_t *service, void *ctx)
+{
+    uint8_t ensemble = *(const uint8_t *)ctx;
+    station_entry_t entry = *service;
+    entry.kind = STATION_KIND_DAB;
+    entry.ensemble = ensemble;
+    entry.freq_khz = g_dab_band3_khz[ensemble];
+    copy_name(entry.name, service->name);
+    scan_add(&entry);
+}
+
+static int compare_service(const void *a, const void *b)
+{
+    const station_entry_t *x = a, *y = b;
+    if (x->service_id != y->service_id) return x->service_id < y->service_id ? -1 : 1;
+    return (int)x->component_id - (int)y->component_id;
+}
+
+static void scan_dab(void)
+{
+    if (!g_ops->dab_scan_ensemble) return;
+
+    for (uint8_t e = 0; e < DAB_ENSEMBLE_COUNT; e++) {
+        size_t first = g_scan_count;
+        if (g_ops->dab_scan_ensemble(g_tuner_handle, g_dab_band3_khz[e],
+                                     scan_dab_add, &e) != ESP_OK) {
+            g_scan_count = first;
+            continue;
+        }
+        qsort(g_scan + first, g_scan_count - first, sizeof(station_entry_t), compare_service);
+        if (g_scan_count > first) {
+            ESP_LOGI(TAG, "DAB ensemble %u: %u services", e, (unsigned)(g_scan_count - first));
+        }
+    }
+}
+
+static void run_full_scan(void)
+{
+    int64_t start = esp_timer_get_time();
+    ESP_LOGI(TAG, "Band scan started");
+
+    xSemaphoreTake(g_tuner_lock, portMAX_DELAY);
+    g_scan_count = 0;
+    scan_fm();
+    size_t fm = g_scan_count;
+    scan_dab();
+    repark_locked();
+    xSemaphoreGive(g_tuner_lock);
+
+    lock();
+    memcpy(g_stations, g_scan, g_scan_count * sizeof(station_entry_t));
+    g_station_count = g_scan_count;
+    g_fm_dirty = true;
+    g_dab_dirty = present_ensembles() | g_stored_ensembles;
+    unlock();
+    station_index_flush();
+
+    ESP_LOGI(TAG, "Band scan done in %d ms: %u FM, %u DAB",
+             (int)((esp_timer_get_time() - start) / 1000),
+             (unsigned)fm, (unsigned)(g_scan_count - fm));
+    g_scanning = false;
+    if (g_on_scan_done) {
+        g_on_scan_done(g_scan_count);
+    }
+}
+
+// ============================================================================
+// BACKGROUND REFRESH
+// ============================================================================
+
+static bool same_service(const station_entry_t *a, const station_entry_t *b)
+{
+    return a->service_id == b->service_id &&
+           a->component_id == b->component_id &&
+           strcmp(a->name, b->name) == 0;
+}
+
+// Replace one ensemble's services with a fresh list. Signal quality is
+// refreshed in RAM only; flash is touched only if the service list changed.
+static void merge_ensemble(uint8_t ensemble, const station_entry_t *services, size_t count)
+{
+    lock();
+    size_t first;
+    size_t old = ensemble_range(ensemble, &first);
+
+    bool changed = old != count;
+    for (size_t i = 0; i < count && !changed; i++) {
+        changed = !same_service(&g_stations[first + i], &services[i]);
+    }
+    if (!changed) {
+        for (size_t i = 0; i < count; i++) {
+            g_stations[first + i].rssi = services[i].rssi;
+            g_stations[first + i].snr = services[i].snr;
+        }
+        unlock();
+        return;
+    }
+
+    size_t room = STATION_INDEX_MAX - (g_station_count - old);
+    if (count > room) {
+        ESP_LOGW(TAG, "Station index full, ensemble %u truncated", ensemble);
+        count = room;
+    }
+    memmove(&g_stations[first + count], &g_stations[first + old],
+            (g_station_count - first - old) * sizeof(station_entry_t));
+    memcpy(&g_stations[first], services, count * sizeof(station_entry_t));
+    g_station_count = g_station_count - old + count;
+    g_dab_dirty |= 1ULL << ensemble;
+    unlock();
+
+    ESP_LOGI(TAG, "DAB ensemble %u: %u -> %u services", ensemble, (unsigned)old, (unsigned)count);
+    station_index_flush();
+}
+
+// Rescan the next ensemble of the round robin and fold it into the index
+static void refresh_next_ensemble(void)
+{
+    if (!g_ops->dab_scan_ensemble) return;
+
+    uint8_t e = g_refresh_next;
+    g_refresh_next = (uint8_t)((e + 1) % DAB_ENSEMBLE_COUNT);
+
+    xSemaphoreTake(g_tuner_lock, portMAX_DELAY);
+    g_scan_count = 0;
+    esp_err_t err = g_ops->dab_scan_ensemble(g_tuner_handle, g_dab_band3_khz[e],
+                                             scan_dab_add, &e);
+    repark_locked();
+    xSemaphoreGive(g_tuner_lock);
+
+    // A tuner error says nothing about the ensemble; keep what we had
+    if (err != ESP_OK) {
+        ESP_LOGD(TAG, "Refresh of ensemble %u failed: %s", e, esp_err_to_name(err));
+        return;
+    }
+    qsort(g_scan, g_scan_count, sizeof(station_entry_t), compare_service);
+    merge_ensemble(e, g_scan, g_scan_count);
+}
+
+// Bring the tuner power in line with g_power_wanted
+static void apply_power(void)
+{
+    xSemaphoreTake(g_tuner_lock, portMAX_DELAY);
+    bool want = g_power_wanted;
+    if (want != g_tuner_powered) {
+        esp_err_t err = g_ops->set_power(g_tuner_handle, want);
+        if (err == ESP_OK) {
+            g_tuner_powered = want;
+            g_on_park = false;
+            ESP_LOGI(TAG, "Tuner powered %s", want ? "up" : "down");
+        } else {
+            ESP_LOGW(TAG, "Tuner power %s failed: %s", want ? "up" : "down",
+                     esp_err_to_name(err));
+        }
+    }
+    xSemaphoreGive(g_tuner_lock);
+}
+
+static void station_scan_task(void *arg)
+{
+    while (1) {
+        uint32_t bits = 0;
+        bool refresh = g_background && g_power_wanted;
+        TickType_t wait = refresh ? pdMS_TO_TICKS(REFRESH_STEP_MS) : portMAX_DELAY;
+        BaseType_t notified = xTaskNotifyWait(0, UINT32_MAX, &bits, wait);
+        if (bits & SCAN_BIT_FULL) {
+            run_full_scan();
+        } else if (!notified && refresh) {
+            refresh_next_ensemble();
+        }
+        // After a scan that was already running, so it is not cut short
+        if (bits & SCAN_BIT_POWER) {
+            apply_power();
+        }
+        if (bits & SCAN_BIT_PARK) {
+            xSemaphoreTake(g_tuner_lock, portMAX_DELAY);
+            if (!g_on_park) repark_locked();
+            xSemaphoreGive(g_tuner_lock);
+        }
+    }
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+esp_err_t station_index_init(const radio_tuner_ops_t *ops, void *handle,
+                             station_scan_done_cb_t on_scan_done)
+{
+    g_stations_lock = xSemaphoreCreateMutex();
+    g_tuner_lock = xSemaphoreCreateMutex();
+    if (!g_stations_lock || !g_tuner_lock) {
+        ESP_LOGE(TAG, "Failed to create station index lock");
+        return ESP_ERR_NO_MEM;
+    }
+
+    g_ops = ops;
+    g_tuner_handle = handle;
+    g_on_scan_done = on_scan_done;
+
+    load_stations();
+    ESP_LOGI(TAG, "Loaded %u stations (%u FM)",
+             (unsigned)g_station_count, (unsigned)fm_count());
+
+    if (!g_ops || !g_ops->fm_probe) {
+        ESP_LOGW(TAG, "No tuner driver, band scan disabled");
+        g_ops = NULL;
+        return ESP_OK;
+    }
+#if CONFIG_IDF_TARGET_LINUX
+    // Host build: the linux FreeRTOS port has a single core to pin to
+    g_scan_task = xTaskCreateStatic(station_scan_task, "station_scan", TASK_SCAN_STACK, NULL,
+                                    TASK_SCAN_PRIO, g_scan_stack, &g_scan_tcb);
+#else
+    g_scan_task = xTaskCreateStaticPinnedToCore(station_scan_task, "station_scan",
+                                                TASK_SCAN_STACK, NULL, TASK_SCAN_PRIO,
+                                                g_scan_stack, &g_scan_tcb, TASK_SCAN_CORE);
+#endif
+    if (!g_scan_task) {
+        ESP_LOGE(TAG, "Failed to create scan task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t station_index_scan_start(void)
+{
+    if (!g_scan_task || g_scanning || !g_power_wanted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_scanning = true;
+    xTaskNotify(g_scan_task, SCAN_BIT_FULL, eSetBits);
+    return ESP_OK;
+}
+
+bool station_index_scan_busy(void)
+{
+    return g_scanning;
+}
+
+void station_index_set_background(bool allowed)
+{
+    if (g_background == allowed) return;
+    g_background = allowed;
+    if (g_scan_task) {
+        xTaskNotify(g_scan_task, SCAN_BIT_WAKE, eSetBits);
+    }
+}
+
+void station_index_set_power(bool on)
+{
+    if (!g_ops || !g_ops->set_power || g_power_wanted == on) return;
+    g_power_wanted = on;
+    if (on && g_scanning) {
+        // The scan holds the tuner, which stayed powered for it (power-down
+        // waits for the scan); the scan task reconciles once it is done
+        xTaskNotify(g_scan_task, SCAN_BIT_POWER | SCAN_BIT_PARK, eSetBits);
+    } else if (on) {
+        apply_power();      // Synchronous: a tune usually follows
+        // If none does (not in radio mode), warm up on the last station
+        xTaskNotify(g_scan_task, SCAN_BIT_PARK, eSetBits);
+    } else {
+        xTaskNotify(g_scan_task, SCAN_BIT_POWER, eSetBits);
+    }
+}
+
+size_t station_index_count(void)
+{
+    return g_station_count;
+}
+
+bool station_index_get(size_t idx, station_entry_t *out)
+{
+    lock();
+    bool ok = idx < g_station_count;
+    if (ok) *out = g_stations[idx];
+    unlock();
+    return ok;
+}
+
+int station_index_find_fm(uint32_t freq_khz)
+{
+    lock();
+    int found = -1;
+    size_t n = fm_count();
+    for (size_t i = 0; i < n && g_stations[i].freq_khz <= freq_khz; i++) {
+        if (g_stations[i].freq_khz == freq_khz) found = (int)i;
+    }
+    unlock();
+    return found;
+}
+
+int station_index_seek_fm(uint32_t freq_khz, int dir)
+{
+    lock();
+    int n = (int)fm_count();
+    int found = -1;
+    if (n > 0) {
+        int i = 0;
+        while (i < n && g_stations[i].freq_khz <= freq_khz) i++;
+        // i is now the first station above freq_khz
+        if (dir > 0) {
+            found = i < n ? i : 0;
+        } else {
+            int below = i - 1;
+            if (below >= 0 && g_stations[below].freq_khz == freq_khz) below--;
+            found = below >= 0 ? below : n - 1;
+        }
+    }
+    unlock();
+    return found;
+}
+
+// Waits out a background refresh of one ensemble, never a full scan
+esp_err_t station_index_tune_entry(const station_entry_t *entry)
+{
+    if (!g_ops || g_scanning) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = ESP_OK;
+    xSemaphoreTake(g_tuner_lock, portMAX_DELAY);
+    if (!g_on_park || !same_tune(entry, &g_parked)) {
+        g_parked = *entry;
+        g_park_valid = true;
+        err = tune_locked(entry);
+        g_on_park = err == ESP_OK;
+    }
+    xSemaphoreGive(g_tuner_lock);
+    return err;
+}
+
+esp_err_t station_index_tune_fm(uint32_t freq_khz)
+{
+    station_entry_t entry = { .freq_khz = freq_khz, .kind = STATION_KIND_FM };
+    return station_index_tune_entry(&entry);
+}
+
+void station_index_set_fm_name(uint32_t freq_khz, const char *name)
+{
+    if (!g_stations_lock || !name) return;
+
+    char clean[STATION_NAME_LEN];
+    copy_name(clean, name);
+    if (!clean[0]) return;
+
+    lock();
+    size_t n = fm_count();
+    for (size_t i = 0; i < n; i++) {
+        if (g_stations[i].freq_khz == freq_khz) {
+            if (strcmp(g_stations[i].name, clean) != 0) {
+                memcpy(g_stations[i].name, clean, sizeof(clean));
+                g_fm_dirty = true;
+            }
+            break;
+        }
+    }
+    unlock();
+}
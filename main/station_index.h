@@ -0,0 +1,168 @@
+#ifndef STATION_INDEX_H
+#define STATION_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STATION_INDEX_MAX       96      // FM stations + DAB services
+#define STATION_NAME_LEN        18      // DAB label (16) + NUL, PS fits too
+#define STATION_FM_MIN_KHZ      87500
+#define STATION_FM_MAX_KHZ      108000
+#define STATION_FM_STEP_KHZ     100
+
+typedef enum {
+    STATION_KIND_FM = 0,
+    STATION_KIND_DAB = 1
+} station_kind_t;
+
+/**
+ * @brief One known station, as stored in flash
+ * FM entries come first sorted by frequency, then DAB services sorted by
+ * ensemble and service ID.
+ */
+typedef struct {
+    uint32_t freq_khz;          // FM frequency, or DAB ensemble frequency
+    uint32_t service_id;        // DAB service ID; RDS PI for FM (0 = unknown)
+    uint16_t component_id;      // DAB service component
+    uint8_t kind;               // station_kind_t
+    uint8_t ensemble;           // DAB Band III channel index (5A = 0)
+    uint8_t rssi;               // dBuV at scan time
+    int8_t snr;                 // dB at scan time
+    char name[STATION_NAME_LEN];    // RDS PS or DAB service label ("" = unknown)
+} station_entry_t;
+
+typedef void (*station_add_fn_t)(const station_entry_t *service, void *ctx);
+
+/**
+ * @brief Tuner operations used by the scanner
+ * Implemented on top of the SI4684 driver. Every call is synchronous and
+ * may take tens of milliseconds. Calls are serialized: the scan task holds
+ * the tuner for a full scan or one ensemble refresh at a time.
+ */
+typedef struct {
+    // Tune FM to freq_khz and report signal quality once the tuner settles.
+    // valid is the tuner's own station-valid decision (RSSI/SNR/offset).
+    esp_err_t (*fm_probe)(void *handle, uint32_t freq_khz,
+                          uint8_t *rssi, int8_t *snr, bool *valid);
+    // Fetch the RDS PS of the station currently tuned (optional, "" if none yet)
+    esp_err_t (*fm_read_ps)(void *handle, char *ps, size_t size);
+    // Tune a DAB ensemble and report each service of its list through add().
+    // Fills freq_khz-independent fields only (service/component/label/quality).
+    esp_err_t (*dab_scan_ensemble)(void *handle, uint32_t freq_khz,
+                                   station_add_fn_t add, void *ctx);
+    esp_err_t (*tune_fm)(void *handle, uint32_t freq_khz);
+    esp_err_t (*tune_dab)(void *handle, uint32_t freq_khz,
+                          uint32_t service_id, uint16_t component_id);
+    // Power the tuner up (reload firmware, restore the last tune) or down (optional)
+    esp_err_t (*set_power)(void *handle, bool on);
+} radio_tuner_ops_t;
+
+/**
+ * @brief Called from the scan task when a full scan has finished
+ * @param count Number of stations in the new index
+ */
+typedef void (*station_scan_done_cb_t)(size_t count);
+
+/**
+ * @brief Load the station index from NVS and start the scan task
+ * @param ops Tuner operations (NULL disables scanning and tuning)
+ * @param handle Passed through to every tuner call
+ * @param on_scan_done Scan completion callback (optional)
+ * @return ESP_OK on success
+ */
+esp_err_t station_index_init(const radio_tuner_ops_t *ops, void *handle,
+                             station_scan_done_cb_t on_scan_done);
+
+/**
+ * @brief Queue a full FM + DAB band scan in the background
+ * The current index stays usable until the scan completes and replaces it.
+ * @return ESP_ERR_INVALID_STATE if no tuner is configured or a scan is running
+ */
+esp_err_t station_index_scan_start(void);
+
+/**
+ * @brief True while a scan owns the tuner
+ */
+bool station_index_scan_busy(void);
+
+/**
+ * @brief Allow the background service-list refresh
+ * While allowed (the tuner is not what the user is listening to), the scan
+ * task rescans one DAB ensemble every few seconds and writes back only the
+ * ensembles whose service list changed. Each refresh ends with the tuner
+ * back on the last station tuned, so it stays warm for a switch to radio.
+ * @param allowed True in Bluetooth mode
+ */
+void station_index_set_background(bool allowed);
+
+/**
+ * @brief Power the tuner up or down for standby
+ * Powering down waits for a running scan to finish and stops the
+ * background refresh; powering up returns once the tuner is ready to tune
+ * and puts it back on the last station in the background. Neither blocks
+ * on a running scan: the tuner stays powered for it and the scan task
+ * applies the last request when the scan is done.
+ * No-op if the tuner driver has no power control.
+ */
+void station_index_set_power(bool on);
+
+/**
+ * @brief Number of stations in the index
+ */
+size_t station_index_count(void);
+
+/**
+ * @brief Copy one entry of the index
+ * @return false if idx is out of range
+ */
+bool station_index_get(size_t idx, station_entry_t *out);
+
+/**
+ * @brief Find the indexed FM station at freq_khz
+ * @return Index, or -1 if the frequency is not a known station
+ */
+int station_index_find_fm(uint32_t freq_khz);
+
+/**
+ * @brief Next known FM station above (dir > 0) or below (dir < 0) freq_khz
+ * Wraps around the band.
+ * @return Index, or -1 if there are no FM stations
+ */
+int station_index_seek_fm(uint32_t freq_khz, int dir);
+
+/**
+ * @brief Tune the tuner to a station
+ * Returns at once if the tuner is still on it (nothing retuned it since).
+ * @param entry Station as returned by station_index_get()
+ * @return ESP_ERR_INVALID_STATE while scanning or without a tuner
+ */
+esp_err_t station_index_tune_entry(const station_entry_t *entry);
+
+/**
+ * @brief Tune an FM frequency that need not be in the index
+ * @return ESP_ERR_INVALID_STATE while scanning or without a tuner
+ */
+esp_err_t station_index_tune_fm(uint32_t freq_khz);
+
+/**
+ * @brief Record an RDS PS learnt while listening to an FM station
+ * Only updates RAM; station_index_flush() writes it out.
+ */
+void station_index_set_fm_name(uint32_t freq_khz, const char *name);
+
+/**
+ * @brief Write changed parts of the index to NVS
+ */
+esp_err_t station_index_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STATION_INDEX_H
@@ -0,0 +1,50 @@
+#ifndef TASK_MAP_H
+#define TASK_MAP_H
+
+// Where every stereo task runs. Core 0 belongs to the BT controller,
+// Bluedroid and the A2DP decode/I2S path; everything the user interacts
+// with runs on core 1, so a redraw or an NVS commit never delays audio.
+//
+// Long-lived tasks are created static (xTaskCreateStaticPinnedToCore) so
+// their stacks and TCBs do not come out of, or fragment, the heap. Tasks
+// that run once at boot stay dynamic: their stacks go back to the heap.
+//
+// Stacks are in bytes. Each is the task's worst-case frame (see the size
+// comments) plus ~1 KB for ESP_LOGx/vsnprintf and ISR nesting; check with
+// uxTaskGetStackHighWaterMark() before lowering one.
+
+#define STEREO_CORE_BT          0
+#define STEREO_CORE_UI          1
+
+// Input: rotary ISR queue, ADC ladder, long-press deadlines (buttons.c)
+#define TASK_INPUT_CORE         STEREO_CORE_UI
+#define TASK_INPUT_PRIO         6       // Above state: sheds ISR bursts first
+#define TASK_INPUT_STACK        3072    // Callback builds a state event
+
+// State machine (car_stereo_state.c): ~200-byte events and notifications
+#define TASK_STATE_CORE         STEREO_CORE_UI
+#define TASK_STATE_PRIO         5
+#define TASK_STATE_STACK        4096
+
+// Display (display.c): notification + 2x40 frame copy on the stack
+#define TASK_DISPLAY_CORE       STEREO_CORE_UI
+#define TASK_DISPLAY_PRIO       4
+#define TASK_DISPLAY_STACK      3072
+
+// Band scan / background DAB refresh (station_index.c)
+#define TASK_SCAN_CORE          STEREO_CORE_UI
+#define TASK_SCAN_PRIO          2       // A scan is never urgent
+#define TASK_SCAN_STACK         3072
+
+// Phonebook store rebuild after PBAP syncs (phonebook_store.c). The vCard
+// parser state is on the heap; the stack covers stdio and qsort recursion
+#define TASK_PB_BUILD_CORE      STEREO_CORE_UI
+#define TASK_PB_BUILD_PRIO      2
+#define TASK_PB_BUILD_STACK     4096
+
+// One-shot boot tasks (dynamic)
+#define TASK_BT_INIT_CORE       STEREO_CORE_BT
+#define TASK_BT_INIT_PRIO       5
+#define TASK_BT_INIT_STACK      4096
+
+#endif // TASK_MAP_H
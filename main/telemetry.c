@@ -0,0 +1,164 @@
+/*
+ * Runtime Telemetry
+ * Periodic health report from the idle main loop
+ */
+
+#include "telemetry.h"
+#include "sdkconfig.h"
+#include "buttons.h"
+#include "car_stereo_state.h"
+#include "display.h"
+#include "power.h"
+#include "source.h"
+#include "audio_dsp.h"
+#include "deferred_log.h"
+#include "trace.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+
+#define TAG "TELEMETRY"
+
+#define TELEMETRY_MAX_TASKS     32      // IDF and BT system tasks plus ours, with room to spare
+#define TELEMETRY_LINE_LEN      100     // Stack lines are wrapped at this width
+
+// ============================================================================
+// TASKS
+// ============================================================================
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+static TaskStatus_t g_tasks[TELEMETRY_MAX_TASKS];
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+static uint32_t g_last_total = 0;
+static uint32_t g_last_idle[portNUM_PROCESSORS];
+
+static void report_cpu(UBaseType_t count, uint32_t total)
+{
+    // Busy share of each core = 1 - its idle task's share of the interval.
+    // Run time counters are 32-bit esp_timer microseconds: the unsigned
+    // differences stay right across a wrap as long as reports come more
+    // often than every ~71 minutes.
+    uint32_t elapsed = total - g_last_total;
+    unsigned load[portNUM_PROCESSORS] = { 0 };
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        TaskHandle_t idle = xTaskGetIdleTaskHandleForCore(core);
+        for (UBaseType_t i = 0; i < count; i++) {
+            if (g_tasks[i].xHandle != idle) continue;
+            uint32_t idle_run = g_tasks[i].ulRunTimeCounter - g_last_idle[core];
+            if (elapsed && idle_run <= elapsed) {
+                load[core] = 100 - (unsigned)((uint64_t)idle_run * 100 / elapsed);
+            }
+            g_last_idle[core] = g_tasks[i].ulRunTimeCounter;
+            break;
+        }
+    }
+    g_last_total = total;
+
+#if portNUM_PROCESSORS > 1
+    ESP_LOGI(TAG, "CPU load: core0 %u%%, core1 %u%% over %lu ms",
+             load[0], load[1], (unsigned long)(elapsed / 1000));
+#else
+    ESP_LOGI(TAG, "CPU load: %u%% over %lu ms", load[0], (unsigned long)(elapsed / 1000));
+#endif
+}
+#endif
+
+static void report_tasks(void)
+{
+    uint32_t total = 0;
+    UBaseType_t count = uxTaskGetSystemState(g_tasks, TELEMETRY_MAX_TASKS, &total);
+    if (count == 0) {
+        ESP_LOGW(TAG, "More than %d tasks, no task table", TELEMETRY_MAX_TASKS);
+        return;
+    }
+
+    // High-water marks are in bytes on ESP-IDF (StackType_t is uint8_t)
+    char line[TELEMETRY_LINE_LEN];
+    int len = 0;
+    for (UBaseType_t i = 0; i < count; i++) {
+        char item[32];
+        int n = snprintf(item, sizeof(item), "%s %u",
+                         g_tasks[i].pcTaskName, (unsigned)g_tasks[i].usStackHighWaterMark);
+        if (len && len + 2 + n >= (int)sizeof(line)) {
+            ESP_LOGI(TAG, "Stack free: %s", line);
+            len = 0;
+        }
+        len += snprintf(line + len, sizeof(line) - len, "%s%s", len ? ", " : "", item);
+    }
+    if (len) {
+        ESP_LOGI(TAG, "Stack free: %s", line);
+    }
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    report_cpu(count, total);
+#endif
+}
+#endif
+
+// ============================================================================
+// REPORT
+// ============================================================================
+
+void telemetry_report(void)
+{
+    ESP_LOGI(TAG, "Heap: free %u, min %lu, largest block %u",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+             (unsigned long)esp_get_minimum_free_heap_size(),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    report_tasks();
+#endif
+
+    buttons_stats_t input;
+    stereo_state_stats_t state;
+    display_stats_t display;
+    buttons_get_stats(&input);
+    stereo_state_get_stats(&state);
+    display_get_stats(&display);
+
+    ESP_LOGI(TAG, "Queues max: input %u, state %u, display %u (%lu dropped)",
+             input.queue_depth_max, state.queue_depth_max, display.queue_depth_max,
+             (unsigned long)display.queue_dropped);
+    ESP_LOGI(TAG, "NVS commits %lu, I2C %lu bytes, %lu redraws (last %u, max %u bytes)",
+             (unsigned long)state.nvs_commits, (unsigned long)display.i2c_bytes,
+             (unsigned long)display.redraws, display.redraw_bytes_last, display.redraw_bytes_max);
+
+    dlog_stats_t dlog;
+    dlog_get_stats(&dlog);
+    if (dlog.dropped) {
+        ESP_LOGI(TAG, "Deferred log: %lu lines, %lu dropped, max %u waiting",
+                 (unsigned long)dlog.written, (unsigned long)dlog.dropped, dlog.depth_max);
+    }
+
+    power_stats_t power;
+    power_get_stats(&power);
+    if (power.standby && power.standby_ms > 0) {
+        ESP_LOGI(TAG, "Standby: light sleep %u%% of %u s (%u wakeups)",
+                 (unsigned)((uint64_t)power.sleep_ms * 100 / power.standby_ms),
+                 (unsigned)(power.standby_ms / 1000), (unsigned)power.wakeups);
+    }
+    source_stats_t source;
+    source_get_stats(&source);
+    if (source.audible_ms_max) {
+        ESP_LOGI(TAG, "Source switches: %u, to audio in %u ms (max %u ms)",
+                 (unsigned)source.switches, (unsigned)source.audible_ms_last,
+                 (unsigned)source.audible_ms_max);
+    }
+#if CONFIG_CAR_STEREO_DSP
+    audio_dsp_stats_t dsp;
+    audio_dsp_get_stats(&dsp);
+    if (dsp.blocks) {
+        ESP_LOGI(TAG, "DSP: %lu blocks, avg %lu us, last %lu us, max %lu us",
+                 (unsigned long)dsp.blocks, (unsigned long)(dsp.block_us_total / dsp.blocks),
+                 (unsigned long)dsp.block_us_last, (unsigned long)dsp.block_us_max);
+    }
+#endif
+
+    trace_dump();
+}
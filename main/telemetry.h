@@ -0,0 +1,28 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_PERIOD_MS     10000   // Main loop report interval
+
+/**
+ * @brief Log one round of runtime health
+ * Heap free and low-water mark, per-task stack headroom, per-core CPU
+ * load since the previous report, queue high-water marks, NVS and I2C
+ * traffic, and the latency traces. Stack lines need
+ * CONFIG_FREERTOS_USE_TRACE_FACILITY, CPU load also
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS; without them those lines are
+ * left out. Call from the main loop only (static scratch, several
+ * hundred microseconds with the task table).
+ */
+void telemetry_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_H
@@ -0,0 +1,124 @@
+/*
+ * Latency Tracing
+ * Per-core lock-free sample rings for the input -> state -> glass path
+ */
+
+#include "trace.h"
+
+#if CONFIG_CAR_STEREO_TRACE
+
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "TRACE"
+
+#define TRACE_RING_LEN      256         // Samples per core, power of two
+#define TRACE_FLUSH_MAX_US  1000000     // Older pending inputs caused no redraw
+#define TRACE_BUCKETS       18          // log2(us): 1 us .. 131 ms and above
+#define TRACE_BAR_WIDTH     32
+
+typedef struct {
+    uint32_t origin;
+    uint32_t at;
+    uint8_t point;
+} trace_sample_t;
+
+typedef struct {
+    trace_sample_t samples[TRACE_RING_LEN];
+    uint32_t head;              // Claimed with an atomic add; ISRs may nest
+} trace_ring_t;
+
+static trace_ring_t g_rings[portNUM_PROCESSORS];
+static uint32_t g_pending_input = 0;    // Origin of the last handled input, 0 = none
+
+static const char *const g_point_names[TRACE_POINT_COUNT] = {
+    [TRACE_INPUT_DEQUEUE]  = "dequeue",
+    [TRACE_STATE_DISPATCH] = "dispatch",
+    [TRACE_DISPLAY_FLUSH]  = "glass",
+    [TRACE_NVS_COMMIT]     = "nvs",
+};
+
+void IRAM_ATTR trace_record(trace_point_t point, uint32_t origin)
+{
+    uint32_t at = trace_now();
+    trace_ring_t *ring = &g_rings[esp_cpu_get_core_id()];
+    uint32_t slot = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED) & (TRACE_RING_LEN - 1);
+    ring->samples[slot] = (trace_sample_t){ .origin = origin, .at = at, .point = (uint8_t)point };
+}
+
+void trace_input_handled(uint32_t origin)
+{
+    __atomic_store_n(&g_pending_input, origin ? origin : 1, __ATOMIC_RELAXED);
+}
+
+void trace_display_flushed(void)
+{
+    uint32_t origin = __atomic_exchange_n(&g_pending_input, 0, __ATOMIC_RELAXED);
+    if (origin && trace_now() - origin < TRACE_FLUSH_MAX_US) {
+        trace_record(TRACE_DISPLAY_FLUSH, origin);
+    }
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint8_t bucket_of(uint32_t us)
+{
+    uint8_t b = 0;
+    while (us > 1 && b < TRACE_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void trace_dump(void)
+{
+    // Only called from one task; too big for its stack
+    static uint32_t latencies[TRACE_RING_LEN * portNUM_PROCESSORS];
+
+    for (int point = 0; point < TRACE_POINT_COUNT; point++) {
+        size_t n = 0;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            const trace_ring_t *ring = &g_rings[core];
+            uint32_t filled = ring->head < TRACE_RING_LEN ? ring->head : TRACE_RING_LEN;
+            for (uint32_t i = 0; i < filled; i++) {
+                if (ring->samples[i].point == point) {
+                    latencies[n++] = ring->samples[i].at - ring->samples[i].origin;
+                }
+            }
+        }
+        if (n == 0) continue;
+
+        qsort(latencies, n, sizeof(latencies[0]), compare_u32);
+        size_t p99 = (n * 99) / 100;
+        if (p99 >= n) p99 = n - 1;
+        ESP_LOGI(TAG, "%-8s n=%3u  p50=%6lu us  p99=%6lu us  max=%6lu us",
+                 g_point_names[point], (unsigned)n, (unsigned long)latencies[n / 2],
+                 (unsigned long)latencies[p99], (unsigned long)latencies[n - 1]);
+
+        uint16_t buckets[TRACE_BUCKETS] = {0};
+        uint16_t peak = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint8_t b = bucket_of(latencies[i]);
+            if (++buckets[b] > peak) peak = buckets[b];
+        }
+        for (int b = 0; b < TRACE_BUCKETS; b++) {
+            if (!buckets[b]) continue;
+            char bar[TRACE_BAR_WIDTH + 1];
+            int len = (buckets[b] * TRACE_BAR_WIDTH + peak - 1) / peak;
+            memset(bar, '#', len);
+            bar[len] = '\0';
+            ESP_LOGI(TAG, "  <%7lu us %4u %s", 2UL << b, buckets[b], bar);
+        }
+    }
+}
+
+#endif // CONFIG_CAR_STEREO_TRACE
@@ -0,0 +1,72 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Latency trace points. Each sample is the time from an origin (normally
+// the input edge or ADC frame behind a button event) to the point.
+typedef enum {
+    TRACE_INPUT_DEQUEUE,    // Edge -> input task has the event
+    TRACE_STATE_DISPATCH,   // Edge -> state task starts handling it
+    TRACE_DISPLAY_FLUSH,    // Edge -> last I2C byte of the redraw it caused
+    TRACE_NVS_COMMIT,       // Start -> end of an NVS write and commit
+    TRACE_POINT_COUNT
+} trace_point_t;
+
+/**
+ * @brief Trace clock in microseconds, usable from ISRs
+ * The CPU cycle counters of the two cores are not synchronized, and
+ * samples routinely cross cores (ISR on one, state task on the other), so
+ * traces use the shared esp_timer clock. Wraps every ~71 minutes; only
+ * differences are meaningful.
+ */
+static inline uint32_t trace_now(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+#if CONFIG_CAR_STEREO_TRACE
+
+/**
+ * @brief Record one sample into the current core's ring (ISR safe, lock-free)
+ * @param point Trace point reached
+ * @param origin trace_now() of the event's origin
+ */
+void trace_record(trace_point_t point, uint32_t origin);
+
+/**
+ * @brief Note that the state task handled an input, so the next display
+ * flush is attributed to it
+ */
+void trace_input_handled(uint32_t origin);
+
+/**
+ * @brief Called by the display after a redraw put bytes on the bus
+ */
+void trace_display_flushed(void);
+
+/**
+ * @brief Log p50/p99/max and a log2 histogram per trace point
+ */
+void trace_dump(void);
+
+#else
+
+static inline void trace_record(trace_point_t point, uint32_t origin) {}
+static inline void trace_input_handled(uint32_t origin) {}
+static inline void trace_display_flushed(void) {}
+static inline void trace_dump(void) {}
+
+#endif // CONFIG_CAR_STEREO_TRACE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_H